@@ -0,0 +1,967 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "assembler.h"
+#include "decoder.h"
+#include "spr.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+
+#define ASM_RC 1	// accepts a trailing '.'
+#define ASM_OE 2	// accepts an 'o' suffix
+
+#define OPCD(p) ((uint32_t)(p) << 26)
+#define XO(p, x) (OPCD(p) | ((uint32_t)(x) << 1))
+#define MDXO(x) (OPCD(30) | ((uint32_t)(x) << 2))
+#define SPR(s) ((((uint32_t)(s) & 0x1f) << 16) | (((uint32_t)(s) >> 5) << 11))
+
+#define F_RT(r) ((uint32_t)(r) << 21)
+#define F_RA(r) ((uint32_t)(r) << 16)
+#define F_RB(r) ((uint32_t)(r) << 11)
+
+#define BO_TRUE 12
+#define BO_FALSE 4
+#define BO_ALWAYS 20
+#define BO_DNZ 16
+#define BO_DZ 18
+
+#define ASM_MAX_OPERANDS 5
+
+enum AsmForm : uint8_t {
+	FORM_NONE,		// fixed word
+	FORM_D_RT_RA_SI,	// addi rt, ra, si
+	FORM_D_RT_SI,		// li rt, si
+	FORM_D_RA_RS_UI,	// ori ra, rs, ui
+	FORM_D_MEM,		// lwz rt, d(ra)
+	FORM_DS_MEM,		// ld rt, ds(ra)
+	FORM_D_CMPI,		// cmpwi [bf,] ra, si
+	FORM_D_CMPLI,		// cmplwi [bf,] ra, ui
+	FORM_D_CMPI_FULL,	// cmpi bf, l, ra, si
+	FORM_D_CMPLI_FULL,	// cmpli bf, l, ra, ui
+	FORM_D_TO_RA_SI,	// twi to, ra, si
+	FORM_I,			// b target
+	FORM_B_FULL,		// bc bo, bi, target
+	FORM_B_COND,		// beq [crN,] target
+	FORM_B_CTR,		// bdnz target
+	FORM_XL_FULL,		// bclr bo, bi
+	FORM_XL_COND,		// beqlr [crN]
+	FORM_XO_RT_RA_RB,	// add rt, ra, rb
+	FORM_X_RA_RS_RB,	// and ra, rs, rb
+	FORM_X_RA_RS,		// cntlzw ra, rs
+	FORM_X_RT_RA_RB,	// lwzx rt, ra, rb
+	FORM_X_RT_RA_NB,	// lswi rt, ra, nb
+	FORM_X_RA_RB,		// dcbt ra, rb
+	FORM_X_RS_RB,		// slbmte rs, rb
+	FORM_X_RB,		// slbie rb
+	FORM_X_RT,		// mfcr rt
+	FORM_X_CMP,		// cmpw [bf,] ra, rb
+	FORM_X_CMP_FULL,	// cmp bf, l, ra, rb
+	FORM_X_TO_RA_RB,	// tw to, ra, rb
+	FORM_XFX_MFSPR,		// mfspr rt, spr
+	FORM_XFX_MTSPR,		// mtspr spr, rs
+	FORM_XFX_RT,		// mflr rt
+	FORM_XFX_RS,		// mtlr rs
+	FORM_M_SH,		// rlwinm ra, rs, sh, mb, me
+	FORM_M_RB,		// rlwnm ra, rs, rb, mb, me
+	FORM_MD_MB,		// rldicl ra, rs, sh, mb
+	FORM_MD_ME,		// rldicr ra, rs, sh, me
+	FORM_MDS_MB,		// rldcl ra, rs, rb, mb
+	FORM_MDS_ME,		// rldcr ra, rs, rb, me
+	/* simplified mnemonics */
+	FORM_P_LA,		// la rt, d(ra)
+	FORM_P_SUBI,		// subi rt, ra, si
+	FORM_P_SUB,		// sub rt, ra, rb
+	FORM_P_MR,		// mr ra, rs
+	FORM_P_SLWI,
+	FORM_P_SRWI,
+	FORM_P_ROTLWI,
+	FORM_P_CLRLWI,
+	FORM_P_SLDI,
+	FORM_P_SRDI,
+	FORM_P_ROTLDI,
+	FORM_P_CLRLDI,
+	FORM_P_CLRRDI,
+};
+
+struct AsmOpcode {
+	const char *name;
+	AsmForm form;
+	uint32_t base;
+	uint8_t flags;
+};
+
+/*
+ * Mirrors the opcodes decode.inc.cpp accepts. Anything added to the
+ * decoder can be added here; the round trip through PpcDecoder catches
+ * entries the decoder does not know.
+ */
+static const AsmOpcode opcodes[] = {
+	{"tdi", FORM_D_TO_RA_SI, OPCD(2), 0},
+	{"twi", FORM_D_TO_RA_SI, OPCD(3), 0},
+	{"mulli", FORM_D_RT_RA_SI, OPCD(7), 0},
+	{"subfic", FORM_D_RT_RA_SI, OPCD(8), 0},
+	{"cmpli", FORM_D_CMPLI_FULL, OPCD(10), 0},
+	{"cmplwi", FORM_D_CMPLI, OPCD(10), 0},
+	{"cmpldi", FORM_D_CMPLI, OPCD(10) | F_RT(1), 0},
+	{"cmpi", FORM_D_CMPI_FULL, OPCD(11), 0},
+	{"cmpwi", FORM_D_CMPI, OPCD(11), 0},
+	{"cmpdi", FORM_D_CMPI, OPCD(11) | F_RT(1), 0},
+	{"addic", FORM_D_RT_RA_SI, OPCD(12), 0},
+	{"addic.", FORM_D_RT_RA_SI, OPCD(13), 0},
+	{"addi", FORM_D_RT_RA_SI, OPCD(14), 0},
+	{"li", FORM_D_RT_SI, OPCD(14), 0},
+	{"la", FORM_P_LA, OPCD(14), 0},
+	{"subi", FORM_P_SUBI, OPCD(14), 0},
+	{"addis", FORM_D_RT_RA_SI, OPCD(15), 0},
+	{"lis", FORM_D_RT_SI, OPCD(15), 0},
+	{"subis", FORM_P_SUBI, OPCD(15), 0},
+	{"bc", FORM_B_FULL, OPCD(16), 0},
+	{"bca", FORM_B_FULL, OPCD(16) | 2, 0},
+	{"bcl", FORM_B_FULL, OPCD(16) | 1, 0},
+	{"bcla", FORM_B_FULL, OPCD(16) | 3, 0},
+	{"bdnz", FORM_B_CTR, OPCD(16) | F_RT(BO_DNZ), 0},
+	{"bdnzl", FORM_B_CTR, OPCD(16) | F_RT(BO_DNZ) | 1, 0},
+	{"bdz", FORM_B_CTR, OPCD(16) | F_RT(BO_DZ), 0},
+	{"bdzl", FORM_B_CTR, OPCD(16) | F_RT(BO_DZ) | 1, 0},
+	{"sc", FORM_NONE, OPCD(17) | 2, 0},
+	{"b", FORM_I, OPCD(18), 0},
+	{"ba", FORM_I, OPCD(18) | 2, 0},
+	{"bl", FORM_I, OPCD(18) | 1, 0},
+	{"bla", FORM_I, OPCD(18) | 3, 0},
+	{"bclr", FORM_XL_FULL, XO(19, 16), 0},
+	{"bclrl", FORM_XL_FULL, XO(19, 16) | 1, 0},
+	{"bcctr", FORM_XL_FULL, XO(19, 528), 0},
+	{"bcctrl", FORM_XL_FULL, XO(19, 528) | 1, 0},
+	{"blr", FORM_NONE, XO(19, 16) | F_RT(BO_ALWAYS), 0},
+	{"blrl", FORM_NONE, XO(19, 16) | F_RT(BO_ALWAYS) | 1, 0},
+	{"bctr", FORM_NONE, XO(19, 528) | F_RT(BO_ALWAYS), 0},
+	{"bctrl", FORM_NONE, XO(19, 528) | F_RT(BO_ALWAYS) | 1, 0},
+	{"bdnzlr", FORM_NONE, XO(19, 16) | F_RT(BO_DNZ), 0},
+	{"bdzlr", FORM_NONE, XO(19, 16) | F_RT(BO_DZ), 0},
+	{"isync", FORM_NONE, XO(19, 150), 0},
+	{"rlwimi", FORM_M_SH, OPCD(20), ASM_RC},
+	{"rlwinm", FORM_M_SH, OPCD(21), ASM_RC},
+	{"slwi", FORM_P_SLWI, OPCD(21), ASM_RC},
+	{"srwi", FORM_P_SRWI, OPCD(21), ASM_RC},
+	{"rotlwi", FORM_P_ROTLWI, OPCD(21), ASM_RC},
+	{"clrlwi", FORM_P_CLRLWI, OPCD(21), ASM_RC},
+	{"rlwnm", FORM_M_RB, OPCD(23), ASM_RC},
+	{"nop", FORM_NONE, OPCD(24), 0},
+	{"ori", FORM_D_RA_RS_UI, OPCD(24), 0},
+	{"oris", FORM_D_RA_RS_UI, OPCD(25), 0},
+	{"xori", FORM_D_RA_RS_UI, OPCD(26), 0},
+	{"xoris", FORM_D_RA_RS_UI, OPCD(27), 0},
+	{"andi.", FORM_D_RA_RS_UI, OPCD(28), 0},
+	{"andis.", FORM_D_RA_RS_UI, OPCD(29), 0},
+	{"rldicl", FORM_MD_MB, MDXO(0), ASM_RC},
+	{"srdi", FORM_P_SRDI, MDXO(0), ASM_RC},
+	{"rotldi", FORM_P_ROTLDI, MDXO(0), ASM_RC},
+	{"clrldi", FORM_P_CLRLDI, MDXO(0), ASM_RC},
+	{"rldicr", FORM_MD_ME, MDXO(1), ASM_RC},
+	{"sldi", FORM_P_SLDI, MDXO(1), ASM_RC},
+	{"clrrdi", FORM_P_CLRRDI, MDXO(1), ASM_RC},
+	{"rldic", FORM_MD_MB, MDXO(2), ASM_RC},
+	{"rldimi", FORM_MD_MB, MDXO(3), ASM_RC},
+	{"rldcl", FORM_MDS_MB, XO(30, 8), ASM_RC},
+	{"rldcr", FORM_MDS_ME, XO(30, 9), ASM_RC},
+	{"cmp", FORM_X_CMP_FULL, XO(31, 0), 0},
+	{"cmpw", FORM_X_CMP, XO(31, 0), 0},
+	{"cmpd", FORM_X_CMP, XO(31, 0) | F_RT(1), 0},
+	{"tw", FORM_X_TO_RA_RB, XO(31, 4), 0},
+	{"trap", FORM_NONE, XO(31, 4) | F_RT(31), 0},
+	{"subfc", FORM_XO_RT_RA_RB, XO(31, 8), ASM_RC | ASM_OE},
+	{"mulhdu", FORM_XO_RT_RA_RB, XO(31, 9), ASM_RC},
+	{"addc", FORM_XO_RT_RA_RB, XO(31, 10), ASM_RC | ASM_OE},
+	{"mulhwu", FORM_XO_RT_RA_RB, XO(31, 11), ASM_RC},
+	{"mfcr", FORM_X_RT, XO(31, 19), 0},
+	{"lwarx", FORM_X_RT_RA_RB, XO(31, 20), 0},
+	{"ldx", FORM_X_RT_RA_RB, XO(31, 21), 0},
+	{"lwzx", FORM_X_RT_RA_RB, XO(31, 23), 0},
+	{"slw", FORM_X_RA_RS_RB, XO(31, 24), ASM_RC},
+	{"cntlzw", FORM_X_RA_RS, XO(31, 26), ASM_RC},
+	{"sld", FORM_X_RA_RS_RB, XO(31, 27), ASM_RC},
+	{"and", FORM_X_RA_RS_RB, XO(31, 28), ASM_RC},
+	{"cmpl", FORM_X_CMP_FULL, XO(31, 32), 0},
+	{"cmplw", FORM_X_CMP, XO(31, 32), 0},
+	{"cmpld", FORM_X_CMP, XO(31, 32) | F_RT(1), 0},
+	{"subf", FORM_XO_RT_RA_RB, XO(31, 40), ASM_RC | ASM_OE},
+	{"sub", FORM_P_SUB, XO(31, 40), ASM_RC | ASM_OE},
+	{"ldux", FORM_X_RT_RA_RB, XO(31, 53), 0},
+	{"dcbst", FORM_X_RA_RB, XO(31, 54), 0},
+	{"lwzux", FORM_X_RT_RA_RB, XO(31, 55), 0},
+	{"cntlzd", FORM_X_RA_RS, XO(31, 58), ASM_RC},
+	{"andc", FORM_X_RA_RS_RB, XO(31, 60), ASM_RC},
+	{"td", FORM_X_TO_RA_RB, XO(31, 68), 0},
+	{"dcbtst", FORM_X_RA_RB, XO(31, 246), 0},
+	{"add", FORM_XO_RT_RA_RB, XO(31, 266), ASM_RC | ASM_OE},
+	{"tlbiel", FORM_X_RB, XO(31, 274), 0},
+	{"dcbt", FORM_X_RA_RB, XO(31, 278), 0},
+	{"tlbie", FORM_X_RB, XO(31, 306), 0},
+	{"mfspr", FORM_XFX_MFSPR, XO(31, 339), 0},
+	{"mfxer", FORM_XFX_RT, XO(31, 339) | SPR(1), 0},
+	{"mflr", FORM_XFX_RT, XO(31, 339) | SPR(8), 0},
+	{"mfctr", FORM_XFX_RT, XO(31, 339) | SPR(9), 0},
+	{"tlbia", FORM_NONE, XO(31, 370), 0},
+	{"slbmte", FORM_X_RS_RB, XO(31, 402), 0},
+	{"slbie", FORM_X_RB, XO(31, 434), 0},
+	{"or", FORM_X_RA_RS_RB, XO(31, 444), ASM_RC},
+	{"mr", FORM_P_MR, XO(31, 444), ASM_RC},
+	{"mtspr", FORM_XFX_MTSPR, XO(31, 467), 0},
+	{"mtxer", FORM_XFX_RS, XO(31, 467) | SPR(1), 0},
+	{"mtlr", FORM_XFX_RS, XO(31, 467) | SPR(8), 0},
+	{"mtctr", FORM_XFX_RS, XO(31, 467) | SPR(9), 0},
+	{"tlbsync", FORM_NONE, XO(31, 566), 0},
+	{"lswi", FORM_X_RT_RA_NB, XO(31, 597), 0},
+	{"sync", FORM_NONE, XO(31, 598), 0},
+	{"lwsync", FORM_NONE, XO(31, 598) | F_RT(1), 0},
+	{"stswi", FORM_X_RT_RA_NB, XO(31, 725), 0},
+	{"eieio", FORM_NONE, XO(31, 854), 0},
+	{"icbi", FORM_X_RA_RB, XO(31, 982), 0},
+	{"lwz", FORM_D_MEM, OPCD(32), 0},
+	{"lwzu", FORM_D_MEM, OPCD(33), 0},
+	{"lbz", FORM_D_MEM, OPCD(34), 0},
+	{"lbzu", FORM_D_MEM, OPCD(35), 0},
+	{"stw", FORM_D_MEM, OPCD(36), 0},
+	{"stwu", FORM_D_MEM, OPCD(37), 0},
+	{"stb", FORM_D_MEM, OPCD(38), 0},
+	{"stbu", FORM_D_MEM, OPCD(39), 0},
+	{"lhz", FORM_D_MEM, OPCD(40), 0},
+	{"lhzu", FORM_D_MEM, OPCD(41), 0},
+	{"lha", FORM_D_MEM, OPCD(42), 0},
+	{"lhau", FORM_D_MEM, OPCD(43), 0},
+	{"sth", FORM_D_MEM, OPCD(44), 0},
+	{"sthu", FORM_D_MEM, OPCD(45), 0},
+	{"lmw", FORM_D_MEM, OPCD(46), 0},
+	{"stmw", FORM_D_MEM, OPCD(47), 0},
+	{"ld", FORM_DS_MEM, OPCD(58) | 0, 0},
+	{"ldu", FORM_DS_MEM, OPCD(58) | 1, 0},
+	{"lwa", FORM_DS_MEM, OPCD(58) | 2, 0},
+	{"std", FORM_DS_MEM, OPCD(62) | 0, 0},
+	{"stdu", FORM_DS_MEM, OPCD(62) | 1, 0},
+};
+
+/* Condition mnemonics for the generated conditional branches: BO, CR bit */
+static const struct {
+	const char *cc;
+	uint8_t bo;
+	uint8_t bit;
+} conditions[] = {
+	{"lt", BO_TRUE, 0}, {"ge", BO_FALSE, 0}, {"nl", BO_FALSE, 0},
+	{"gt", BO_TRUE, 1}, {"le", BO_FALSE, 1}, {"ng", BO_FALSE, 1},
+	{"eq", BO_TRUE, 2}, {"ne", BO_FALSE, 2},
+	{"so", BO_TRUE, 3}, {"ns", BO_FALSE, 3}, {"un", BO_TRUE, 3}, {"nu", BO_FALSE, 3},
+};
+
+static const struct {
+	const char *suffix;
+	AsmForm form;
+	uint32_t base;
+} conditionSuffixes[] = {
+	{"", FORM_B_COND, OPCD(16)},
+	{"a", FORM_B_COND, OPCD(16) | 2},
+	{"l", FORM_B_COND, OPCD(16) | 1},
+	{"la", FORM_B_COND, OPCD(16) | 3},
+	{"lr", FORM_XL_COND, XO(19, 16)},
+	{"lrl", FORM_XL_COND, XO(19, 16) | 1},
+	{"ctr", FORM_XL_COND, XO(19, 528)},
+	{"ctrl", FORM_XL_COND, XO(19, 528) | 1},
+};
+
+static uint32_t MnemonicHash(const char *s, size_t len, uint32_t seed) {
+	uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+	for (size_t i = 0; i < len; i++) {
+		h ^= (uint8_t)s[i];
+		h *= 16777619u;
+	}
+	return h ^ (h >> 16);
+}
+
+/*
+ * Hash-and-displace perfect hash: the first hash picks a bucket, and each
+ * bucket stores the seed that sends all of its keys to distinct free
+ * slots. A lookup is two hashes and one string compare.
+ */
+class MnemonicTable {
+private:
+	std::deque<std::string> names;
+	std::vector<AsmOpcode> entries;
+	std::vector<uint32_t> seeds;
+	std::vector<int32_t> slots;
+	uint32_t slotMask;
+
+	void Build() {
+		size_t n = entries.size();
+		size_t bucketCount = std::max<size_t>(1, n / 2);
+		size_t slotCount = 1;
+		while (slotCount < n * 2)
+			slotCount <<= 1;
+		slotMask = slotCount - 1;
+		seeds.assign(bucketCount, 0);
+		slots.assign(slotCount, -1);
+
+		std::vector<std::vector<int32_t>> buckets(bucketCount);
+		for (size_t i = 0; i < n; i++) {
+			const char *s = entries[i].name;
+			buckets[MnemonicHash(s, strlen(s), 0) % bucketCount].push_back(i);
+		}
+		std::vector<size_t> order(bucketCount);
+		for (size_t b = 0; b < bucketCount; b++)
+			order[b] = b;
+		std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+			return buckets[a].size() > buckets[b].size();
+		});
+
+		std::vector<uint32_t> placed;
+		for (size_t b : order) {
+			if (buckets[b].empty())
+				break;
+			for (uint32_t seed = 1;; seed++) {
+				placed.clear();
+				bool ok = true;
+				for (int32_t i : buckets[b]) {
+					const char *s = entries[i].name;
+					uint32_t slot = MnemonicHash(s, strlen(s), seed) & slotMask;
+					if (slots[slot] >= 0 || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+						ok = false;
+						break;
+					}
+					placed.push_back(slot);
+				}
+				if (!ok)
+					continue;
+				for (size_t k = 0; k < placed.size(); k++)
+					slots[placed[k]] = buckets[b][k];
+				seeds[b] = seed;
+				break;
+			}
+		}
+	}
+public:
+	MnemonicTable() {
+		entries.assign(std::begin(opcodes), std::end(opcodes));
+		for (auto &c : conditions) {
+			for (auto &s : conditionSuffixes) {
+				names.push_back(std::string("b") + c.cc + s.suffix);
+				uint32_t base = s.base | F_RT(c.bo) | F_RA(c.bit);
+				entries.push_back({names.back().c_str(), s.form, base, 0});
+			}
+		}
+		// mf<spr>/mt<spr> for named SPRs; xer, lr and ctr are in the table
+		for (uint32_t n = 0; n < 1024; n++) {
+			const PpcSpr &spr = PpcSprInfo(n);
+			if (!spr.name || n == 1 || n == 8 || n == 9)
+				continue;
+			if (PpcSprByName(spr.name, false) == (int)n)
+				entries.push_back({spr.mf, FORM_XFX_RT, XO(31, 339) | SPR(n), 0});
+			if (PpcSprByName(spr.name, true) == (int)n)
+				entries.push_back({spr.mt, FORM_XFX_RS, XO(31, 467) | SPR(n), 0});
+		}
+		Build();
+	}
+
+	const AsmOpcode *Find(const char *s, size_t len) const {
+		uint32_t seed = seeds[MnemonicHash(s, len, 0) % seeds.size()];
+		int32_t i = slots[MnemonicHash(s, len, seed) & slotMask];
+		if (i < 0)
+			return nullptr;
+		const char *name = entries[i].name;
+		if (strncmp(name, s, len) != 0 || name[len] != 0)
+			return nullptr;
+		return &entries[i];
+	}
+};
+
+static const MnemonicTable &Mnemonics() {
+	static MnemonicTable table;
+	return table;
+}
+
+/* Operand parsing */
+
+static std::string Trim(const std::string &s) {
+	size_t a = 0, b = s.size();
+	while (a < b && isspace((unsigned char)s[a]))
+		a++;
+	while (b > a && isspace((unsigned char)s[b-1]))
+		b--;
+	return s.substr(a, b - a);
+}
+
+static bool ParseNumber(const std::string &s, int64_t &value) {
+	size_t i = 0;
+	bool neg = false;
+	if (i < s.size() && (s[i] == '-' || s[i] == '+')) {
+		neg = s[i] == '-';
+		i++;
+	}
+	int base = 10;
+	if (i + 1 < s.size() && s[i] == '0' && (s[i+1] == 'x' || s[i+1] == 'X')) {
+		base = 16;
+		i += 2;
+	}
+	if (i >= s.size())
+		return false;
+	uint64_t v = 0;
+	for (; i < s.size(); i++) {
+		int d;
+		char c = tolower((unsigned char)s[i]);
+		if (c >= '0' && c <= '9')
+			d = c - '0';
+		else if (base == 16 && c >= 'a' && c <= 'f')
+			d = c - 'a' + 10;
+		else
+			return false;
+		v = v * base + d;
+	}
+	value = neg ? -(int64_t)v : (int64_t)v;
+	return true;
+}
+
+// Accepts rN, %rN or a bare number.
+static bool ParseGpr(const std::string &s, uint32_t &reg) {
+	size_t i = 0;
+	if (i < s.size() && s[i] == '%')
+		i++;
+	if (i < s.size() && (s[i] == 'r' || s[i] == 'R'))
+		i++;
+	int64_t v;
+	if (!ParseNumber(s.substr(i), v) || v < 0 || v > 31)
+		return false;
+	reg = v;
+	return true;
+}
+
+// Accepts crN, %crN or a bare number.
+static bool ParseCrField(const std::string &s, uint32_t &field) {
+	size_t i = 0;
+	if (i < s.size() && s[i] == '%')
+		i++;
+	if (i + 1 < s.size() && tolower((unsigned char)s[i]) == 'c' && tolower((unsigned char)s[i+1]) == 'r')
+		i += 2;
+	int64_t v;
+	if (!ParseNumber(s.substr(i), v) || v < 0 || v > 7)
+		return false;
+	field = v;
+	return true;
+}
+
+// d(ra); an empty displacement means 0.
+static bool ParseMemory(const std::string &s, int64_t &disp, uint32_t &ra) {
+	size_t open = s.find('(');
+	if (open == std::string::npos || s.back() != ')')
+		return false;
+	std::string d = Trim(s.substr(0, open));
+	disp = 0;
+	if (!d.empty() && !ParseNumber(d, disp))
+		return false;
+	return ParseGpr(Trim(s.substr(open + 1, s.size() - open - 2)), ra);
+}
+
+class AsmOperands {
+private:
+	const std::vector<std::string> &ops;
+	std::string &error;
+public:
+	AsmOperands(const std::vector<std::string> &ops, std::string &error) : ops(ops), error(error) {}
+
+	bool Fail(size_t i, const char *what) {
+		error = "operand " + std::to_string(i + 1) + ": expected " + what;
+		if (i < ops.size())
+			error += ", got '" + ops[i] + "'";
+		return false;
+	}
+
+	bool Gpr(size_t i, uint32_t &reg) {
+		return ParseGpr(ops[i], reg) || Fail(i, "a general purpose register");
+	}
+
+	bool Cr(size_t i, uint32_t &field) {
+		return ParseCrField(ops[i], field) || Fail(i, "a condition register field");
+	}
+
+	bool Range(size_t i, int64_t lo, int64_t hi, int64_t &value) {
+		if (!ParseNumber(ops[i], value))
+			return Fail(i, "an immediate");
+		if (value < lo || value > hi) {
+			error = "operand " + std::to_string(i + 1) + ": " + ops[i] + " out of range ["
+				+ std::to_string(lo) + ", " + std::to_string(hi) + "]";
+			return false;
+		}
+		return true;
+	}
+
+	bool Unsigned(size_t i, unsigned bits, uint32_t &value) {
+		int64_t v;
+		if (!Range(i, 0, (1ll << bits) - 1, v))
+			return false;
+		value = v;
+		return true;
+	}
+
+	bool Signed16(size_t i, uint32_t &field) {
+		int64_t v;
+		if (!Range(i, -0x8000, 0x7fff, v))
+			return false;
+		field = v & 0xffff;
+		return true;
+	}
+
+	bool Memory(size_t i, int64_t &disp, uint32_t &ra) {
+		return ParseMemory(ops[i], disp, ra) || Fail(i, "d(rA)");
+	}
+
+	// Branch target as an absolute address; encoded relative unless AA.
+	bool Target(size_t i, uint64_t addr, bool absolute, unsigned bits, uint32_t &field) {
+		int64_t target;
+		if (!ParseNumber(ops[i], target))
+			return Fail(i, "a branch target");
+		int64_t disp = absolute ? target : (int64_t)((uint64_t)target - addr);
+		int64_t limit = 1ll << (bits - 1);
+		if (disp & 3) {
+			error = "branch target " + ops[i] + " is not word aligned";
+			return false;
+		}
+		if (disp < -limit || disp >= limit) {
+			error = "branch target " + ops[i] + " out of range";
+			return false;
+		}
+		field = disp & ((1u << bits) - 4);
+		return true;
+	}
+};
+
+static uint32_t MField(uint32_t sh, uint32_t mb, uint32_t me) {
+	return (sh << 11) | (mb << 6) | (me << 1);
+}
+
+// sh and mb/me in their split MD-form encodings
+static uint32_t MDField(uint32_t sh, uint32_t m) {
+	return ((sh & 0x1f) << 11) | ((sh >> 5) << 1) | ((m & 0x1f) << 6) | (m & 0x20);
+}
+
+static bool Encode(const AsmOpcode &op, const std::vector<std::string> &ops, uint64_t addr, uint32_t &inst, std::string &error) {
+	AsmOperands o(ops, error);
+	size_t n = ops.size();
+	uint32_t rt, ra, rb, bf, f0, f1, f2;
+	int64_t v, disp;
+	inst = op.base;
+
+	size_t want;
+	switch (op.form) {
+		case FORM_NONE: want = 0; break;
+		case FORM_X_RB: case FORM_X_RT: case FORM_XFX_RT: case FORM_XFX_RS: case FORM_I: case FORM_B_CTR: want = 1; break;
+		case FORM_X_RA_RS: case FORM_X_RA_RB: case FORM_X_RS_RB: case FORM_XFX_MFSPR: case FORM_XFX_MTSPR:
+		case FORM_D_MEM: case FORM_DS_MEM: case FORM_P_LA: case FORM_P_MR: case FORM_XL_FULL: case FORM_D_RT_SI: want = 2; break;
+		case FORM_M_SH: case FORM_M_RB: want = 5; break;
+		case FORM_D_CMPI_FULL: case FORM_D_CMPLI_FULL: case FORM_X_CMP_FULL: case FORM_MD_MB: case FORM_MD_ME:
+		case FORM_MDS_MB: case FORM_MDS_ME: want = 4; break;
+		case FORM_B_COND: want = n == 2 ? 2 : 1; break;
+		case FORM_XL_COND: want = n == 1 ? 1 : 0; break;
+		case FORM_D_CMPI: case FORM_D_CMPLI: case FORM_X_CMP: want = n == 3 ? 3 : 2; break;
+		default: want = 3; break;
+	}
+	if (n != want) {
+		error = "expected " + std::to_string(want) + " operands, got " + std::to_string(n);
+		return false;
+	}
+
+	switch (op.form) {
+		case FORM_NONE:
+			return true;
+		case FORM_D_RT_RA_SI:
+			if (!o.Gpr(0, rt) || !o.Gpr(1, ra) || !o.Signed16(2, f0))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | f0;
+			return true;
+		case FORM_P_SUBI:
+			if (!o.Gpr(0, rt) || !o.Gpr(1, ra) || !o.Range(2, -0x7fff, 0x8000, v))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | (-v & 0xffff);
+			return true;
+		case FORM_D_RT_SI:
+			if (!o.Gpr(0, rt) || !o.Signed16(1, f0))
+				return false;
+			inst |= F_RT(rt) | f0;
+			return true;
+		case FORM_D_RA_RS_UI:
+			if (!o.Gpr(0, ra) || !o.Gpr(1, rt) || !o.Unsigned(2, 16, f0))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | f0;
+			return true;
+		case FORM_D_MEM:
+		case FORM_P_LA:
+			if (!o.Gpr(0, rt) || !o.Memory(1, disp, ra))
+				return false;
+			if (disp < -0x8000 || disp > 0x7fff) {
+				error = "displacement " + std::to_string(disp) + " out of range";
+				return false;
+			}
+			inst |= F_RT(rt) | F_RA(ra) | (disp & 0xffff);
+			return true;
+		case FORM_DS_MEM:
+			if (!o.Gpr(0, rt) || !o.Memory(1, disp, ra))
+				return false;
+			if (disp < -0x8000 || disp > 0x7ffc || (disp & 3)) {
+				error = "displacement " + std::to_string(disp) + " must be a multiple of 4 in [-32768, 32764]";
+				return false;
+			}
+			inst |= F_RT(rt) | F_RA(ra) | (disp & 0xfffc);
+			return true;
+		case FORM_D_CMPI:
+		case FORM_D_CMPLI:
+			bf = 0;
+			if (n == 3 && !o.Cr(0, bf))
+				return false;
+			if (!o.Gpr(n - 2, ra))
+				return false;
+			if (op.form == FORM_D_CMPI ? !o.Signed16(n - 1, f0) : !o.Unsigned(n - 1, 16, f0))
+				return false;
+			inst |= (bf << 23) | F_RA(ra) | f0;
+			return true;
+		case FORM_D_CMPI_FULL:
+		case FORM_D_CMPLI_FULL:
+			if (!o.Cr(0, bf) || !o.Unsigned(1, 1, f1) || !o.Gpr(2, ra))
+				return false;
+			if (op.form == FORM_D_CMPI_FULL ? !o.Signed16(3, f0) : !o.Unsigned(3, 16, f0))
+				return false;
+			inst |= (bf << 23) | (f1 << 21) | F_RA(ra) | f0;
+			return true;
+		case FORM_D_TO_RA_SI:
+			if (!o.Unsigned(0, 5, f1) || !o.Gpr(1, ra) || !o.Signed16(2, f0))
+				return false;
+			inst |= F_RT(f1) | F_RA(ra) | f0;
+			return true;
+		case FORM_I:
+			if (!o.Target(0, addr, inst & 2, 26, f0))
+				return false;
+			inst |= f0;
+			return true;
+		case FORM_B_FULL:
+			if (!o.Unsigned(0, 5, f1) || !o.Unsigned(1, 5, f2) || !o.Target(2, addr, inst & 2, 16, f0))
+				return false;
+			inst |= F_RT(f1) | F_RA(f2) | f0;
+			return true;
+		case FORM_B_COND:
+			bf = 0;
+			if (n == 2 && !o.Cr(0, bf))
+				return false;
+			if (!o.Target(n - 1, addr, inst & 2, 16, f0))
+				return false;
+			inst |= F_RA(bf * 4);
+			inst |= f0;
+			return true;
+		case FORM_B_CTR:
+			if (!o.Target(0, addr, inst & 2, 16, f0))
+				return false;
+			inst |= f0;
+			return true;
+		case FORM_XL_FULL:
+			if (!o.Unsigned(0, 5, f1) || !o.Unsigned(1, 5, f2))
+				return false;
+			inst |= F_RT(f1) | F_RA(f2);
+			return true;
+		case FORM_XL_COND:
+			bf = 0;
+			if (n == 1 && !o.Cr(0, bf))
+				return false;
+			inst |= F_RA(bf * 4);
+			return true;
+		case FORM_XO_RT_RA_RB:
+		case FORM_X_RT_RA_RB:
+			if (!o.Gpr(0, rt) || !o.Gpr(1, ra) || !o.Gpr(2, rb))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | F_RB(rb);
+			return true;
+		case FORM_X_RT_RA_NB:
+			if (!o.Gpr(0, rt) || !o.Gpr(1, ra) || !o.Unsigned(2, 5, rb))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | F_RB(rb);
+			return true;
+		case FORM_P_SUB:
+			if (!o.Gpr(0, rt) || !o.Gpr(1, ra) || !o.Gpr(2, rb))
+				return false;
+			inst |= F_RT(rt) | F_RA(rb) | F_RB(ra);
+			return true;
+		case FORM_X_RA_RS_RB:
+			if (!o.Gpr(0, ra) || !o.Gpr(1, rt) || !o.Gpr(2, rb))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | F_RB(rb);
+			return true;
+		case FORM_X_RA_RS:
+			if (!o.Gpr(0, ra) || !o.Gpr(1, rt))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra);
+			return true;
+		case FORM_P_MR:
+			if (!o.Gpr(0, ra) || !o.Gpr(1, rt))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | F_RB(rt);
+			return true;
+		case FORM_X_RA_RB:
+			if (!o.Gpr(0, ra) || !o.Gpr(1, rb))
+				return false;
+			inst |= F_RA(ra) | F_RB(rb);
+			return true;
+		case FORM_X_RS_RB:
+			if (!o.Gpr(0, rt) || !o.Gpr(1, rb))
+				return false;
+			inst |= F_RT(rt) | F_RB(rb);
+			return true;
+		case FORM_X_RB:
+			if (!o.Gpr(0, rb))
+				return false;
+			inst |= F_RB(rb);
+			return true;
+		case FORM_X_RT:
+		case FORM_XFX_RT:
+		case FORM_XFX_RS:
+			if (!o.Gpr(0, rt))
+				return false;
+			inst |= F_RT(rt);
+			return true;
+		case FORM_X_CMP:
+			bf = 0;
+			if (n == 3 && !o.Cr(0, bf))
+				return false;
+			if (!o.Gpr(n - 2, ra) || !o.Gpr(n - 1, rb))
+				return false;
+			inst |= (bf << 23) | F_RA(ra) | F_RB(rb);
+			return true;
+		case FORM_X_CMP_FULL:
+			if (!o.Cr(0, bf) || !o.Unsigned(1, 1, f1) || !o.Gpr(2, ra) || !o.Gpr(3, rb))
+				return false;
+			inst |= (bf << 23) | (f1 << 21) | F_RA(ra) | F_RB(rb);
+			return true;
+		case FORM_X_TO_RA_RB:
+			if (!o.Unsigned(0, 5, f1) || !o.Gpr(1, ra) || !o.Gpr(2, rb))
+				return false;
+			inst |= F_RT(f1) | F_RA(ra) | F_RB(rb);
+			return true;
+		case FORM_XFX_MFSPR:
+			if (!o.Gpr(0, rt) || !o.Unsigned(1, 10, f0))
+				return false;
+			inst |= F_RT(rt) | SPR(f0);
+			return true;
+		case FORM_XFX_MTSPR:
+			if (!o.Unsigned(0, 10, f0) || !o.Gpr(1, rt))
+				return false;
+			inst |= F_RT(rt) | SPR(f0);
+			return true;
+		case FORM_M_SH:
+		case FORM_M_RB:
+			if (!o.Gpr(0, ra) || !o.Gpr(1, rt) || !o.Unsigned(3, 5, f1) || !o.Unsigned(4, 5, f2))
+				return false;
+			if (op.form == FORM_M_SH ? !o.Unsigned(2, 5, f0) : !o.Gpr(2, f0))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | MField(f0, f1, f2);
+			return true;
+		case FORM_MD_MB:
+		case FORM_MD_ME:
+			if (!o.Gpr(0, ra) || !o.Gpr(1, rt) || !o.Unsigned(2, 6, f0) || !o.Unsigned(3, 6, f1))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | MDField(f0, f1);
+			return true;
+		case FORM_MDS_MB:
+		case FORM_MDS_ME:
+			if (!o.Gpr(0, ra) || !o.Gpr(1, rt) || !o.Gpr(2, rb) || !o.Unsigned(3, 6, f1))
+				return false;
+			inst |= F_RT(rt) | F_RA(ra) | F_RB(rb) | MDField(0, f1);
+			return true;
+		default:
+			break;
+	}
+
+	/* Shift and rotate shorthands: ra, rs, n */
+	if (!o.Gpr(0, ra) || !o.Gpr(1, rt))
+		return false;
+	bool word = op.form <= FORM_P_CLRLWI;
+	if (!o.Unsigned(2, word ? 5 : 6, f0))
+		return false;
+	inst |= F_RT(rt) | F_RA(ra);
+	switch (op.form) {
+		case FORM_P_SLWI: inst |= MField(f0, 0, 31 - f0); break;
+		case FORM_P_SRWI: inst |= MField((32 - f0) & 31, f0, 31); break;
+		case FORM_P_ROTLWI: inst |= MField(f0, 0, 31); break;
+		case FORM_P_CLRLWI: inst |= MField(0, f0, 31); break;
+		case FORM_P_SLDI: inst |= MDField(f0, 63 - f0); break;
+		case FORM_P_SRDI: inst |= MDField((64 - f0) & 63, f0); break;
+		case FORM_P_ROTLDI: inst |= MDField(f0, 0); break;
+		case FORM_P_CLRLDI: inst |= MDField(0, f0); break;
+		case FORM_P_CLRRDI: inst |= MDField(0, 63 - f0); break;
+		default: break;
+	}
+	return true;
+}
+
+bool PpcAssembler::AssembleOne(const std::string &line, uint64_t addr, uint32_t &inst, std::string &error) {
+	std::string text = Trim(line);
+	size_t end = 0;
+	while (end < text.size() && !isspace((unsigned char)text[end]))
+		end++;
+
+	char mnemonic[16];
+	size_t len = end;
+	if (len == 0 || len >= sizeof(mnemonic)) {
+		error = "bad mnemonic '" + text.substr(0, end) + "'";
+		return false;
+	}
+	for (size_t i = 0; i < len; i++)
+		mnemonic[i] = tolower((unsigned char)text[i]);
+	mnemonic[len] = 0;
+
+	// Exact names first, then Rc ('.') and OE ('o') suffixes.
+	uint32_t extra = 0;
+	const AsmOpcode *op = Mnemonics().Find(mnemonic, len);
+	if (!op && mnemonic[len-1] == '.') {
+		len--;
+		extra |= 1;
+		op = Mnemonics().Find(mnemonic, len);
+	}
+	if (!op && len > 1 && mnemonic[len-1] == 'o') {
+		extra |= 0x400;
+		op = Mnemonics().Find(mnemonic, len - 1);
+	}
+	if (op && (((extra & 1) && !(op->flags & ASM_RC)) || ((extra & 0x400) && !(op->flags & ASM_OE))))
+		op = nullptr;
+	if (!op) {
+		error = "unknown mnemonic '" + text.substr(0, end) + "'";
+		return false;
+	}
+
+	std::vector<std::string> ops;
+	std::string rest = Trim(text.substr(end));
+	size_t pos = 0;
+	while (!rest.empty()) {
+		size_t comma = rest.find(',', pos);
+		ops.push_back(Trim(rest.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos)));
+		if (ops.back().empty()) {
+			error = "empty operand";
+			return false;
+		}
+		if (comma == std::string::npos)
+			break;
+		pos = comma + 1;
+	}
+	if (ops.size() > ASM_MAX_OPERANDS) {
+		error = "too many operands";
+		return false;
+	}
+
+	if (!Encode(*op, ops, addr, inst, error))
+		return false;
+	inst |= extra;
+
+	// Reject operand combinations the decoder treats as invalid forms
+	// (e.g. lwzu with rA = 0).
+	if (!(RECORD_FLAGS(PpcDecoder::Decode(inst, addr)) & INSN_VALID)) {
+		error = "invalid operand combination for " + std::string(op->name);
+		return false;
+	}
+	return true;
+}
+
+bool PpcAssembler::Assemble(const std::string &code, uint64_t addr, std::vector<uint8_t> &out, std::string &errors) {
+	bool ok = true;
+	size_t start = 0;
+	unsigned lineNo = 1;
+	while (start <= code.size()) {
+		size_t end = code.find_first_of("\n;", start);
+		if (end == std::string::npos)
+			end = code.size();
+		std::string line = code.substr(start, end - start);
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.resize(comment);
+		if (!Trim(line).empty()) {
+			uint32_t inst;
+			std::string error;
+			if (AssembleOne(line, addr + out.size(), inst, error)) {
+				size_t at = out.size();
+				out.resize(at + 4);
+				WriteInstruction(&out[at], inst);
+			} else {
+				errors += "line " + std::to_string(lineNo) + ": " + error + "\n";
+				ok = false;
+			}
+		}
+		if (end < code.size() && code[end] == '\n')
+			lineNo++;
+		start = end + 1;
+	}
+	return ok;
+}
+
+/* Branch rewriting */
+
+static bool IsBranchToRegister(uint32_t inst) {
+	uint32_t xo = (inst >> 1) & 0x3ff;
+	return (inst >> 26) == 19 && (xo == 16 || xo == 528);
+}
+
+bool PpcAssembler::IsConditionalBranch(uint32_t inst) {
+	if ((inst >> 26) != 16 && !IsBranchToRegister(inst))
+		return false;
+	uint32_t bo = (inst >> 21) & 0x1f;
+	return (bo & 0x14) != 0x14;
+}
+
+bool PpcAssembler::IsCall(uint32_t inst) {
+	uint32_t op = inst >> 26;
+	return (op == 16 || op == 18 || IsBranchToRegister(inst)) && (inst & 1);
+}
+
+// Only branches testing exactly one of CTR and a CR bit can be inverted
+// in place; "decrement and test both" has no single-word inverse.
+bool PpcAssembler::CanInvert(uint32_t inst) {
+	if (!IsConditionalBranch(inst))
+		return false;
+	uint32_t bo = (inst >> 21) & 0x1f;
+	return ((bo & 0x4) != 0) != ((bo & 0x10) != 0);
+}
+
+uint32_t PpcAssembler::MakeAlways(uint32_t inst) {
+	if ((inst >> 26) == 16) {
+		// bc -> b with the same displacement, AA and LK
+		uint32_t bd = inst & 0xfffc;
+		uint32_t li = ((bd & 0x8000) ? (bd | 0x3ff0000) : bd);
+		return OPCD(18) | li | (inst & 3);
+	}
+	return (inst & ~(F_RT(0x1f) | F_RA(0x1f))) | F_RT(BO_ALWAYS);
+}
+
+uint32_t PpcAssembler::Invert(uint32_t inst) {
+	uint32_t bo = (inst >> 21) & 0x1f;
+	if (bo & 0x4)
+		return inst ^ F_RT(0x08);	// CR bit true <-> false
+	return inst ^ F_RT(0x02);		// bdnz <-> bdz
+}
+
+bool PpcAssembler::LoadImmediate(uint32_t rt, uint64_t value, uint32_t &inst) {
+	int64_t v = (int64_t)value;
+	if (v >= -0x8000 && v <= 0x7fff) {
+		inst = (14u << 26) | (rt << 21) | (v & 0xffff);
+		return true;
+	}
+	// lis: the high half of a sign-extended 32-bit value
+	if (v >= INT32_MIN && v <= INT32_MAX && (v & 0xffff) == 0) {
+		inst = (15u << 26) | (rt << 21) | ((v >> 16) & 0xffff);
+		return true;
+	}
+	return false;
+}
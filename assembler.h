@@ -0,0 +1,56 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * In-process assembler for the instructions the decoder understands.
+ *
+ * Mnemonics are looked up through a perfect hash built once over the
+ * opcode table. Operands are range-checked for their form, and every
+ * encoded word is run back through PpcDecoder, so anything accepted here
+ * disassembles again.
+ */
+class PpcAssembler {
+public:
+	// Assembles one instruction. On failure, error describes the problem.
+	static bool AssembleOne(const std::string &line, uint64_t addr, uint32_t &inst, std::string &error);
+
+	// Assembles newline- or ';'-separated instructions placed at
+	// consecutive addresses starting at addr. Output is big-endian.
+	static bool Assemble(const std::string &code, uint64_t addr, std::vector<uint8_t> &out, std::string &errors);
+
+	/* Branch rewriting for the patch callbacks */
+	static bool IsConditionalBranch(uint32_t inst);
+	static bool IsCall(uint32_t inst);
+	static bool CanInvert(uint32_t inst);
+	static uint32_t MakeAlways(uint32_t inst);
+	static uint32_t Invert(uint32_t inst);
+
+	// The single li or lis that sets rt to value, if there is one
+	static bool LoadImmediate(uint32_t rt, uint64_t value, uint32_t &inst);
+};
+
+static inline void WriteInstruction(uint8_t *data, uint32_t inst) {
+	data[0] = inst >> 24;
+	data[1] = inst >> 16;
+	data[2] = inst >> 8;
+	data[3] = inst;
+}
@@ -0,0 +1,203 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "atomic.h"
+#include "decoder.h"
+#include "decode_macros.h"
+
+static uint32_t Word(const uint8_t *data, size_t i) {
+	data += i * 4;
+	return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+size_t PpcLarxSize(uint32_t inst) {
+	if ((inst >> 26) != 31)
+		return 0;
+	switch ((inst >> 1) & 0x3ff) {
+	case 52: return 1;	// lbarx
+	case 116: return 2;	// lharx
+	case 20: return 4;	// lwarx
+	case 84: return 8;	// ldarx
+	default: return 0;
+	}
+}
+
+size_t PpcStcxSize(uint32_t inst) {
+	if ((inst >> 26) != 31 || !(inst & 1))
+		return 0;
+	switch ((inst >> 1) & 0x3ff) {
+	case 694: return 1;	// stbcx.
+	case 726: return 2;	// sthcx.
+	case 150: return 4;	// stwcx.
+	case 214: return 8;	// stdcx.
+	default: return 0;
+	}
+}
+
+// bc with "branch if CR bit false", no CTR use, no link, relative
+static bool IsBranchFalse(uint32_t inst, uint32_t bi, uint64_t addr, uint64_t &target) {
+	if ((inst >> 26) != 16 || (inst & 3) != 0)
+		return false;
+	if ((BFORM_BO(inst) & 0x1c) != 0x04 || BFORM_BI(inst) != bi)
+		return false;
+	target = PpcDecoder::BranchTarget(inst, addr);
+	return true;
+}
+
+static bool IsStcx(uint32_t inst, const AtomicSequence &seq) {
+	return PpcStcxSize(inst) == seq.size && XFORM_RA(inst) == seq.ra && XFORM_RB(inst) == seq.rb;
+}
+
+// Recognizes "rs = rt op x" for the RMW forms. rt must be a source and
+// the result must not clobber the address.
+static bool MatchOp(uint32_t inst, AtomicSequence &seq) {
+	uint32_t rt = seq.rt;
+	seq.imm = false;
+	seq.middle = inst;
+	if ((inst >> 26) == 14) {
+		// addi rs, rt, si; with rt = r0 it is li rs, si, which ignores rt
+		if (rt == 0 || DFORM_RA(inst) != rt)
+			return false;
+		seq.op = AtomicOp::Add;
+		seq.rs = DFORM_RT(inst);
+		seq.imm = true;
+		seq.value = (int16_t)DFORM_D(inst);
+		return true;
+	}
+	if ((inst >> 26) != 31 || (inst & 1))
+		return false;
+	uint32_t a = XFORM_RA(inst), b = XFORM_RB(inst), s = XFORM_RS(inst);
+	switch ((inst >> 1) & 0x3ff) {
+	case 266:	// add rt', ra, rb
+		if (a != rt && b != rt)
+			return false;
+		seq.op = AtomicOp::Add;
+		seq.rs = s;
+		seq.rx = a == rt ? b : a;
+		return true;
+	case 40:	// subf rt', ra, rb: rb - ra
+		if (b != rt || a == rt)
+			return false;
+		seq.op = AtomicOp::Sub;
+		seq.rs = s;
+		seq.rx = a;
+		return true;
+	case 28:	// and ra, rs, rb
+	case 444:	// or
+	case 316:	// xor
+		if (s != rt && b != rt)
+			return false;
+		seq.op = ((inst >> 1) & 0x3ff) == 28 ? AtomicOp::And :
+			((inst >> 1) & 0x3ff) == 444 ? AtomicOp::Or : AtomicOp::Xor;
+		seq.rs = a;
+		seq.rx = s == rt ? b : s;
+		return true;
+	case 60:	// andc ra, rs, rb: rs & ~rb
+		if (s != rt || b == rt)
+			return false;
+		seq.op = AtomicOp::Andc;
+		seq.rs = a;
+		seq.rx = b;
+		return true;
+	default:
+		return false;
+	}
+}
+
+// cmp/cmpl/cmpi/cmpli of rt against the expected value
+static bool MatchCompare(uint32_t inst, AtomicSequence &seq, uint32_t &bf) {
+	uint32_t primary = inst >> 26;
+	seq.middle = inst;
+	bool wide = DFORM_L(inst);
+	if (wide != (seq.size == 8))
+		return false;
+	if (primary == 10 || primary == 11) {
+		if (DFORM_RA(inst) != seq.rt || (inst >> 22) & 1)
+			return false;
+		bf = DFORM_BF(inst);
+		seq.imm = true;
+		seq.value = primary == 11 ? (int64_t)(int16_t)DFORM_D(inst) : DFORM_UI(inst);
+		return true;
+	}
+	if (primary != 31 || (inst & 1) || (inst >> 22) & 1)
+		return false;
+	uint32_t xo = (inst >> 1) & 0x3ff;
+	if (xo != 0 && xo != 32)
+		return false;
+	if (XFORM_RA(inst) != seq.rt || XFORM_RB(inst) == seq.rt)
+		return false;
+	bf = XFORM_BF(inst);
+	seq.imm = false;
+	seq.rx = XFORM_RB(inst);
+	return true;
+}
+
+bool PpcMatchAtomic(const uint8_t *data, size_t len, uint64_t addr, AtomicSequence &seq) {
+	size_t n = len / 4;
+	if (n < 3)
+		return false;
+	uint32_t w0 = Word(data, 0);
+	seq.size = PpcLarxSize(w0);
+	if (!seq.size)
+		return false;
+	seq.rt = XFORM_RS(w0);
+	seq.ra = XFORM_RA(w0);
+	seq.rb = XFORM_RB(w0);
+	if (seq.rt == seq.ra || seq.rt == seq.rb)
+		return false;
+
+	uint64_t target;
+	uint32_t w1 = Word(data, 1);
+	uint32_t w2 = Word(data, 2);
+
+	// larx rt; stcx. rs; bne- loop
+	if (IsStcx(w1, seq) && IsBranchFalse(w2, 2, addr + 8, target) && target == addr) {
+		seq.op = AtomicOp::Swap;
+		seq.rs = XFORM_RS(w1);
+		seq.imm = false;
+		seq.count = 3;
+		return true;
+	}
+	if (n < 4)
+		return false;
+	uint32_t w3 = Word(data, 3);
+
+	// larx rt; op rs, rt, x; stcx. rs; bne- loop
+	if (MatchOp(w1, seq) && seq.rs != seq.ra && seq.rs != seq.rb && (seq.imm || seq.rx != seq.rt)) {
+		if (IsStcx(w2, seq) && XFORM_RS(w2) == seq.rs &&
+				IsBranchFalse(w3, 2, addr + 12, target) && target == addr) {
+			seq.count = 4;
+			return true;
+		}
+		return false;
+	}
+	if (n < 5)
+		return false;
+	uint32_t w4 = Word(data, 4);
+
+	// larx rt; cmp crf, rt, x; bne- crf, fail; stcx. rs; bne- loop
+	uint32_t bf;
+	if (!MatchCompare(w1, seq, bf))
+		return false;
+	if (!IsBranchFalse(w2, bf * 4 + 2, addr + 8, seq.fail) || seq.fail < addr + 20)
+		return false;
+	if (!IsStcx(w3, seq) || !IsBranchFalse(w4, 2, addr + 16, target) || target != addr)
+		return false;
+	seq.op = AtomicOp::Cas;
+	seq.rs = XFORM_RS(w3);
+	seq.count = 5;
+	return true;
+}
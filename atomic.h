@@ -0,0 +1,66 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Recognizer for load-reserve/store-conditional retry loops.
+ *
+ * Compilers emit every atomic read-modify-write, exchange and
+ * compare-exchange as a larx ... stcx. / bne- loop. The lifter matches
+ * these at the larx and lifts the whole loop as one atomic intrinsic, so
+ * the retry edge never reaches LLIL. Instruction info and text treat the
+ * loop as one instruction of the same length, so no block boundary falls
+ * inside it.
+ */
+
+enum class AtomicOp : uint8_t {
+	Add,
+	Sub,
+	And,
+	Andc,
+	Or,
+	Xor,
+	Swap,
+	Cas,
+};
+
+// lwarx, cmpw, bne- cr7, stwcx., bne- is the longest sequence matched
+#define ATOMIC_MAX_INSNS 5
+
+struct AtomicSequence {
+	AtomicOp op;
+	uint8_t count;		// instructions covered, starting at the larx
+	uint8_t size;		// access size in bytes
+	uint8_t rt;		// receives the old value
+	uint8_t ra, rb;		// address operands of the larx/stcx. pair
+	uint8_t rs;		// register stored by the stcx.
+	uint8_t rx;		// operand or expected-value register
+	bool imm;		// operand is value, not rx
+	int64_t value;
+	uint32_t middle;	// the op (RMW) or compare (CAS) instruction
+	uint64_t fail;		// CAS: where the compare-failed branch goes
+};
+
+// Matches a reservation loop at addr. data holds up to len bytes.
+bool PpcMatchAtomic(const uint8_t *data, size_t len, uint64_t addr, AtomicSequence &seq);
+
+// Access size of a larx (lbarx/lharx/lwarx/ldarx) or stcx., or 0.
+size_t PpcLarxSize(uint32_t inst);
+size_t PpcStcxSize(uint32_t inst);
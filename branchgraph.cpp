@@ -0,0 +1,120 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "branchgraph.h"
+#include "decoder.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <thread>
+
+#define GRAPH_CHUNK_WORDS (256 * 1024)
+
+static void ScanChunk(const uint8_t *data, size_t words, uint64_t addr, PpcBranchGraph &g) {
+	for (size_t i = 0; i < words; i++) {
+		uint32_t inst = ReadInstruction(data + i * 4);
+		uint32_t primary = inst >> 26;
+		// Only these can branch; skip the decoder for everything else
+		if (primary != 16 && primary != 18 && primary != 19)
+			continue;
+		uint64_t pc = addr + i * 4;
+		uint32_t flags = RECORD_FLAGS(PpcDecoder::Decode(inst, pc));
+		if (!(flags & INSN_VALID))
+			continue;
+
+		bool conditional = flags & INSN_CONDITIONAL;
+		if (flags & INSN_BRANCH) {
+			g.source.push_back(pc);
+			g.target.push_back(PpcDecoder::BranchTarget(inst, pc));
+			if (flags & INSN_CALL)
+				g.kind.push_back(conditional ? PpcBranchKind::ConditionalCall : PpcBranchKind::Call);
+			else
+				g.kind.push_back(conditional ? PpcBranchKind::Conditional : PpcBranchKind::Jump);
+		} else if (flags & INSN_RETURN) {
+			g.indirectSource.push_back(pc);
+			g.indirectKind.push_back(conditional ? PpcBranchKind::ConditionalReturn : PpcBranchKind::Return);
+		} else if (flags & INSN_INDIRECT) {
+			g.indirectSource.push_back(pc);
+			g.indirectKind.push_back(conditional ? PpcBranchKind::ConditionalIndirect : PpcBranchKind::Indirect);
+		} else if (primary == 19 && (inst & 1)) {
+			// bclrl/bcctrl carry no record flags; they are calls
+			uint32_t xo = (inst >> 1) & 0x3ff;
+			if (xo == 16 || xo == 528) {
+				g.indirectSource.push_back(pc);
+				g.indirectKind.push_back(PpcBranchKind::IndirectCall);
+			}
+		}
+	}
+}
+
+template <typename T>
+static void Append(std::vector<T> &dst, const std::vector<T> &src) {
+	dst.insert(dst.end(), src.begin(), src.end());
+}
+
+void PpcBuildBranchGraph(const uint8_t *data, size_t len, uint64_t addr, PpcBranchGraph &graph, size_t threads) {
+	size_t words = len / 4;
+	size_t count = (words + GRAPH_CHUNK_WORDS - 1) / GRAPH_CHUNK_WORDS;
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// Chunks are scanned in address order, so concatenating the parts in
+	// chunk order keeps every array sorted by source.
+	std::vector<PpcBranchGraph> parts(count);
+	{
+		ThreadPool pool(std::min(threads, std::max<size_t>(count, 1)), false);
+		for (size_t c = 0; c < count; c++) {
+			pool.Enqueue([&, c]() {
+				size_t first = c * GRAPH_CHUNK_WORDS;
+				size_t n = std::min<size_t>(GRAPH_CHUNK_WORDS, words - first);
+				ScanChunk(data + first * 4, n, addr + first * 4, parts[c]);
+			});
+		}
+		// The pool's destructor waits for the queue to drain
+	}
+
+	graph = PpcBranchGraph();
+	for (auto &p : parts) {
+		Append(graph.source, p.source);
+		Append(graph.target, p.target);
+		Append(graph.kind, p.kind);
+		Append(graph.indirectSource, p.indirectSource);
+		Append(graph.indirectKind, p.indirectKind);
+	}
+
+	graph.byTarget.resize(graph.source.size());
+	for (size_t i = 0; i < graph.byTarget.size(); i++)
+		graph.byTarget[i] = i;
+	std::stable_sort(graph.byTarget.begin(), graph.byTarget.end(), [&](uint32_t a, uint32_t b) {
+		return graph.target[a] < graph.target[b];
+	});
+}
+
+std::pair<size_t, size_t> PpcBranchGraph::EdgesTo(uint64_t addr) const {
+	auto lo = std::lower_bound(byTarget.begin(), byTarget.end(), addr, [&](uint32_t i, uint64_t a) {
+		return target[i] < a;
+	});
+	auto hi = std::upper_bound(lo, byTarget.end(), addr, [&](uint64_t a, uint32_t i) {
+		return a < target[i];
+	});
+	return {lo - byTarget.begin(), hi - byTarget.begin()};
+}
+
+std::pair<size_t, size_t> PpcBranchGraph::EdgesFrom(uint64_t start, uint64_t end) const {
+	auto lo = std::lower_bound(source.begin(), source.end(), start);
+	auto hi = std::lower_bound(lo, source.end(), end);
+	return {lo - source.begin(), hi - source.begin()};
+}
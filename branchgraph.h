@@ -0,0 +1,66 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+ * Branch/call skeleton of a code range, built straight from the raw bytes
+ * with the decoder's branch flags, without any function analysis.
+ */
+
+enum class PpcBranchKind : uint8_t {
+	Jump,			// b, bc always
+	Conditional,		// bc
+	Call,			// bl
+	ConditionalCall,	// bcl
+	Return,			// blr
+	ConditionalReturn,	// beqlr, bdnzlr, ...
+	Indirect,		// bctr
+	ConditionalIndirect,	// bcctr with a condition
+	IndirectCall,		// bctrl, blrl, ...
+};
+
+// Whether the word after a branch of this kind is also a successor
+static inline bool PpcFallsThrough(PpcBranchKind kind) {
+	return kind != PpcBranchKind::Jump && kind != PpcBranchKind::Return && kind != PpcBranchKind::Indirect;
+}
+
+struct PpcBranchGraph {
+	// Direct branches and calls, sorted by source address
+	std::vector<uint64_t> source;
+	std::vector<uint64_t> target;
+	std::vector<PpcBranchKind> kind;
+
+	// Returns and branches through LR/CTR, sorted by address
+	std::vector<uint64_t> indirectSource;
+	std::vector<PpcBranchKind> indirectKind;
+
+	// Direct edge indices ordered by target, for predecessor queries
+	std::vector<uint32_t> byTarget;
+
+	// [first, last) positions in byTarget of the edges into addr
+	std::pair<size_t, size_t> EdgesTo(uint64_t addr) const;
+	// [first, last) indices of the edges out of [start, end)
+	std::pair<size_t, size_t> EdgesFrom(uint64_t start, uint64_t end) const;
+};
+
+// Scans len bytes of code at addr on threads workers (0 = one per core).
+void PpcBuildBranchGraph(const uint8_t *data, size_t len, uint64_t addr, PpcBranchGraph &graph, size_t threads = 0);
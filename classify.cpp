@@ -0,0 +1,96 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "classify.h"
+
+#include "decoder.h"
+#include "regmask.h"
+
+#define SCORE_VALID	1
+#define SCORE_INVALID	-4
+#define SCORE_RESERVED	-3
+#define SCORE_ESCAPE	-2	// jump out of the range
+#define SCORE_REG	-2	// implausible register write
+
+// Windows scoring below this are data
+#define WINDOW_THRESHOLD 0
+
+// r1 is only written by stack adjustment, r2 by TOC setup, r13 never
+static bool ImplausibleWrite(uint32_t inst, uint64_t defs) {
+	uint32_t primary = inst >> 26;
+	if (defs & REGMASK_GPR(13))
+		return true;
+	if (defs & REGMASK_GPR(1)) {
+		switch (primary) {
+		case 14:	// addi
+		case 15:	// addis
+		case 37:	// stwu
+		case 58:	// ld
+		case 62:	// stdu
+		case 31:	// mr, stdux, add
+			return false;
+		}
+		return true;
+	}
+	if (defs & REGMASK_GPR(2)) {
+		switch (primary) {
+		case 14:
+		case 15:
+		case 58:
+		case 31:
+			return false;
+		}
+		return true;
+	}
+	return false;
+}
+
+int PpcScoreWord(uint32_t inst, uint64_t addr, uint64_t lo, uint64_t hi) {
+	uint32_t flags = RECORD_FLAGS(PpcDecoder::Decode(inst, addr));
+	if (!(flags & INSN_VALID))
+		return SCORE_INVALID;
+	if (flags & INSN_RESERVED)
+		return SCORE_RESERVED;
+	if ((flags & (INSN_BRANCH | INSN_CALL)) == INSN_BRANCH) {
+		uint64_t dst = PpcDecoder::BranchTarget(inst, addr);
+		if (dst < lo || dst >= hi)
+			return SCORE_ESCAPE;
+	}
+	PpcRegUsage u = PpcGetRegUsage(inst);
+	if (!(u.defs & REGMASK_UNKNOWN) && ImplausibleWrite(inst, u.defs))
+		return SCORE_REG;
+	return SCORE_VALID;
+}
+
+void PpcClassifyRange(const uint8_t *data, size_t len, uint64_t addr, std::vector<PpcRegion> &regions) {
+	size_t count = len / 4;
+	uint64_t hi = addr + count * 4;
+	size_t first = regions.size();
+	for (size_t i = 0; i < count; i += CLASSIFY_WINDOW_WORDS) {
+		size_t n = count - i < CLASSIFY_WINDOW_WORDS ? count - i : CLASSIFY_WINDOW_WORDS;
+		int score = 0;
+		for (size_t j = 0; j < n; j++) {
+			uint64_t a = addr + (i + j) * 4;
+			score += PpcScoreWord(ReadInstruction(data + (i + j) * 4), a, addr, hi);
+		}
+		uint64_t start = addr + i * 4;
+		bool code = score >= WINDOW_THRESHOLD;
+		if (regions.size() > first && regions.back().code == code)
+			regions.back().end = start + n * 4;
+		else
+			regions.push_back({start, start + n * 4, code});
+	}
+}
@@ -0,0 +1,47 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Code/data classification of raw bytes, for executable segments that
+ * embed literal pools, jump tables or strings.
+ *
+ * Every word gets a score from the decoder flags (invalid, reserved
+ * fields, invalid forms) and its register use (writes to r1, r2 and r13
+ * that compilers never emit). Scores are summed over fixed windows and
+ * neighbouring windows of the same class are merged into regions.
+ */
+
+#define CLASSIFY_WINDOW_WORDS 16
+
+struct PpcRegion {
+	uint64_t start;
+	uint64_t end;
+	bool code;
+};
+
+// Score of one word at addr; negative means it looks like data. Direct
+// jumps are penalized when they leave [lo, hi).
+int PpcScoreWord(uint32_t inst, uint64_t addr, uint64_t lo, uint64_t hi);
+
+// Classifies big-endian words in [addr, addr+len) and appends the regions
+// in address order. len is rounded down to whole words.
+void PpcClassifyRange(const uint8_t *data, size_t len, uint64_t addr, std::vector<PpcRegion> &regions);
@@ -17,13 +17,14 @@
 bool DECODE_MAIN(const uint8_t *data, uint64_t addr) {
 	uint32_t inst = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
 	uint32_t op = inst >> 26;
-	char buf[16];
+#ifdef EMIT_IL
 	ExprId ei0, ei1;
 	ExprId ea;
-	ExprId cond, ctrValue;
-	BNLowLevelILLabel *label1, *label2;
+	ExprId cond;
+	bool negate;
 	uint64_t dst;
 	size_t regWidth = 8;
+#endif
 	switch (op) {
 case 0:
 	/* Illegal/Reserved */
@@ -34,22 +35,28 @@ case 1:
 case 2:
 #if   defined(EMIT_ASM)
 	Op("tdi");
+	Imm(DFORM_RT(inst));
+	Reg(DFORM_RA(inst));
+	Imm(DFORM_SI(inst));
 #elif defined(EMIT_IL)
 	/* tdi */
-	il->AddInstruction(il->Unimplemented());
+	LiftTrap(inst, 8, il->Register(8, DFORM_RA(inst)), il->Const(8, SEXT16(DFORM_D(inst))));
 #endif
 	return true;
 case 3:
 #if   defined(EMIT_ASM)
 	Op("twi");
+	Imm(DFORM_RT(inst));
+	Reg(DFORM_RA(inst));
+	Imm(DFORM_SI(inst));
 #elif defined(EMIT_IL)
 	/* twi */
-	il->AddInstruction(il->Unimplemented());
+	LiftTrap(inst, 4, il->Register(4, DFORM_RA(inst)), il->Const(4, SEXT16(DFORM_D(inst))));
 #endif
 	return true;
 case 4:
-	/* Reserved */
-	return false;
+	/* VMX */
+	return DECODE_GROUP(Vector)(inst);
 case 5:
 	/* Reserved */
 	return false;
@@ -100,7 +107,7 @@ case 10:
 	il->AddInstruction(il->SetFlag(DFORM_BF(inst)*4+0, il->CompareUnsignedLessThan(regWidth, ei0, ei1)));
 	il->AddInstruction(il->SetFlag(DFORM_BF(inst)*4+1, il->CompareUnsignedGreaterThan(regWidth, ei0, ei1)));
 	il->AddInstruction(il->SetFlag(DFORM_BF(inst)*4+2, il->CompareEqual(regWidth, ei0, ei1)));
-	il->AddInstruction(il->SetFlag(DFORM_BF(inst)*4+3, il->Flag(FLAG_XER_SO)));
+	SetSummaryOverflow(DFORM_BF(inst)*4+3);
 #endif
 	return true;
 case 11:
@@ -120,7 +127,7 @@ case 11:
 	il->AddInstruction(il->SetFlag(DFORM_BF(inst)*4+0, il->CompareSignedLessThan(regWidth, ei0, ei1)));
 	il->AddInstruction(il->SetFlag(DFORM_BF(inst)*4+1, il->CompareSignedGreaterThan(regWidth, ei0, ei1)));
 	il->AddInstruction(il->SetFlag(DFORM_BF(inst)*4+2, il->CompareEqual(regWidth, ei0, ei1)));
-	il->AddInstruction(il->SetFlag(DFORM_BF(inst)*4+3, il->Flag(FLAG_XER_SO)));
+	SetSummaryOverflow(DFORM_BF(inst)*4+3);
 #endif
 	return true;
 case 12:
@@ -133,7 +140,7 @@ case 12:
 	/* addic */
 	ei0 = il->Const(regWidth, SEXT16(DFORM_UI(inst)));
 	ei1 = il->Register(regWidth, DFORM_RA(inst));
-	ei0 = il->Add(regWidth, ei0, ei1, FLAG_WRITE_CA);
+	ei0 = il->Add(regWidth, ei0, ei1, CarryWrite());
 	ei0 = il->SetRegister(regWidth, DFORM_RT(inst), ei0);
 	il->AddInstruction(ei0);
 #endif
@@ -148,7 +155,7 @@ case 13:
 	/* addic. */
 	ei0 = il->Const(regWidth, SEXT16(DFORM_UI(inst)));
 	ei1 = il->Register(regWidth, DFORM_RA(inst));
-	ei0 = il->Add(regWidth, ei0, ei1, FLAG_WRITE_CR0 | FLAG_WRITE_CA);
+	ei0 = il->Add(regWidth, ei0, ei1, Cr0Write() | CarryWrite());
 	ei0 = il->SetRegister(regWidth, DFORM_RT(inst), ei0);
 	il->AddInstruction(ei0);
 #endif
@@ -185,7 +192,7 @@ case 15:
 	if (DFORM_RA(inst) == 0) {
 		/* lis */
 #if   defined(EMIT_ASM)
-		Op("li");
+		Op("lis");
 		Reg(DFORM_RS(inst));
 		Imm(DFORM_UI(inst));
 #elif defined(EMIT_IL)
@@ -201,6 +208,8 @@ case 15:
 		Reg(DFORM_RA(inst));
 		Imm(DFORM_UI(inst));
 #elif defined(EMIT_IL)
+		if (LiftGlobalEntry(addr))
+			return true;
 		ei0 = il->Const(regWidth, SEXT32(DFORM_UI(inst) << 16));
 		ei1 = il->Register(regWidth, DFORM_RA(inst));
 		ei0 = il->Add(regWidth, ei0, ei1);
@@ -213,7 +222,7 @@ case 15:
 #if   defined(EMIT_ASM)
 		{
 			std::string branch_mnemonics[] = {"bc", "bcl", "bca", "bcla"};
-			Op(branch_mnemonics[op&0x3]);
+			Op(branch_mnemonics[inst&0x3]);
 			Imm(BFORM_BO(inst));
 			Imm(BFORM_BI(inst));
 			Imm(BFORM_BD(inst));
@@ -224,47 +233,19 @@ case 15:
 			dst = SEXT16(BFORM_BD(inst));
 		else
 			dst = addr + SEXT16(BFORM_BD(inst));
-		if ((BFORM_BO(inst) & 0b10100) == 0b10100) {
+		if (inst & 0x1)
+			dst = FoldCall(dst);
+		cond = BranchCondition(BFORM_BO(inst), BFORM_BI(inst), negate);
+		if (cond == BN_INVALID_EXPR) {
 			// Branch always
 			if (inst & 0x1)
 				il->AddInstruction(il->Call(il->ConstPointer(8, dst)));
 			else
 				il->AddInstruction(il->Jump(il->ConstPointer(8, dst)));
-			return true;
-		}
-
-		if ((BFORM_BO(inst) & 0b00100) == 0) {
-			// Decrement CTR
-			il->AddInstruction(il->SetRegister(8, PPC_REG_CTR, il->Sub(8, il->Register(8, PPC_REG_CTR), il->Const(8, 1))));
-			if (BFORM_BO(inst) & 0b00010)
-				cond = il->CompareEqual(8, il->Register(8, PPC_REG_CTR), il->Const(8, 0));
-			else
-				cond = il->CompareNotEqual(8, il->Register(8, PPC_REG_CTR), il->Const(8, 0));
-		}
-		if ((BFORM_BO(inst) & 0b10000) == 0) {
-			// Check CR_BI
-			ei0 = il->Flag(BFORM_BI(inst));
-			ei0 = il->CompareEqual(1, ei0, il->Const(1, (BFORM_BO(inst) >> 3) & 1));
-			if ((BFORM_BO(inst) & 0b00100) == 0)
-				cond = il->And(1, cond, ei0);
-			else
-				cond = ei0;
-		}
-
-		if (inst & 0x1) {
-			LowLevelILLabel callLabel;
-			label1 = il->GetLabelForAddress(arch, addr+4);
-			if (label1) {
-				il->AddInstruction(il->If(cond, callLabel, *label2));
-				il->MarkLabel(callLabel);
-				il->AddInstruction(il->Call(addr+4));
-			}
+		} else if (inst & 0x1) {
+			BranchIf(cond, negate, il->Call(il->ConstPointer(8, dst)));
 		} else {
-			label1 = il->GetLabelForAddress(arch, dst);
-			label2 = il->GetLabelForAddress(arch, addr+4);
-			if (label1 && label2) {
-				il->AddInstruction(il->If(cond, *label1, *label2));
-			}
+			ConditionalJump(cond, negate, dst, addr+4);
 		}
 #endif
 		return true;
@@ -280,7 +261,7 @@ case 15:
 #if   defined(EMIT_ASM)
 		{
 			std::string branch_mnemonics[] = {"b", "bl", "ba", "bla"};
-			Op(branch_mnemonics[op&0x3]);
+			Op(branch_mnemonics[inst&0x3]);
 			Imm(IFORM_LI(inst));
 		}
 #elif defined(EMIT_IL)
@@ -290,12 +271,24 @@ case 15:
 		else
 			dst = addr + SEXT26(IFORM_LI(inst));
 		if (inst & 0x1)
-			il->AddInstruction(il->Call(il->ConstPointer(8, dst)));
+			il->AddInstruction(il->Call(il->ConstPointer(8, FoldCall(dst))));
 		else
 			il->AddInstruction(il->Jump(il->ConstPointer(8, dst)));
 #endif
 		return true;
 case 19:
+	if (((inst >> 1) & 0x1f) == 2) {
+#if   defined(EMIT_ASM)
+		Op("addpcis");
+		Reg(DXFORM_RT(inst));
+		Imm(SEXT16(DXFORM_D(inst)));
+#elif defined(EMIT_IL)
+		/* addpcis: relative to the next instruction */
+		ei0 = il->ConstPointer(regWidth, addr + 4 + (SEXT16(DXFORM_D(inst)) << 16));
+		il->AddInstruction(il->SetRegister(regWidth, DXFORM_RT(inst), ei0));
+#endif
+		return true;
+	}
 	return DECODE_GROUP(19)(inst);
 case 20:
 #if   defined(EMIT_ASM)
@@ -409,7 +402,7 @@ case 28:
 	ei1 = il->Const(regWidth, DFORM_UI(inst));
 	ei0 = il->Register(regWidth, DFORM_RS(inst));
 	ei0 = il->And(regWidth, ei0, ei1);
-	ei0 = il->SetRegister(regWidth, DFORM_RA(inst), ei0, FLAG_WRITE_CR0);
+	ei0 = il->SetRegister(regWidth, DFORM_RA(inst), ei0, Cr0Write());
 	il->AddInstruction(ei0);
 #endif
 	return true;
@@ -424,7 +417,7 @@ case 29:
 	ei1 = il->Const(regWidth, DFORM_UI(inst) << 16);
 	ei0 = il->Register(regWidth, DFORM_RS(inst));
 	ei0 = il->And(regWidth, ei0, ei1);
-	ei0 = il->SetRegister(regWidth, DFORM_RA(inst), ei0, FLAG_WRITE_CR0);
+	ei0 = il->SetRegister(regWidth, DFORM_RA(inst), ei0, Cr0Write());
 	il->AddInstruction(ei0);
 #endif
 	return true;
@@ -705,105 +698,153 @@ case 45:
 #endif
 	return true;
 case 46:
+	/* lmw */
 #if   defined(EMIT_ASM)
 	Op("lmw");
+	Reg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* lmw */
-	il->AddInstruction(il->Unimplemented());
+	LiftBlockLoad(DFORM_RT(inst), DFORM_RA(inst), (int64_t)SEXT16(DFORM_D(inst)), 4 * (32 - DFORM_RT(inst)));
 #endif
 	return true;
 case 47:
+	/* stmw */
 #if   defined(EMIT_ASM)
 	Op("stmw");
+	Reg(DFORM_RS(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* stmw */
-	il->AddInstruction(il->Unimplemented());
+	LiftBlockStore(DFORM_RS(inst), DFORM_RA(inst), (int64_t)SEXT16(DFORM_D(inst)), 4 * (32 - DFORM_RS(inst)));
 #endif
 	return true;
 case 48:
+	/* lfs */
 #if   defined(EMIT_ASM)
 	Op("lfs");
+	FReg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* lfs */
-	il->AddInstruction(il->Unimplemented());
+	il->AddInstruction(SetFReg(DFORM_RT(inst), il->FloatConvert(8, il->Load(4, AddressD(DFORM_RA(inst), DFORM_D(inst))))));
 #endif
 	return true;
 case 49:
+	/* lfsu */
+	if (DFORM_RA(inst) == 0)
+		return false;
 #if   defined(EMIT_ASM)
 	Op("lfsu");
+	FReg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* lfsu */
-	il->AddInstruction(il->Unimplemented());
+	il->AddInstruction(SetFReg(DFORM_RT(inst), il->FloatConvert(8, il->Load(4, AddressD(DFORM_RA(inst), DFORM_D(inst))))));
+	il->AddInstruction(il->SetRegister(regWidth, DFORM_RA(inst), AddressD(DFORM_RA(inst), DFORM_D(inst))));
 #endif
 	return true;
 case 50:
+	/* lfd */
 #if   defined(EMIT_ASM)
 	Op("lfd");
+	FReg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* lfd */
-	il->AddInstruction(il->Unimplemented());
+	il->AddInstruction(SetFReg(DFORM_RT(inst), il->Load(8, AddressD(DFORM_RA(inst), DFORM_D(inst)))));
 #endif
 	return true;
 case 51:
+	/* lfdu */
+	if (DFORM_RA(inst) == 0)
+		return false;
 #if   defined(EMIT_ASM)
 	Op("lfdu");
+	FReg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* lfdu */
-	il->AddInstruction(il->Unimplemented());
+	il->AddInstruction(SetFReg(DFORM_RT(inst), il->Load(8, AddressD(DFORM_RA(inst), DFORM_D(inst)))));
+	il->AddInstruction(il->SetRegister(regWidth, DFORM_RA(inst), AddressD(DFORM_RA(inst), DFORM_D(inst))));
 #endif
 	return true;
 case 52:
+	/* stfs */
 #if   defined(EMIT_ASM)
 	Op("stfs");
+	FReg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* stfs */
-	il->AddInstruction(il->Unimplemented());
+	il->AddInstruction(il->Store(4, AddressD(DFORM_RA(inst), DFORM_D(inst)), il->FloatConvert(4, FReg(DFORM_RS(inst)))));
 #endif
 	return true;
 case 53:
+	/* stfsu */
+	if (DFORM_RA(inst) == 0)
+		return false;
 #if   defined(EMIT_ASM)
 	Op("stfsu");
+	FReg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* stfsu */
-	il->AddInstruction(il->Unimplemented());
+	il->AddInstruction(il->Store(4, AddressD(DFORM_RA(inst), DFORM_D(inst)), il->FloatConvert(4, FReg(DFORM_RS(inst)))));
+	il->AddInstruction(il->SetRegister(regWidth, DFORM_RA(inst), AddressD(DFORM_RA(inst), DFORM_D(inst))));
 #endif
 	return true;
 case 54:
+	/* stfd */
 #if   defined(EMIT_ASM)
 	Op("stfd");
+	FReg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* stfd */
-	il->AddInstruction(il->Unimplemented());
+	il->AddInstruction(il->Store(8, AddressD(DFORM_RA(inst), DFORM_D(inst)), FReg(DFORM_RS(inst))));
 #endif
 	return true;
 case 55:
+	/* stfdu */
+	if (DFORM_RA(inst) == 0)
+		return false;
 #if   defined(EMIT_ASM)
 	Op("stfdu");
+	FReg(DFORM_RT(inst));
+	Disp(DFORM_RA(inst), SEXT16(DFORM_D(inst)));
 #elif defined(EMIT_IL)
-	/* stfdu */
-	il->AddInstruction(il->Unimplemented());
+	il->AddInstruction(il->Store(8, AddressD(DFORM_RA(inst), DFORM_D(inst)), FReg(DFORM_RS(inst))));
+	il->AddInstruction(il->SetRegister(regWidth, DFORM_RA(inst), AddressD(DFORM_RA(inst), DFORM_D(inst))));
 #endif
 	return true;
 case 56:
 	/* Reserved */
 	return false;
 case 57:
-	/* Reserved */
-	return false;
+	/* lxsd/lxssp */
+	return DECODE_GROUP(Vector)(inst);
 case 58:
 	return DECODE_GROUP(58)(inst);
 case 59:
+#if   defined(EMIT_IL)
+	if (!DECODE_GROUP(59)(inst))
+		return false;
+	if (inst & 1)
+		SetCr1();
+	return true;
+#else
 	return DECODE_GROUP(59)(inst);
+#endif
 case 60:
-	/* Reserved */
-	return false;
+	/* VSX */
+	return DECODE_GROUP(Vector)(inst);
 case 61:
-	/* Reserved */
-	return false;
+	/* stxsd/stxssp/lxv/stxv */
+	return DECODE_GROUP(Vector)(inst);
 case 62:
 	return DECODE_GROUP(62)(inst);
 case 63:
+#if   defined(EMIT_IL)
+	if (!DECODE_GROUP(63)(inst))
+		return false;
+	if ((inst & 1) && !XFORM_FCMP(inst))
+		SetCr1();
+	return true;
+#else
 	return DECODE_GROUP(63)(inst);
+#endif
 default:
 	return false;
 }
@@ -811,27 +852,132 @@ default:
 
 bool DECODE_GROUP(19)(uint32_t inst) {
 	uint32_t op = (inst >> 1) & 0b1111111111;
+#ifdef EMIT_IL
+	ExprId cond, target, a, b;
+	bool negate;
+#endif
 	switch (op) {
-	case 150:
+	case 0:
 #if   defined(EMIT_ASM)
-		Op("isync");
+		Op("mcrf");
+		Imm(XLFORM_BF(inst));
+		Imm(XLFORM_BFA(inst));
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::isync), {}));
+		/* mcrf */
+		for (uint32_t i = 0; i < 4; i++)
+			il->AddInstruction(il->SetFlag(XLFORM_BF(inst) * 4 + i, il->Flag(XLFORM_BFA(inst) * 4 + i)));
 #endif
 		return true;
-	default:
+	case 18:
+	case 274:
 #if   defined(EMIT_ASM)
+		Op(op == 18 ? "rfid" : "hrfid");
 #elif defined(EMIT_IL)
+		/* rfid/hrfid */
 		il->AddInstruction(il->Unimplemented());
 #endif
 		return true;
-		//return false;
+	case 33:
+	case 129:
+	case 193:
+	case 225:
+	case 257:
+	case 289:
+	case 417:
+	case 449:
+#if   defined(EMIT_ASM)
+		switch (op) {
+		case 33: Op("crnor"); break;
+		case 129: Op("crandc"); break;
+		case 193: Op("crxor"); break;
+		case 225: Op("crnand"); break;
+		case 257: Op("crand"); break;
+		case 289: Op("creqv"); break;
+		case 417: Op("crorc"); break;
+		default: Op("cror"); break;
+		}
+		Imm(XLFORM_BT(inst));
+		Imm(XLFORM_BA(inst));
+		Imm(XLFORM_BB(inst));
+#elif defined(EMIT_IL)
+		/* crnor/crandc/crxor/crnand/crand/creqv/crorc/cror */
+		a = il->Flag(XLFORM_BA(inst));
+		b = il->Flag(XLFORM_BB(inst));
+		switch (op) {
+		case 33: cond = il->CompareEqual(1, il->Or(1, a, b), il->Const(1, 0)); break;
+		case 129: cond = il->And(1, a, il->CompareEqual(1, b, il->Const(1, 0))); break;
+		case 193:
+			// crclr
+			if (XLFORM_BA(inst) == XLFORM_BB(inst))
+				cond = il->Const(1, 0);
+			else
+				cond = il->Xor(1, a, b);
+			break;
+		case 225: cond = il->CompareEqual(1, il->And(1, a, b), il->Const(1, 0)); break;
+		case 257: cond = il->And(1, a, b); break;
+		case 289:
+			// crset
+			if (XLFORM_BA(inst) == XLFORM_BB(inst))
+				cond = il->Const(1, 1);
+			else
+				cond = il->CompareEqual(1, a, b);
+			break;
+		case 417: cond = il->Or(1, a, il->CompareEqual(1, b, il->Const(1, 0))); break;
+		default: cond = il->Or(1, a, b); break;
+		}
+		il->AddInstruction(il->SetFlag(XLFORM_BT(inst), cond));
+#endif
+		return true;
+	case 16:
+	case 528:
+		/* bclr/bclrl/bcctr/bcctrl */
+		if (op == 528 && !(BFORM_BO(inst) & 0b00100))
+			return false;	// bcctr can't decrement CTR
+#if   defined(EMIT_ASM)
+		if ((BFORM_BO(inst) & 0b10100) == 0b10100) {
+			std::string mnemonics[] = {"blr", "blrl", "bctr", "bctrl"};
+			Op(mnemonics[(op == 528) * 2 + (inst & 1)]);
+		} else {
+			std::string mnemonics[] = {"bclr", "bclrl", "bcctr", "bcctrl"};
+			Op(mnemonics[(op == 528) * 2 + (inst & 1)]);
+			Imm(BFORM_BO(inst));
+			Imm(BFORM_BI(inst));
+			Imm((inst >> 11) & 3);
+		}
+#elif defined(EMIT_IL)
+		// Read the target before the CTR decrement
+		target = il->Register(8, op == 528 ? PPC_REG_CTR : PPC_REG_LR);
+		cond = BranchCondition(BFORM_BO(inst), BFORM_BI(inst), negate);
+		if (inst & 1)
+			target = il->Call(target);
+		else if (op == 16)
+			target = il->Return(target);
+		else
+			target = il->Jump(target);
+		if (cond == BN_INVALID_EXPR)
+			il->AddInstruction(target);
+		else
+			BranchIf(cond, negate, target);
+#endif
+		return true;
+	case 150:
+#if   defined(EMIT_ASM)
+		Op("isync");
+#elif defined(EMIT_IL)
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::isync), {}));
+#endif
+		return true;
+	default:
+		return false;
 	}
 }
 
 bool DECODE_GROUP(30)(uint32_t inst) {
 	uint32_t op = MDSFORM_XO(inst);
+#ifdef EMIT_IL
 	ExprId r, m, mInv;
+#endif
 #define MASK_64 0xffffffffffffffff 
 	switch (op) {
 	case 0:
@@ -965,7 +1111,6 @@ bool DECODE_GROUP(30)(uint32_t inst) {
 
 bool DECODE_GROUP(31)(uint32_t inst) {	
 	uint32_t op = (inst >> 1) & 0b1111111111;
-	char buf[16];
 	switch (op) {
 	case 0:
 #if   defined(EMIT_ASM)
@@ -976,9 +1121,16 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 		return true;
 	case 4:
 #if   defined(EMIT_ASM)
+		if (inst == 0x7fe00008) {
+			Op("trap");
+			return true;
+		}
 		Op("tw");
+		Imm(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Unimplemented());
+		LiftTrap(inst, 4, il->Register(4, XFORM_RA(inst)), il->Register(4, XFORM_RB(inst)));
 #endif
 		return true;
 	case 8:
@@ -1031,10 +1183,21 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 #endif
 		return true;
 	case 20:
+	case 52:
+	case 84:
+	case 116:
+		/* lwarx/lbarx/ldarx/lharx */
 #if   defined(EMIT_ASM)
-		Op("lwarx");
+		Op(op == 20 ? "lwarx" : op == 52 ? "lbarx" : op == 84 ? "ldarx" : "lharx");
+		Reg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Unimplemented());
+		// The reservation is not modelled; see atomic.h for fused loops
+		if (PpcLarxSize(inst) == 8)
+			il->AddInstruction(il->SetRegister(8, XFORM_RS(inst), il->Load(8, AddressX(XFORM_RA(inst), XFORM_RB(inst)))));
+		else
+			il->AddInstruction(il->SetRegister(8, XFORM_RS(inst), il->ZeroExtend(8, il->Load(PpcLarxSize(inst), AddressX(XFORM_RA(inst), XFORM_RB(inst))))));
 #endif
 		return true;
 	case 21:
@@ -1060,7 +1223,7 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 		return true;
 	case 26:
 #if   defined(EMIT_ASM)
-		Op("cntlzw[.]")
+		Op("cntlzw[.]");
 #elif defined(EMIT_IL)
 		il->AddInstruction(il->Unimplemented());
 #endif
@@ -1136,20 +1299,51 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 	case 68:
 #if   defined(EMIT_ASM)
 		Op("td");
+		Imm(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Unimplemented());
+		LiftTrap(inst, 8, il->Register(8, XFORM_RA(inst)), il->Register(8, XFORM_RB(inst)));
+#endif
+		return true;
+	case 150:
+	case 214:
+	case 694:
+	case 726:
+		/* stwcx./stdcx./stbcx./sthcx. */
+		if (!XFORM_Rc(inst))
+			return false;
+#if   defined(EMIT_ASM)
+		Op(op == 150 ? "stwcx." : op == 214 ? "stdcx." : op == 694 ? "stbcx." : "sthcx.");
+		Reg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		// Whether the store happens depends on the reservation
+		il->AddInstruction(il->Intrinsic({RegisterOrFlag::Flag(FLAG_CR0_EQ)}, static_cast<uint32_t>(Intrinsic::stcx), {
+			AddressX(XFORM_RA(inst), XFORM_RB(inst)),
+			il->Register(PpcStcxSize(inst), XFORM_RS(inst))
+		}));
+		il->AddInstruction(il->SetFlag(FLAG_CR0_LT, il->Const(1, 0)));
+		il->AddInstruction(il->SetFlag(FLAG_CR0_GT, il->Const(1, 0)));
+		SetSummaryOverflow(FLAG_CR0_SO);
 #endif
 		return true;
 	case 246:
 #if   defined(EMIT_ASM)
 		Op("dcbtst");
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::dcbtst), {}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::dcbtst), {}));
 #endif
 		return true;
 	case 266:
 	case 778:
 #if   defined(EMIT_ASM)
+		OpRc(op == 778 ? "addo" : "add", inst);
+		Reg(XOFORM_RT(inst));
+		Reg(XOFORM_RA(inst));
+		Reg(XOFORM_RB(inst));
 #elif defined(EMIT_IL)
 		// TODO: OE and Rc flags
 		il->AddInstruction(
@@ -1166,10 +1360,11 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 		Reg(XFORM_RB(inst));
 		Imm(XFORM_L(inst));
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::tlbiel), {
-			il->Register(8, XFORM_RB(inst)),
-			il->Const(1, XFORM_L(inst)),
-		}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::tlbiel), {
+				il->Register(8, XFORM_RB(inst)),
+				il->Const(1, XFORM_L(inst)),
+			}));
 #endif
 		return true;
 	case 278:
@@ -1177,7 +1372,8 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 #if   defined(EMIT_ASM)
 		Op("dcbt");
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::dcbt), {}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::dcbt), {}));
 #endif
 		return true;
 	case 306:
@@ -1186,66 +1382,51 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 		Reg(XFORM_RB(inst));
 		Imm(XFORM_L(inst));
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::tlbie), {
-			il->Register(8, XFORM_RB(inst)),
-			il->Const(1, XFORM_L(inst)),
-		}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::tlbie), {
+				il->Register(8, XFORM_RB(inst)),
+				il->Const(1, XFORM_L(inst)),
+			}));
 #endif
 		return true;
-	case 339:
+	case 339: {
+		const PpcSpr &spr = PpcSprInfo(XFXFORM_SPR(inst));
+		[[maybe_unused]] bool named = spr.name && !(spr.flags & SPR_WRITE);
 #if   defined(EMIT_ASM)
-		switch (XFXFORM_SPR(inst)) {
-		case 1:
-			Op("mfxer");
-			Reg(XFXFORM_RS(inst));
-			break;
-		case 8:
-			Op("mflr");
+		if (named) {
+			Op(spr.mf);
 			Reg(XFXFORM_RS(inst));
-			break;
-		case 9:
-			Op("mfctr");
-			Reg(XFXFORM_RS(inst));
-			break;
-		default:
+		} else {
 			Op("mfspr");
 			Reg(XFXFORM_RS(inst));
 			Imm(XFXFORM_SPR(inst));
-			break;
 		}
 #elif defined(EMIT_IL)
-		switch (XFXFORM_SPR(inst)) {
-		/*case 1:
-			Op("mfxer");
-			Reg(XFXFORM_RS(inst));
-			break;
-		case 8:
-			Op("mflr");
-			Reg(XFXFORM_RS(inst));
-			break;*/
-		case 9:
-			il->AddInstruction(il->SetRegister(8, XFXFORM_RS(inst), il->Register(8, PPC_REG_CTR)));
-			break;
-		default:
+		if (XFXFORM_SPR(inst) == 1) {
+			MoveFromXer(XFXFORM_RS(inst));
+		} else if (named && PpcSprLifts(spr)) {
+			il->AddInstruction(il->SetRegister(8, XFXFORM_RS(inst), il->Register(8, spr.reg)));
+		} else {
 			il->AddInstruction(il->Intrinsic({
 				RegisterOrFlag::Register(XFXFORM_RS(inst))
 			}, static_cast<uint32_t>(Intrinsic::mfspr), {
 				il->Const(2, XFXFORM_SPR(inst)),
 			}));
-			break;
 		}
 #endif
 		return true;
+	}
 	case 402:
 #if   defined(EMIT_ASM)
 		Op("slbmte");
 		Reg(XFORM_RS(inst));
 		Reg(XFORM_RB(inst));
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::slbmte), {
-			il->Register(8, XFORM_RS(inst)),
-			il->Register(8, XFORM_RB(inst)),
-		}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::slbmte), {
+				il->Register(8, XFORM_RS(inst)),
+				il->Register(8, XFORM_RB(inst)),
+			}));
 #endif
 		return true;
 	case 434:
@@ -1253,9 +1434,10 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 		Op("slbie");
 		Reg(XFORM_RB(inst));
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::slbie), {
-			il->Register(8, XFORM_RB(inst)),
-		}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::slbie), {
+				il->Register(8, XFORM_RB(inst)),
+			}));
 #endif
 		return true;
 	case 444:
@@ -1284,61 +1466,69 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 #endif
 		}
 		return true;
-	case 467:
+	case 467: {
+		const PpcSpr &spr = PpcSprInfo(XFXFORM_SPR(inst));
+		[[maybe_unused]] bool named = spr.name && !(spr.flags & SPR_READ);
 #if   defined(EMIT_ASM)
-		switch (XFXFORM_SPR(inst)) {
-		case 1:
-			Op("mtxer");
+		if (named) {
+			Op(spr.mt);
 			Reg(XFXFORM_RS(inst));
-			break;
-		case 8:
-			Op("mtlr");
-			Reg(XFXFORM_RS(inst));
-			break;
-		case 9:
-			Op("mtctr");
-			Reg(XFXFORM_RS(inst));
-			break;
-		default:
+		} else {
 			Op("mtspr");
 			Imm(XFXFORM_SPR(inst));
 			Reg(XFXFORM_RS(inst));
-			break;
 		}
 #elif defined(EMIT_IL)
-		switch (XFXFORM_SPR(inst)) {
-		/*case 1:
-			Op("mtxer");
-			Reg(XFXFORM_RS(inst));
-			break;
-		case 8:
-			Op("mtlr");
-			Reg(XFXFORM_RS(inst));
-			break;*/
-		case 9:
-			il->AddInstruction(il->SetRegister(8, PPC_REG_CTR, il->Register(8, XFXFORM_RS(inst))));
-			break;
-		default:
+		// mtctr is the loop bound of a following bdnz loop
+		if (XFXFORM_SPR(inst) == 1) {
+			MoveToXer(XFXFORM_RS(inst));
+		} else if (named && PpcSprLifts(spr)) {
+			il->AddInstruction(il->SetRegister(8, spr.reg, il->Register(8, XFXFORM_RS(inst))));
+		} else {
 			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::mtspr), {
 				il->Const(2, XFXFORM_SPR(inst)),
 				il->Register(8, XFXFORM_RS(inst)),
 			}));
-			break;
 		}
 #endif
 		return true;
+	}
 	case 370:
 #if   defined(EMIT_ASM)
 		Op("tlbia");
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::tlbia), {}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::tlbia), {}));
 #endif
 		return true;
 	case 566:
 #if   defined(EMIT_ASM)
 		Op("tlbsync");
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::tlbsync), {}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::tlbsync), {}));
+#endif
+		return true;
+	case 597:
+		/* lswi */
+#if   defined(EMIT_ASM)
+		Op("lswi");
+		Reg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Imm(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		LiftBlockLoad(XFORM_RS(inst), XFORM_RA(inst), 0, XFORM_NB(inst));
+#endif
+		return true;
+	case 725:
+		/* stswi */
+#if   defined(EMIT_ASM)
+		Op("stswi");
+		Reg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Imm(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		LiftBlockStore(XFORM_RS(inst), XFORM_RA(inst), 0, XFORM_NB(inst));
 #endif
 		return true;
 	case 598:
@@ -1346,25 +1536,165 @@ bool DECODE_GROUP(31)(uint32_t inst) {
 #if   defined(EMIT_ASM)
 		Op("sync");
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::sync), {}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::sync), {}));
 #endif
 		return true;
 	case 854:
 #if   defined(EMIT_ASM)
 		Op("eieio");
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::eieio), {}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::eieio), {}));
+#endif
+		return true;
+	case 535:
+		/* lfsx */
+#if   defined(EMIT_ASM)
+		Op("lfsx");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->FloatConvert(8, il->Load(4, AddressX(XFORM_RA(inst), XFORM_RB(inst))))));
+#endif
+		return true;
+	case 567:
+		/* lfsux */
+		if (XFORM_RA(inst) == 0)
+			return false;
+#if   defined(EMIT_ASM)
+		Op("lfsux");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->FloatConvert(8, il->Load(4, AddressX(XFORM_RA(inst), XFORM_RB(inst))))));
+		il->AddInstruction(il->SetRegister(8, XFORM_RA(inst), AddressX(XFORM_RA(inst), XFORM_RB(inst))));
+#endif
+		return true;
+	case 599:
+		/* lfdx */
+#if   defined(EMIT_ASM)
+		Op("lfdx");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->Load(8, AddressX(XFORM_RA(inst), XFORM_RB(inst)))));
+#endif
+		return true;
+	case 631:
+		/* lfdux */
+		if (XFORM_RA(inst) == 0)
+			return false;
+#if   defined(EMIT_ASM)
+		Op("lfdux");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->Load(8, AddressX(XFORM_RA(inst), XFORM_RB(inst)))));
+		il->AddInstruction(il->SetRegister(8, XFORM_RA(inst), AddressX(XFORM_RA(inst), XFORM_RB(inst))));
+#endif
+		return true;
+	case 663:
+		/* stfsx */
+#if   defined(EMIT_ASM)
+		Op("stfsx");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(il->Store(4, AddressX(XFORM_RA(inst), XFORM_RB(inst)), il->FloatConvert(4, FReg(XFORM_RS(inst)))));
+#endif
+		return true;
+	case 695:
+		/* stfsux */
+		if (XFORM_RA(inst) == 0)
+			return false;
+#if   defined(EMIT_ASM)
+		Op("stfsux");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(il->Store(4, AddressX(XFORM_RA(inst), XFORM_RB(inst)), il->FloatConvert(4, FReg(XFORM_RS(inst)))));
+		il->AddInstruction(il->SetRegister(8, XFORM_RA(inst), AddressX(XFORM_RA(inst), XFORM_RB(inst))));
+#endif
+		return true;
+	case 727:
+		/* stfdx */
+#if   defined(EMIT_ASM)
+		Op("stfdx");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(il->Store(8, AddressX(XFORM_RA(inst), XFORM_RB(inst)), FReg(XFORM_RS(inst))));
+#endif
+		return true;
+	case 759:
+		/* stfdux */
+		if (XFORM_RA(inst) == 0)
+			return false;
+#if   defined(EMIT_ASM)
+		Op("stfdux");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(il->Store(8, AddressX(XFORM_RA(inst), XFORM_RB(inst)), FReg(XFORM_RS(inst))));
+		il->AddInstruction(il->SetRegister(8, XFORM_RA(inst), AddressX(XFORM_RA(inst), XFORM_RB(inst))));
+#endif
+		return true;
+	case 855:
+		/* lfiwax */
+#if   defined(EMIT_ASM)
+		Op("lfiwax");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		// Raw integer word, no conversion
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->SignExtend(8, il->Load(4, AddressX(XFORM_RA(inst), XFORM_RB(inst))))));
+#endif
+		return true;
+	case 887:
+		/* lfiwzx */
+#if   defined(EMIT_ASM)
+		Op("lfiwzx");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		// Raw integer word, no conversion
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->ZeroExtend(8, il->Load(4, AddressX(XFORM_RA(inst), XFORM_RB(inst))))));
+#endif
+		return true;
+	case 983:
+		/* stfiwx */
+#if   defined(EMIT_ASM)
+		Op("stfiwx");
+		FReg(XFORM_RS(inst));
+		Reg(XFORM_RA(inst));
+		Reg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		// Raw integer word, no conversion
+		il->AddInstruction(il->Store(4, AddressX(XFORM_RA(inst), XFORM_RB(inst)), il->LowPart(4, FReg(XFORM_RS(inst)))));
 #endif
 		return true;
 	case 982:
 #if   defined(EMIT_ASM)
 		Op("icbi");
 #elif defined(EMIT_IL)
-		il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::icbi), {}));
+		if (!SkipBarrier())
+			il->AddInstruction(il->Intrinsic({}, static_cast<uint32_t>(Intrinsic::icbi), {}));
 #endif
 		return true;
 	}
-	return false;
+	// Vector loads, stores and VSR moves
+	return DECODE_GROUP(Vector)(inst);
 }
 
 bool DECODE_GROUP(58)(uint32_t inst) {
@@ -1445,19 +1775,44 @@ bool DECODE_GROUP(58)(uint32_t inst) {
 	}
 }
 
-bool DECODE_GROUP(59)(uint32_t inst) { return false; }
+bool DECODE_GROUP(59)(uint32_t inst) {
+	switch ((inst >> 1) & 0b1111111111) {
+	case 846:
+#if   defined(EMIT_ASM)
+		OpRc("fcfids", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), RoundSingle(il->IntToFloat(8, FReg(XFORM_RB(inst))))));
+#endif
+		return true;
+	case 974:
+#if   defined(EMIT_ASM)
+		OpRc("fcfidus", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		// LLIL has no unsigned int-to-float
+		il->AddInstruction(il->Unimplemented());
+#endif
+		return true;
+	}
+	return DECODE_GROUP(FloatA)(inst, true);
+}
 
 bool DECODE_GROUP(62)(uint32_t inst) {
 	uint32_t op = inst & 0b11;
+#ifdef EMIT_IL
 	size_t regWidth = 8;
 	ExprId ea;
+#endif
 	switch (op) {
 	case 0:
 		/* std */
 #if   defined(EMIT_ASM)
 		Op("std");
-		Reg(DFORM_RT(inst));
-		Disp(DFORM_RA(inst), DFORM_D(inst));
+		Reg(DSFORM_RT(inst));
+		Disp(DSFORM_RA(inst), DSFORM_DS(inst));
 #elif defined(EMIT_IL)
 		if (DFORM_RA(inst) == 0) {
 			ea = il->Const(regWidth, SEXT16(DFORM_D(inst)));
@@ -1474,13 +1829,13 @@ bool DECODE_GROUP(62)(uint32_t inst) {
 		return true;
 	case 1:
 		/* stdu */
+		if (DSFORM_RA(inst) == 0)
+			return false;
 #if   defined(EMIT_ASM)
 		Op("stdu");
-		Reg(DFORM_RT(inst));
-		Disp(DFORM_RA(inst), DFORM_D(inst));
+		Reg(DSFORM_RT(inst));
+		Disp(DSFORM_RA(inst), DSFORM_DS(inst));
 #elif defined(EMIT_IL)
-		if (DFORM_RA(inst) == 0)
-			return false;
 		ea = il->Add(regWidth,
 			il->Register(regWidth, DFORM_RA(inst)),
 			il->Const(regWidth, SEXT16(DFORM_D(inst) & 0xfffc))
@@ -1505,4 +1860,455 @@ bool DECODE_GROUP(62)(uint32_t inst) {
 	}
 }
 
-bool DECODE_GROUP(63)(uint32_t inst) { return false; }
+bool DECODE_GROUP(63)(uint32_t inst) {
+#ifdef EMIT_IL
+	ExprId ei0;
+	uint32_t mask;
+#endif
+	// A-form opcodes use only the low 5 bits of XO; none of them collide
+	// with the X-form opcodes below.
+	if (AFORM_XO(inst) >= 18)
+		return DECODE_GROUP(FloatA)(inst, false);
+
+	switch ((inst >> 1) & 0b1111111111) {
+	case 0:
+#if   defined(EMIT_ASM)
+		Op("fcmpu");
+		Imm(XFORM_BF(inst));
+		FReg(XFORM_RA(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		ei0 = FReg(XFORM_RA(inst));
+		il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+0, il->FloatCompareLessThan(8, ei0, FReg(XFORM_RB(inst)))));
+		il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+1, il->FloatCompareGreaterThan(8, ei0, FReg(XFORM_RB(inst)))));
+		il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+2, il->FloatCompareEqual(8, ei0, FReg(XFORM_RB(inst)))));
+		il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+3, il->FloatCompareUnordered(8, ei0, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 32:
+#if   defined(EMIT_ASM)
+		Op("fcmpo");
+		Imm(XFORM_BF(inst));
+		FReg(XFORM_RA(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		ei0 = FReg(XFORM_RA(inst));
+		il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+0, il->FloatCompareLessThan(8, ei0, FReg(XFORM_RB(inst)))));
+		il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+1, il->FloatCompareGreaterThan(8, ei0, FReg(XFORM_RB(inst)))));
+		il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+2, il->FloatCompareEqual(8, ei0, FReg(XFORM_RB(inst)))));
+		il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+3, il->FloatCompareUnordered(8, ei0, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 8:
+#if   defined(EMIT_ASM)
+		OpRc("fcpsgn", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RA(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		// Sign of FRA, magnitude of FRB
+		ei0 = il->And(8, FReg(XFORM_RA(inst)), il->Const(8, 0x8000000000000000));
+		ei0 = il->Or(8, ei0, il->And(8, FReg(XFORM_RB(inst)), il->Const(8, 0x7fffffffffffffff)));
+		il->AddInstruction(SetFReg(XFORM_RS(inst), ei0));
+#endif
+		return true;
+	case 12:
+#if   defined(EMIT_ASM)
+		OpRc("frsp", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), RoundSingle(FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 14:
+#if   defined(EMIT_ASM)
+		OpRc("fctiw", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->ZeroExtend(8, il->FloatToInt(4, il->RoundToInt(8, FReg(XFORM_RB(inst)))))));
+#endif
+		return true;
+	case 15:
+#if   defined(EMIT_ASM)
+		OpRc("fctiwz", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->ZeroExtend(8, il->FloatToInt(4, il->FloatTrunc(8, FReg(XFORM_RB(inst)))))));
+#endif
+		return true;
+	case 38:
+#if   defined(EMIT_ASM)
+		OpRc("mtfsb1", inst);
+		Imm(XFORM_BT(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->Or(4, il->Register(4, PPC_REG_FPSCR), il->Const(4, 0x80000000u >> XFORM_BT(inst)));
+		il->AddInstruction(il->SetRegister(4, PPC_REG_FPSCR, ei0));
+#endif
+		return true;
+	case 40:
+#if   defined(EMIT_ASM)
+		OpRc("fneg", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->FloatNeg(8, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 64:
+#if   defined(EMIT_ASM)
+		Op("mcrfs");
+		Imm(XFORM_BF(inst));
+		Imm(XFORM_BFA(inst));
+#elif defined(EMIT_IL)
+		for (int i = 0; i < 4; i++) {
+			ei0 = il->And(4, il->Register(4, PPC_REG_FPSCR), il->Const(4, 0x80000000u >> (XFORM_BFA(inst)*4+i)));
+			il->AddInstruction(il->SetFlag(XFORM_BF(inst)*4+i, il->CompareNotEqual(4, ei0, il->Const(4, 0))));
+		}
+#endif
+		return true;
+	case 70:
+#if   defined(EMIT_ASM)
+		OpRc("mtfsb0", inst);
+		Imm(XFORM_BT(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->And(4, il->Register(4, PPC_REG_FPSCR), il->Const(4, ~(0x80000000u >> XFORM_BT(inst))));
+		il->AddInstruction(il->SetRegister(4, PPC_REG_FPSCR, ei0));
+#endif
+		return true;
+	case 72:
+#if   defined(EMIT_ASM)
+		OpRc("fmr", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), FReg(XFORM_RB(inst))));
+#endif
+		return true;
+	case 134:
+#if   defined(EMIT_ASM)
+		OpRc("mtfsfi", inst);
+		Imm(XFORM_BF(inst));
+		Imm(XFORM_U(inst));
+#elif defined(EMIT_IL)
+		mask = 0xf0000000u >> (XFORM_BF(inst)*4);
+		ei0 = il->And(4, il->Register(4, PPC_REG_FPSCR), il->Const(4, ~mask));
+		ei0 = il->Or(4, ei0, il->Const(4, (XFORM_U(inst) << 28) >> (XFORM_BF(inst)*4)));
+		il->AddInstruction(il->SetRegister(4, PPC_REG_FPSCR, ei0));
+#endif
+		return true;
+	case 136:
+#if   defined(EMIT_ASM)
+		OpRc("fnabs", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->FloatNeg(8, il->FloatAbs(8, FReg(XFORM_RB(inst))))));
+#endif
+		return true;
+	case 264:
+#if   defined(EMIT_ASM)
+		OpRc("fabs", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->FloatAbs(8, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 392:
+#if   defined(EMIT_ASM)
+		OpRc("frin", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->RoundToInt(8, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 424:
+#if   defined(EMIT_ASM)
+		OpRc("friz", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->FloatTrunc(8, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 456:
+#if   defined(EMIT_ASM)
+		OpRc("frip", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->Ceil(8, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 488:
+#if   defined(EMIT_ASM)
+		OpRc("frim", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->Floor(8, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 583:
+#if   defined(EMIT_ASM)
+		OpRc("mffs", inst);
+		FReg(XFORM_RS(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->ZeroExtend(8, il->Register(4, PPC_REG_FPSCR))));
+#endif
+		return true;
+	case 711:
+#if   defined(EMIT_ASM)
+		OpRc("mtfsf", inst);
+		Imm(XFLFORM_FLM(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		// Each FLM bit selects one 4-bit FPSCR field
+		mask = 0;
+		for (int i = 0; i < 8; i++) {
+			if (XFLFORM_FLM(inst) & (0x80 >> i))
+				mask |= 0xf0000000u >> (i*4);
+		}
+		ei0 = il->And(4, il->LowPart(4, FReg(XFORM_RB(inst))), il->Const(4, mask));
+		if (mask != 0xffffffff)
+			ei0 = il->Or(4, il->And(4, il->Register(4, PPC_REG_FPSCR), il->Const(4, ~mask)), ei0);
+		il->AddInstruction(il->SetRegister(4, PPC_REG_FPSCR, ei0));
+#endif
+		return true;
+	case 814:
+#if   defined(EMIT_ASM)
+		OpRc("fctid", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->FloatToInt(8, il->RoundToInt(8, FReg(XFORM_RB(inst))))));
+#endif
+		return true;
+	case 815:
+#if   defined(EMIT_ASM)
+		OpRc("fctidz", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->FloatToInt(8, il->FloatTrunc(8, FReg(XFORM_RB(inst))))));
+#endif
+		return true;
+	case 846:
+#if   defined(EMIT_ASM)
+		OpRc("fcfid", inst);
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		il->AddInstruction(SetFReg(XFORM_RS(inst), il->IntToFloat(8, FReg(XFORM_RB(inst)))));
+#endif
+		return true;
+	case 142:
+	case 143:
+	case 942:
+	case 943:
+	case 974:
+#if   defined(EMIT_ASM)
+		switch ((inst >> 1) & 0b1111111111) {
+		case 142: OpRc("fctiwu", inst); break;
+		case 143: OpRc("fctiwuz", inst); break;
+		case 942: OpRc("fctidu", inst); break;
+		case 943: OpRc("fctiduz", inst); break;
+		default: OpRc("fcfidu", inst); break;
+		}
+		FReg(XFORM_RS(inst));
+		FReg(XFORM_RB(inst));
+#elif defined(EMIT_IL)
+		// LLIL has no unsigned float/int conversions
+		il->AddInstruction(il->Unimplemented());
+#endif
+		return true;
+	}
+	return false;
+}
+
+/*
+ * A-form arithmetic shared by groups 59 (single) and 63 (double). Rc=1
+ * forms are completed by the caller (CR1 from FPSCR); the arithmetic does
+ * not model FPSCR status bits.
+ */
+bool DECODE_GROUP(FloatA)(uint32_t inst, bool single) {
+#ifdef EMIT_IL
+	ExprId ei0;
+	LowLevelILLabel trueLabel, falseLabel, doneLabel;
+#endif
+	switch (AFORM_XO(inst)) {
+	case 18:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fdivs" : "fdiv", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatDiv(8, FReg(AFORM_FRA(inst)), FReg(AFORM_FRB(inst)));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 20:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fsubs" : "fsub", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatSub(8, FReg(AFORM_FRA(inst)), FReg(AFORM_FRB(inst)));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 21:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fadds" : "fadd", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatAdd(8, FReg(AFORM_FRA(inst)), FReg(AFORM_FRB(inst)));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 22:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fsqrts" : "fsqrt", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatSqrt(8, FReg(AFORM_FRB(inst)));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 23:
+		/* fsel, double only */
+		if (single)
+			return false;
+#if   defined(EMIT_ASM)
+		OpRc("fsel", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRC(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		// FRT <- (FRA >= 0.0) ? FRC : FRB
+		il->AddInstruction(il->If(il->FloatCompareGreaterEqual(8, FReg(AFORM_FRA(inst)), il->FloatConstDouble(0.0)), trueLabel, falseLabel));
+		il->MarkLabel(trueLabel);
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), FReg(AFORM_FRC(inst))));
+		il->AddInstruction(il->Goto(doneLabel));
+		il->MarkLabel(falseLabel);
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), FReg(AFORM_FRB(inst))));
+		il->MarkLabel(doneLabel);
+#endif
+		return true;
+	case 24:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fres" : "fre", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		// Reciprocal estimate, lifted as the exact value
+		ei0 = il->FloatDiv(8, il->FloatConstDouble(1.0), FReg(AFORM_FRB(inst)));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 25:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fmuls" : "fmul", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRC(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatMult(8, FReg(AFORM_FRA(inst)), FReg(AFORM_FRC(inst)));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 26:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "frsqrtes" : "frsqrte", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatDiv(8, il->FloatConstDouble(1.0), il->FloatSqrt(8, FReg(AFORM_FRB(inst))));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 28:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fmsubs" : "fmsub", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRC(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatSub(8, il->FloatMult(8, FReg(AFORM_FRA(inst)), FReg(AFORM_FRC(inst))), FReg(AFORM_FRB(inst)));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 29:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fmadds" : "fmadd", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRC(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatAdd(8, il->FloatMult(8, FReg(AFORM_FRA(inst)), FReg(AFORM_FRC(inst))), FReg(AFORM_FRB(inst)));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 30:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fnmsubs" : "fnmsub", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRC(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatNeg(8, il->FloatSub(8, il->FloatMult(8, FReg(AFORM_FRA(inst)), FReg(AFORM_FRC(inst))), FReg(AFORM_FRB(inst))));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	case 31:
+#if   defined(EMIT_ASM)
+		OpRc(single ? "fnmadds" : "fnmadd", inst);
+		FReg(AFORM_FRT(inst));
+		FReg(AFORM_FRA(inst));
+		FReg(AFORM_FRC(inst));
+		FReg(AFORM_FRB(inst));
+#elif defined(EMIT_IL)
+		ei0 = il->FloatNeg(8, il->FloatAdd(8, il->FloatMult(8, FReg(AFORM_FRA(inst)), FReg(AFORM_FRC(inst))), FReg(AFORM_FRB(inst))));
+		il->AddInstruction(SetFReg(AFORM_FRT(inst), single ? RoundSingle(ei0) : ei0));
+#endif
+		return true;
+	}
+	return false;
+}
+
+bool DECODE_GROUP(Vector)(uint32_t inst) {
+	const VecOpcode *vop = VecLookup(inst);
+	if (!vop)
+		return false;
+#if   defined(EMIT_ASM)
+	VecOperand ops[VEC_MAX_OPERANDS];
+	size_t n = VecDecodeOperands(*vop, inst, ops);
+	Op(vop->name);
+	for (size_t i = 0; i < n; i++) {
+		switch (ops[i].kind) {
+		case VecOperandKind::VR: VReg(ops[i].value); break;
+		case VecOperandKind::VSR: VsReg(ops[i].value); break;
+		case VecOperandKind::GPR: Reg(ops[i].value); break;
+		case VecOperandKind::Mem: Disp(ops[i].value, ops[i].disp); break;
+		case VecOperandKind::MemX: Reg(ops[i].value); Reg(ops[i].index); break;
+		default: Imm(ops[i].value); break;
+		}
+	}
+#elif defined(EMIT_IL)
+	return LiftVectorOp(*vop, inst);
+#endif
+	return true;
+}
@@ -0,0 +1,296 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "decode_cache.h"
+#include "memprof.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Writers copy the table under a mutex, publish the copy and bump the
+ * generation. Each reader thread keeps a reference to the table it last
+ * saw and takes the lock only when the generation moves, so lookups stay
+ * lock-free and a replaced table is freed once every thread has moved
+ * past it. Until then a thread holds at most one stale table.
+ */
+struct DecodeEntry {
+	const void *owner;
+	std::shared_ptr<DecodeRegion> region;
+};
+
+struct DecodeTable {
+	std::vector<DecodeEntry> entries;	// sorted by start
+	uint64_t maxSpan = 0;			// bytes in the longest region
+};
+
+static std::mutex tableLock;
+static std::shared_ptr<const DecodeTable> currentTable;
+static std::atomic<uint32_t> tableGeneration(0);
+
+static const DecodeTable *CurrentTable() {
+	thread_local std::shared_ptr<const DecodeTable> cached;
+	thread_local uint32_t cachedGeneration = 0;
+	if (tableGeneration.load(std::memory_order_acquire) != cachedGeneration) {
+		std::lock_guard<std::mutex> guard(tableLock);
+		cached = currentTable;
+		cachedGeneration = tableGeneration.load(std::memory_order_relaxed);
+	}
+	return cached.get();
+}
+
+// Publishes the entries for which keep returns true plus, if given, one
+// new entry. Called with tableLock held.
+template <typename F>
+static void Publish(F keep, const DecodeEntry *add) {
+	auto table = std::make_shared<DecodeTable>();
+	if (currentTable) {
+		for (auto &e : currentTable->entries)
+			if (keep(e))
+				table->entries.push_back(e);
+	}
+	if (add)
+		table->entries.push_back(*add);
+	std::sort(table->entries.begin(), table->entries.end(),
+		[](const DecodeEntry &a, const DecodeEntry &b) { return a.region->start < b.region->start; });
+	for (auto &e : table->entries)
+		table->maxSpan = std::max(table->maxSpan, e.region->count * 4);
+	currentTable = std::move(table);
+	tableGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void DecodeRegion::Fill(uint64_t first, const uint8_t *data, uint64_t n) {
+	for (uint64_t i = 0; i < n; i++) {
+		uint64_t rec = PpcDecoder::Decode(ReadInstruction(data + i * 4), start + (first + i) * 4);
+		records[first + i].store(rec, std::memory_order_relaxed);
+	}
+}
+
+HeapRegion::HeapRegion(uint64_t start, uint64_t count) {
+	storage.reset(new std::atomic<uint64_t>[count]);
+	for (uint64_t i = 0; i < count; i++)
+		storage[i].store(0, std::memory_order_relaxed);
+	this->start = start;
+	this->count = count;
+	this->records = storage.get();
+	PpcMemProfile::Hold(MemCache::DecodeRegions, count * sizeof(uint64_t));
+}
+
+HeapRegion::~HeapRegion() {
+	PpcMemProfile::Hold(MemCache::DecodeRegions, -(int64_t)(count * sizeof(uint64_t)));
+}
+
+bool DecodeCache::Lookup(uint64_t addr, uint32_t inst, uint64_t &rec) {
+	const DecodeTable *table = CurrentTable();
+	if (!table)
+		return false;
+	auto &entries = table->entries;
+	auto it = std::upper_bound(entries.begin(), entries.end(), addr,
+		[](uint64_t a, const DecodeEntry &e) { return a < e.region->start; });
+	// Views opened at the same addresses register overlapping regions;
+	// any of them may hold the record.
+	while (it != entries.begin()) {
+		const DecodeRegion *region = (--it)->region.get();
+		if (addr - region->start >= table->maxSpan)
+			break;
+		if (region->Contains(addr) && ((addr - region->start) & 3) == 0) {
+			rec = region->records[(addr - region->start) / 4].load(std::memory_order_relaxed);
+			if ((RECORD_FLAGS(rec) & INSN_DECODED) && RECORD_INST(rec) == inst)
+				return true;
+		}
+	}
+	return false;
+}
+
+uint64_t DecodeCache::Get(uint64_t addr, uint32_t inst) {
+	uint64_t rec;
+	if (Lookup(addr, inst, rec))
+		return rec;
+	return PpcDecoder::Decode(inst, addr);
+}
+
+void DecodeCache::AddRegion(const void *owner, std::shared_ptr<DecodeRegion> region) {
+	std::lock_guard<std::mutex> guard(tableLock);
+	uint64_t end = region->start + region->count * 4;
+	DecodeEntry add{owner, std::move(region)};
+	Publish([&](const DecodeEntry &e) {
+		const DecodeRegion *r = e.region.get();
+		return e.owner != owner || r->start >= end || add.region->start >= r->start + r->count * 4;
+	}, &add);
+}
+
+void DecodeCache::RemoveRegions(const void *owner) {
+	std::lock_guard<std::mutex> guard(tableLock);
+	Publish([&](const DecodeEntry &e) { return e.owner != owner; }, nullptr);
+}
+
+void DecodeCache::Update(const void *owner, uint64_t addr, const uint8_t *data, size_t len) {
+	const DecodeTable *table = CurrentTable();
+	if (!table)
+		return;
+	uint64_t end = addr + len;
+	for (auto &e : table->entries) {
+		DecodeRegion *r = e.region.get();
+		uint64_t rEnd = r->start + r->count * 4;
+		if (e.owner != owner || r->start >= end || rEnd <= addr || ((r->start - addr) & 3) != 0)
+			continue;
+		uint64_t from = std::max(addr, r->start);
+		uint64_t to = std::min(end, rEnd);
+		r->Fill((from - r->start) / 4, data + (from - addr), (to - from) / 4);
+	}
+}
+
+/* On-disk index */
+
+#define INDEX_MAGIC "PPC64IDX"
+// Bump whenever the decoder accepts or flags a different set of words.
+#define INDEX_VERSION 12
+
+struct IndexHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+	uint64_t base;
+	uint64_t count;
+	uint64_t hash;
+	uint64_t branchCount;
+};
+
+MappedRegion::~MappedRegion() {
+	if (map) {
+		munmap(map, mapSize);
+		PpcMemProfile::Hold(MemCache::DecodeIndexes, -(int64_t)mapSize);
+	}
+}
+
+uint64_t DecodeIndex::Hash(const uint8_t *data, size_t len, uint64_t base) {
+	// Word-at-a-time multiplicative hash. This only keys a cache, it
+	// doesn't need to resist collisions crafted on purpose.
+	const uint64_t k = 0x9e3779b97f4a7c15ull;
+	uint64_t h = base ^ (len * k);
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		uint64_t w;
+		memcpy(&w, data + i, 8);
+		h = (h ^ w) * k;
+		h ^= h >> 29;
+	}
+	for (; i < len; i++)
+		h = (h ^ data[i]) * k;
+	return h ^ (h >> 32);
+}
+
+static std::shared_ptr<MappedRegion> MapIndex(const std::string &path, uint64_t base, uint64_t count, uint64_t hash) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(IndexHeader)) {
+		close(fd);
+		return nullptr;
+	}
+	// Private and writable: in-memory record updates after patches must
+	// never reach the file.
+	void *map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return nullptr;
+
+	auto region = std::make_shared<MappedRegion>();
+	region->map = map;
+	region->mapSize = st.st_size;
+	PpcMemProfile::Hold(MemCache::DecodeIndexes, st.st_size);
+
+	const IndexHeader *hdr = (const IndexHeader *)map;
+	if (memcmp(hdr->magic, INDEX_MAGIC, 8) != 0 || hdr->version != INDEX_VERSION
+		|| hdr->recordSize != sizeof(uint64_t) || hdr->base != base
+		|| hdr->count != count || hdr->hash != hash)
+		return nullptr;
+	if (sizeof(IndexHeader) + count * sizeof(uint64_t) + hdr->branchCount * sizeof(IndexBranch) != (size_t)st.st_size)
+		return nullptr;
+
+	uint8_t *p = (uint8_t *)map + sizeof(IndexHeader);
+	region->start = base;
+	region->count = count;
+	region->records = (std::atomic<uint64_t> *)p;
+	region->branches = (const IndexBranch *)(p + count * sizeof(uint64_t));
+	region->branchCount = hdr->branchCount;
+	return region;
+}
+
+static bool WriteIndex(const std::string &path, const uint8_t *data, uint64_t base, uint64_t count, uint64_t hash) {
+	std::vector<uint64_t> records(count);
+	std::vector<IndexBranch> branches;
+	for (uint64_t i = 0; i < count; i++) {
+		uint32_t inst = ReadInstruction(data + i * 4);
+		uint64_t addr = base + i * 4;
+		records[i] = PpcDecoder::Decode(inst, addr);
+		if (RECORD_FLAGS(records[i]) & INSN_BRANCH)
+			branches.push_back({addr, PpcDecoder::BranchTarget(inst, addr)});
+	}
+
+	IndexHeader hdr;
+	memcpy(hdr.magic, INDEX_MAGIC, 8);
+	hdr.version = INDEX_VERSION;
+	hdr.recordSize = sizeof(uint64_t);
+	hdr.base = base;
+	hdr.count = count;
+	hdr.hash = hash;
+	hdr.branchCount = branches.size();
+
+	// Write under a temporary name so a concurrent reader never maps a
+	// partial file.
+	std::string tmp = path + ".tmp." + std::to_string(getpid());
+	FILE *f = fopen(tmp.c_str(), "wb");
+	if (!f)
+		return false;
+	bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+	ok = ok && fwrite(records.data(), sizeof(uint64_t), count, f) == count;
+	ok = ok && fwrite(branches.data(), sizeof(IndexBranch), branches.size(), f) == branches.size();
+	ok = (fclose(f) == 0) && ok;
+	if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+		unlink(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+std::shared_ptr<MappedRegion> DecodeIndex::Open(const std::string &dir, const uint8_t *data, size_t len, uint64_t base) {
+	uint64_t count = len / 4;
+	uint64_t hash = Hash(data, count * 4, base);
+
+	char name[64];
+	snprintf(name, sizeof(name), "/%016llx-%016llx.idx", (unsigned long long)hash, (unsigned long long)base);
+	std::string path = dir + name;
+
+	auto region = MapIndex(path, base, count, hash);
+	if (region)
+		return region;
+
+	mkdir(dir.c_str(), 0755);
+	if (!WriteIndex(path, data, base, count, hash))
+		return nullptr;
+	return MapIndex(path, base, count, hash);
+}
@@ -0,0 +1,115 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "decoder.h"
+
+/*
+ * A contiguous run of decode records starting at `start`, one per 4-byte
+ * word. Records that were never filled in are zero (no INSN_DECODED).
+ */
+class DecodeRegion {
+public:
+	uint64_t start = 0;
+	uint64_t count = 0;
+	std::atomic<uint64_t> *records = nullptr;
+
+	bool Contains(uint64_t addr) const {
+		return addr >= start && (addr - start) / 4 < count;
+	}
+
+	// Decodes n words from data into records first..first+n-1.
+	void Fill(uint64_t first, const uint8_t *data, uint64_t n);
+
+	virtual ~DecodeRegion() {}
+};
+
+/*
+ * Region filled in the background after a view opens. Records start out
+ * empty and are published one by one as they are decoded.
+ */
+class HeapRegion : public DecodeRegion {
+private:
+	std::unique_ptr<std::atomic<uint64_t>[]> storage;
+public:
+	HeapRegion(uint64_t start, uint64_t count);
+	virtual ~HeapRegion();
+};
+
+struct IndexBranch {
+	uint64_t source;
+	uint64_t target;
+};
+
+/*
+ * Region backed by an on-disk index file. The mapping is private, so
+ * records can still be updated in memory after a patch without touching
+ * the file.
+ */
+class MappedRegion : public DecodeRegion {
+public:
+	void *map = nullptr;
+	size_t mapSize = 0;
+	const IndexBranch *branches = nullptr;
+	uint64_t branchCount = 0;
+
+	virtual ~MappedRegion();
+};
+
+/*
+ * Regions are registered on behalf of an owner (the view they were warmed
+ * for). Records depend only on the word and its address, so any owner's
+ * region can serve a lookup; owners only decide what is replaced and
+ * what is dropped when a view closes.
+ */
+class DecodeCache {
+public:
+	// Finds a cached record decoded from the same instruction word.
+	static bool Lookup(uint64_t addr, uint32_t inst, uint64_t &rec);
+
+	// Record for the instruction at addr. Served from a registered region
+	// when one holds a record decoded from the same instruction word,
+	// decoded on the spot otherwise.
+	static uint64_t Get(uint64_t addr, uint32_t inst);
+
+	// Registers a region, replacing any region of the same owner it
+	// overlaps. Regions of other owners are kept.
+	static void AddRegion(const void *owner, std::shared_ptr<DecodeRegion> region);
+
+	// Drops every region of owner.
+	static void RemoveRegions(const void *owner);
+
+	// Re-decodes owner's records for [addr, addr+len) after the bytes
+	// there changed. data holds the new bytes; addr and len are word
+	// aligned.
+	static void Update(const void *owner, uint64_t addr, const uint8_t *data, size_t len);
+};
+
+class DecodeIndex {
+public:
+	static uint64_t Hash(const uint8_t *data, size_t len, uint64_t base);
+
+	// Maps the index for this segment from dir, building and writing it
+	// first if no index with a matching content hash exists. Returns
+	// nullptr if the index can neither be read nor written.
+	static std::shared_ptr<MappedRegion> Open(const std::string &dir, const uint8_t *data, size_t len, uint64_t base);
+};
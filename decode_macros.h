@@ -14,13 +14,13 @@
  * with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
-#define PPC_REG_CTR 32
+#include "registers.h"
 
 #define DFORM_RS(i) ((i>>21)&0x1f)
 #define DFORM_RT(i) ((i>>21)&0x1f)
 #define DFORM_RA(i) ((i>>16)&0x1f)
 #define DFORM_UI(i) (i&0xffff)
-#define DFORM_SI(i) ((i&0x8000) ? (-((i&0xffff)^0xffff)) : (i&0xffff))
+#define DFORM_SI(i) SEXT16(DFORM_D(i))
 #define DFORM_D(i) (i&0xffff)
 #define DFORM_BF(i) ((i>>23)&0x7)
 #define DFORM_L(i) ((i>>21)&0x1)
@@ -39,8 +39,8 @@
 #define MFORM_RA(i) ((i>>16)&0x1f)
 #define MFORM_RB(i) ((i>>11)&0x1f)
 #define MFORM_sh(i) ((i>>11)&0x1f)
-#define MFORM_mb(i) ((i>>5)&0x3f)
-#define MFORM_me(i) ((i>>1)&0x3f)
+#define MFORM_mb(i) ((i>>6)&0x1f)
+#define MFORM_me(i) ((i>>1)&0x1f)
 #define MFORM_Rc(i) (i&1)
 
 #define MDFORM_RS(i) ((i>>21)&0x1f)
@@ -64,6 +64,35 @@
 #define XFORM_RA(i) ((i>>16)&0x1f)
 #define XFORM_RB(i) ((i>>11)&0x1f)
 
+#define XFORM_BF(i) ((i>>23)&0x7)
+#define XFORM_BFA(i) ((i>>18)&0x7)
+#define XFORM_BT(i) ((i>>21)&0x1f)
+#define XFORM_U(i) ((i>>12)&0xf)
+#define XFORM_Rc(i) (i&1)
+// lswi/stswi byte count, NB=0 means 32
+#define XFORM_NB(i) (XFORM_RB(i) ? XFORM_RB(i) : 32)
+
+#define XLFORM_BT(i) ((i>>21)&0x1f)
+#define XLFORM_BA(i) ((i>>16)&0x1f)
+#define XLFORM_BB(i) ((i>>11)&0x1f)
+#define XLFORM_BF(i) ((i>>23)&0x7)
+#define XLFORM_BFA(i) ((i>>18)&0x7)
+
+#define XFLFORM_FLM(i) ((i>>17)&0xff)
+
+#define AFORM_FRT(i) ((i>>21)&0x1f)
+#define AFORM_FRA(i) ((i>>16)&0x1f)
+#define AFORM_FRB(i) ((i>>11)&0x1f)
+#define AFORM_FRC(i) ((i>>6)&0x1f)
+#define AFORM_XO(i) ((i>>1)&0x1f)
+#define AFORM_Rc(i) (i&1)
+// Group 63 X-forms without an Rc bit: fcmpu, fcmpo, mcrfs
+#define XFORM_FCMP(i) (AFORM_XO(i) < 18 && (((i>>1)&0x3ff) == 0 || ((i>>1)&0x3ff) == 32 || ((i>>1)&0x3ff) == 64))
+
+// addpcis: D = d0 || d1 || d2
+#define DXFORM_RT(i) ((i>>21)&0x1f)
+#define DXFORM_D(i) ((((i>>6)&0x3ff)<<6)|(((i>>16)&0x1f)<<1)|(i&1))
+
 #define XFXFORM_RS(i) ((i>>21)&0x1f)
 #define XFXFORM_SPR(i) (((i&0x1f0000)>>16)|((i&0xf800)>>6))
 
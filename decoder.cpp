@@ -0,0 +1,238 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "decoder.h"
+
+#include "decode_macros.h"
+#include "atomic.h"
+#include "spr.h"
+#include "vector.h"
+
+std::atomic<bool> PpcDecoder::strict(false);
+
+#define DECODE_MAIN PpcDecoder::DecodeInstruction
+#define DECODE_GROUP(g) PpcDecoder::decode##g
+#include "decode.inc.cpp"
+#undef DECODE_MAIN
+#undef DECODE_GROUP
+
+uint64_t PpcDecoder::Decode(uint32_t inst, uint64_t addr) {
+	uint8_t data[4] = {
+		(uint8_t)(inst >> 24), (uint8_t)(inst >> 16), (uint8_t)(inst >> 8), (uint8_t)inst
+	};
+	uint32_t flags = INSN_DECODED;
+	PpcDecoder decoder;
+	if (decoder.DecodeInstruction(data, addr)) {
+		flags |= INSN_VALID;
+		if (Reserved(inst))
+			flags |= INSN_RESERVED;
+	}
+
+	// BO = 1z1zz ignores both CTR and the CR bit
+	bool always = (BFORM_BO(inst) & 0b10100) == 0b10100;
+	switch (inst >> 26) {
+	case 16:
+		/* bc/bca/bcl/bcla */
+		flags |= INSN_BRANCH;
+		if (!always)
+			flags |= INSN_CONDITIONAL;
+		if (inst & 0x1)
+			flags |= INSN_CALL;
+		break;
+	case 18:
+		/* b/ba/bl/bla */
+		flags |= INSN_BRANCH;
+		if (inst & 0x1)
+			flags |= INSN_CALL;
+		break;
+	case 2:
+	case 3:
+		/* tdi/twi */
+		if (ClassifyTrap(inst) == TrapKind::Always)
+			flags |= INSN_TRAP;
+		break;
+	case 31:
+		/* tw/td */
+		if ((((inst >> 1) & 0x3ff) == 4 || ((inst >> 1) & 0x3ff) == 68) && ClassifyTrap(inst) == TrapKind::Always)
+			flags |= INSN_TRAP;
+		break;
+	case 19:
+		/* bclr/bcctr; the linking forms are indirect calls */
+		if (!(flags & INSN_VALID) || (inst & 0x1))
+			break;
+		if (((inst >> 1) & 0x3ff) == 16)
+			flags |= INSN_RETURN;
+		else if (((inst >> 1) & 0x3ff) == 528)
+			flags |= INSN_INDIRECT;
+		if ((flags & (INSN_RETURN | INSN_INDIRECT)) && !always)
+			flags |= INSN_CONDITIONAL;
+		break;
+	}
+	return RECORD_MAKE(inst, flags);
+}
+
+uint64_t PpcDecoder::BranchTarget(uint32_t inst, uint64_t addr) {
+	if ((inst >> 26) == 16) {
+		if (inst & 0x2)
+			return SEXT16(BFORM_BD(inst));
+		return addr + SEXT16(BFORM_BD(inst));
+	}
+	if (inst & 0x2)
+		return SEXT26(IFORM_LI(inst));
+	return addr + SEXT26(IFORM_LI(inst));
+}
+
+TrapKind PpcDecoder::ClassifyTrap(uint32_t inst) {
+	// TO bits: signed <, signed >, ==, unsigned <, unsigned >
+	uint32_t to = (inst >> 21) & 0x1f;
+	if ((inst >> 26) == 31 && XFORM_RA(inst) == XFORM_RB(inst))
+		return (to & 0x04) ? TrapKind::Always : TrapKind::Never;
+	if (to == 0)
+		return TrapKind::Never;
+	if ((to & 0x1c) == 0x1c || (to & 0x07) == 0x07)
+		return TrapKind::Always;
+	return TrapKind::Conditional;
+}
+
+// BO values with a z bit set; z must be zero
+static bool ReservedBO(uint32_t bo) {
+	if ((bo & 0b10100) == 0b10100)
+		return bo & 0b01011;
+	if (!(bo & 0b10100))
+		return bo & 0b00001;
+	return false;
+}
+
+// Group 31 XO/X-forms that have an Rc bit
+static bool Group31HasRc(uint32_t xo) {
+	switch (xo & 0x1ff) {
+	case 8: case 10: case 136: case 138: case 200: case 202: case 232: case 234:
+	case 40: case 266: case 104: case 233: case 235: case 457: case 459: case 489: case 491:
+		/* XO-form arithmetic, OE is bit 10 */
+		return true;
+	case 9: case 11: case 73: case 75:
+		/* mulh*, no OE */
+		return xo < 512;
+	}
+	switch (xo) {
+	case 24: case 27: case 536: case 539: case 792: case 794:
+	case 28: case 60: case 124: case 284: case 316: case 412: case 444: case 476:
+	case 824: case 826: case 827:
+	case 26: case 58: case 538: case 570: case 922: case 954: case 986:
+		return true;
+	case 150: case 214: case 694: case 726:
+		/* stcx. forms require Rc=1 */
+		return true;
+	}
+	return false;
+}
+
+// Floating-point fields an A-form does not use must be zero
+static bool FloatReserved(uint32_t inst) {
+	uint32_t xo = (inst >> 1) & 0x3ff;
+	if ((inst >> 26) == 59 && (xo == 846 || xo == 974))
+		/* fcfids/fcfidus */
+		return XFORM_RA(inst);
+	if (XFORM_FCMP(inst))
+		return xo == 64 ? (inst & 0x63f801) : (inst & 0x600001);
+	switch (AFORM_XO(inst)) {
+	case 18: case 20: case 21:
+		/* fdiv/fsub/fadd */
+		return AFORM_FRC(inst);
+	case 22: case 24: case 26:
+		/* fsqrt/fre/frsqrte */
+		return AFORM_FRA(inst) || AFORM_FRC(inst);
+	case 25:
+		/* fmul */
+		return AFORM_FRB(inst);
+	}
+	return false;
+}
+
+bool PpcDecoder::Reserved(uint32_t inst) {
+	uint32_t primary = inst >> 26;
+	uint32_t rt = DFORM_RT(inst), ra = DFORM_RA(inst);
+	switch (primary) {
+	case 10:
+	case 11:
+		/* cmpli/cmpi */
+		return inst & (1 << 22);
+	case 16:
+		return ReservedBO(BFORM_BO(inst));
+	case 19:
+		if (((inst >> 1) & 0x1f) == 2)
+			/* addpcis: every bit is an operand */
+			return false;
+		switch ((inst >> 1) & 0x3ff) {
+		case 0:
+			/* mcrf */
+			return inst & 0x63f801;
+		case 16:
+		case 528:
+			/* bclr/bcctr */
+			return (inst & 0xe000) || ReservedBO(BFORM_BO(inst));
+		case 150:
+			/* isync */
+			return inst & 0x3fff801;
+		default:
+			return inst & 1;
+		}
+	case 31: {
+		uint32_t xo = (inst >> 1) & 0x3ff;
+		if (VecLookup(inst))
+			return false;
+		if ((inst & 1) && !Group31HasRc(xo))
+			return true;
+		switch (xo) {
+		case 0:
+		case 32:
+			/* cmp/cmpl */
+			return inst & (1 << 22);
+		case 53: case 55: case 119: case 311: case 373: case 375:
+			/* ldux/lwzux/lbzux/lhzux/lwaux/lhaux */
+			return ra == 0 || ra == rt;
+		case 181: case 183: case 247: case 439: case 567: case 631: case 695: case 759:
+			/* stdux/stwux/stbux/sthux/lfsux/lfdux/stfsux/stfdux */
+			return ra == 0;
+		case 597:
+			/* lswi: ra (r0 included) inside the registers loaded */
+			return ((ra - rt) & 31) < (XFORM_NB(inst) + 3) / 4;
+		}
+		return false;
+	}
+	case 33: case 35: case 41: case 43:
+		/* lwzu/lbzu/lhzu/lhau */
+		return ra == 0 || ra == rt;
+	case 37: case 39: case 45: case 49: case 51: case 53: case 55:
+		/* stwu/stbu/sthu/lfsu/lfdu/stfsu/stfdu */
+		return ra == 0;
+	case 59:
+	case 63:
+		return FloatReserved(inst);
+	case 46:
+		/* lmw: ra (r0 included) inside rt..r31 */
+		return ra >= rt;
+	case 58:
+		/* ldu; XO 3 is unassigned */
+		if ((inst & 3) == 1)
+			return ra == 0 || ra == rt;
+		return (inst & 3) == 3;
+	case 62:
+		/* stdu */
+		return (inst & 3) == 1 && ra == 0;
+	}
+	return false;
+}
@@ -0,0 +1,87 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Packed decode record: one 64-bit word per instruction, instruction word in
+ * the high half so a record can always be checked against the bytes it was
+ * decoded from. Records are read and written as single 64-bit values, which
+ * lets caches update them while other threads read.
+ */
+#define INSN_DECODED		(1 << 0)	/* record is populated */
+#define INSN_VALID		(1 << 1)
+#define INSN_BRANCH		(1 << 2)	/* direct target, see PpcDecoder::BranchTarget */
+#define INSN_CONDITIONAL	(1 << 3)
+#define INSN_CALL		(1 << 4)
+#define INSN_RETURN		(1 << 5)	/* bclr */
+#define INSN_INDIRECT		(1 << 6)	/* bcctr */
+#define INSN_TRAP		(1 << 7)	/* unconditional trap, no fall-through */
+#define INSN_RESERVED		(1 << 8)	/* valid, but reserved bits set or an invalid form */
+
+#define RECORD_MAKE(inst, flags) (((uint64_t)(inst) << 32) | (flags))
+#define RECORD_INST(r) ((uint32_t)((r) >> 32))
+#define RECORD_FLAGS(r) ((uint32_t)((r) & 0xffff))
+
+// What a tw/td/twi/tdi does regardless of register values
+enum class TrapKind {
+	Never,
+	Always,
+	Conditional,
+};
+
+class PpcDecoder {
+private:
+	bool decode19(uint32_t inst);
+	bool decode30(uint32_t inst);
+	bool decode31(uint32_t inst);
+	bool decode58(uint32_t inst);
+	bool decode59(uint32_t inst);
+	bool decode62(uint32_t inst);
+	bool decode63(uint32_t inst);
+	bool decodeFloatA(uint32_t inst, bool single);
+	bool decodeVector(uint32_t inst);
+public:
+	// Validity only: runs the shared decode tables without emitting
+	// tokens or IL.
+	bool DecodeInstruction(const uint8_t *data, uint64_t addr);
+
+	static uint64_t Decode(uint32_t inst, uint64_t addr);
+	static uint64_t BranchTarget(uint32_t inst, uint64_t addr);
+	static TrapKind ClassifyTrap(uint32_t inst);
+	// Checks a decodable word for set reserved fields and invalid forms
+	// (update with RA=0, loads that overwrite RA).
+	static bool Reserved(uint32_t inst);
+
+	// Strict decoding rejects INSN_RESERVED words in every callback.
+	// Set at startup from the global "ppc64.strictDecode.enabled" setting.
+	static std::atomic<bool> strict;
+
+	static bool Rejected(uint64_t rec) {
+		uint32_t flags = RECORD_FLAGS(rec);
+		if (!(flags & INSN_VALID))
+			return true;
+		return (flags & INSN_RESERVED) && strict.load(std::memory_order_relaxed);
+	}
+};
+
+static inline uint32_t ReadInstruction(const uint8_t *data) {
+	return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
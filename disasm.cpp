@@ -15,6 +15,9 @@
  */
 
 #include "disasm.h"
+#include "atomic.h"
+#include "spr.h"
+#include "vector.h"
 
 using namespace BinaryNinja;
 
@@ -24,6 +27,11 @@ void PpcDisassembler::Op(const std::string &v) {
 	result->emplace_back(InstructionToken, v);
 }
 
+void PpcDisassembler::OpRc(const std::string &v, uint32_t inst) {
+	// Record forms get a trailing '.'
+	Op((inst & 1) ? v + "." : v);
+}
+
 void PpcDisassembler::Reg(uint32_t reg) {
 	if (result->size() >= 2) result->emplace_back(TextToken, ", ");
 	else if (result->size() == 1) result->emplace_back(TextToken, " ");
@@ -32,11 +40,35 @@ void PpcDisassembler::Reg(uint32_t reg) {
 	snprintf(buf, sizeof(buf), "r%d", reg);
 	result->emplace_back(RegisterToken, buf);
 }
-void PpcDisassembler::Imm(uint64_t imm) {
+void PpcDisassembler::FReg(uint32_t reg) {
 	if (result->size() >= 2) result->emplace_back(TextToken, ", ");
 	else if (result->size() == 1) result->emplace_back(TextToken, " ");
 
 	char buf[16];
+	snprintf(buf, sizeof(buf), "f%d", reg);
+	result->emplace_back(RegisterToken, buf);
+}
+void PpcDisassembler::VReg(uint32_t reg) {
+	if (result->size() >= 2) result->emplace_back(TextToken, ", ");
+	else if (result->size() == 1) result->emplace_back(TextToken, " ");
+
+	char buf[16];
+	snprintf(buf, sizeof(buf), "v%d", reg);
+	result->emplace_back(RegisterToken, buf);
+}
+void PpcDisassembler::VsReg(uint32_t reg) {
+	if (result->size() >= 2) result->emplace_back(TextToken, ", ");
+	else if (result->size() == 1) result->emplace_back(TextToken, " ");
+
+	char buf[16];
+	snprintf(buf, sizeof(buf), "vs%d", reg);
+	result->emplace_back(RegisterToken, buf);
+}
+void PpcDisassembler::Imm(uint64_t imm) {
+	if (result->size() >= 2) result->emplace_back(TextToken, ", ");
+	else if (result->size() == 1) result->emplace_back(TextToken, " ");
+
+	char buf[24];
 	snprintf(buf, sizeof(buf), "0x%lx", imm);
 	result->emplace_back(IntegerToken, buf, imm);
 }
@@ -25,7 +25,11 @@ private:
 	bool insertSpace = false;
 
 	void Op(const std::string &v);
+	void OpRc(const std::string &v, uint32_t inst);
 	void Reg(uint32_t reg);
+	void FReg(uint32_t reg);
+	void VReg(uint32_t reg);
+	void VsReg(uint32_t reg);
 	void Imm(uint64_t imm);
 	void Disp(uint32_t reg, uint64_t d);
 
@@ -36,6 +40,8 @@ private:
 	bool decode59(uint32_t inst);
 	bool decode62(uint32_t inst);
 	bool decode63(uint32_t inst);
+	bool decodeFloatA(uint32_t inst, bool single);
+	bool decodeVector(uint32_t inst);
 public:
 	PpcDisassembler(std::vector<InstructionTextToken> *result) {
 		this->result = result;
@@ -0,0 +1,1058 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "emu.h"
+#include "decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "decode_macros.h"
+
+/* Memory */
+
+EmuMemory::EmuMemory() {
+	memset(tlb, 0, sizeof(tlb));
+}
+
+EmuPage *EmuMemory::Lookup(uint64_t addr) {
+	auto it = pages.find(addr >> EMU_PAGE_SHIFT);
+	if (it == pages.end())
+		return nullptr;
+	TlbEntry &e = tlb[(addr >> EMU_PAGE_SHIFT) % EMU_TLB_SIZE];
+	e.tag = addr >> EMU_PAGE_SHIFT;
+	e.page = it->second.get();
+	return e.page;
+}
+
+void EmuMemory::Map(uint64_t addr, uint64_t len) {
+	if (len == 0)
+		return;
+	for (uint64_t p = addr >> EMU_PAGE_SHIFT; p <= (addr + len - 1) >> EMU_PAGE_SHIFT; p++) {
+		auto &page = pages[p];
+		if (!page) {
+			page.reset(new EmuPage());
+			memset(page->data, 0, EMU_PAGE_SIZE);
+		}
+	}
+}
+
+void EmuMemory::Write(uint64_t addr, const void *data, size_t len) {
+	Map(addr, len);
+	const uint8_t *src = (const uint8_t *)data;
+	while (len) {
+		EmuPage *page = Page(addr);
+		size_t off = addr & (EMU_PAGE_SIZE - 1);
+		size_t n = std::min<size_t>(len, EMU_PAGE_SIZE - off);
+		memcpy(page->data + off, src, n);
+		addr += n;
+		src += n;
+		len -= n;
+	}
+}
+
+bool EmuMemory::Read(uint64_t addr, void *data, size_t len) {
+	uint8_t *dst = (uint8_t *)data;
+	while (len) {
+		EmuPage *page = Page(addr);
+		if (!page)
+			return false;
+		size_t off = addr & (EMU_PAGE_SIZE - 1);
+		size_t n = std::min<size_t>(len, EMU_PAGE_SIZE - off);
+		memcpy(dst, page->data + off, n);
+		addr += n;
+		dst += n;
+		len -= n;
+	}
+	return true;
+}
+
+void EmuMemory::ClearCodeMarks() {
+	for (auto &p : pages)
+		p.second->code = false;
+}
+
+/* Helpers */
+
+#define GPR(r) (e.cpu.gpr[(r)])
+#define GPR0(r) ((r) ? e.cpu.gpr[(r)] : 0)
+
+static inline uint64_t Mask64(unsigned mb, unsigned me) {
+	uint64_t a = ~0ull >> mb;
+	uint64_t b = ~0ull << (63 - me);
+	return mb <= me ? (a & b) : (a | b);
+}
+
+static inline uint64_t Rotl64(uint64_t x, unsigned n) {
+	n &= 63;
+	return n ? (x << n) | (x >> (64 - n)) : x;
+}
+
+static inline uint64_t Rotl32(uint64_t x, unsigned n) {
+	uint32_t w = (uint32_t)x;
+	n &= 31;
+	w = n ? (w << n) | (w >> (32 - n)) : w;
+	return ((uint64_t)w << 32) | w;
+}
+
+static inline void SetCRField(PpcEmulator &e, unsigned bf, uint32_t bits) {
+	unsigned shift = 28 - bf * 4;
+	e.cpu.cr = (e.cpu.cr & ~(0xfu << shift)) | (bits << shift);
+}
+
+static inline void SetCR0(PpcEmulator &e, uint64_t v) {
+	uint32_t bits = (int64_t)v < 0 ? 8 : ((int64_t)v > 0 ? 4 : 2);
+	SetCRField(e, 0, bits | ((e.cpu.xer & EMU_XER_SO) ? 1 : 0));
+}
+
+static inline void SetCA(PpcEmulator &e, bool ca) {
+	e.cpu.xer = ca ? (e.cpu.xer | EMU_XER_CA) : (e.cpu.xer & ~EMU_XER_CA);
+}
+
+static inline uint64_t CA(PpcEmulator &e) {
+	return (e.cpu.xer & EMU_XER_CA) ? 1 : 0;
+}
+
+static inline const EmuOp *Stop(PpcEmulator &e, const EmuOp *op, EmuStatus status, uint64_t pc) {
+	e.status = status;
+	e.cpu.pc = pc;
+	return nullptr;
+}
+
+static inline const EmuOp *Fault(PpcEmulator &e, const EmuOp *op, uint64_t ea) {
+	e.faultAddr = ea;
+	return Stop(e, op, EmuStatus::MemoryFault, op->pc);
+}
+
+template <int size>
+static inline bool GuestLoad(PpcEmulator &e, uint64_t ea, uint64_t &v) {
+	EmuPage *page = e.mem.Page(ea);
+	size_t off = ea & (EMU_PAGE_SIZE - 1);
+	uint8_t buf[8];
+	const uint8_t *p;
+	if (page && off + size <= EMU_PAGE_SIZE) {
+		p = page->data + off;
+	} else {
+		if (!e.mem.Read(ea, buf, size))
+			return false;
+		p = buf;
+	}
+	v = 0;
+	for (int i = 0; i < size; i++)
+		v = (v << 8) | p[i];
+	return true;
+}
+
+template <int size>
+static inline bool GuestStore(PpcEmulator &e, uint64_t ea, uint64_t v) {
+	EmuPage *page = e.mem.Page(ea);
+	size_t off = ea & (EMU_PAGE_SIZE - 1);
+	if (page && off + size <= EMU_PAGE_SIZE) {
+		for (int i = size - 1; i >= 0; i--, v >>= 8)
+			page->data[off + i] = (uint8_t)v;
+		if (page->code)
+			e.codeDirty = true;
+		return true;
+	}
+	// Access straddles two pages; both must be mapped.
+	if (!e.mem.Page(ea) || !e.mem.Page(ea + size - 1))
+		return false;
+	uint8_t buf[8];
+	for (int i = size - 1; i >= 0; i--, v >>= 8)
+		buf[i] = (uint8_t)v;
+	e.mem.Write(ea, buf, size);
+	if (e.mem.Page(ea)->code || e.mem.Page(ea + size - 1)->code)
+		e.codeDirty = true;
+	return true;
+}
+
+#define EMU_HANDLER(name) static const EmuOp *name(PpcEmulator &e, const EmuOp *op)
+#define NEXT return op + 1
+
+/* Integer arithmetic */
+
+EMU_HANDLER(h_nop) { NEXT; }
+
+EMU_HANDLER(h_addi) {
+	GPR(op->rt) = GPR0(op->ra) + op->imm;
+	NEXT;
+}
+
+EMU_HANDLER(h_addic) {
+	uint64_t a = GPR(op->ra);
+	uint64_t r = a + op->imm;
+	SetCA(e, r < a);
+	GPR(op->rt) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_subfic) {
+	uint64_t a = GPR(op->ra);
+	GPR(op->rt) = op->imm - a;
+	SetCA(e, op->imm >= a);
+	NEXT;
+}
+
+EMU_HANDLER(h_mulli) {
+	GPR(op->rt) = (uint64_t)((int64_t)GPR(op->ra) * (int64_t)op->imm);
+	NEXT;
+}
+
+EMU_HANDLER(h_cmpi) {
+	int64_t a = op->sh ? (int64_t)GPR(op->ra) : (int64_t)(int32_t)GPR(op->ra);
+	int64_t b = (int64_t)op->imm;
+	uint32_t bits = a < b ? 8 : (a > b ? 4 : 2);
+	SetCRField(e, op->aux, bits | ((e.cpu.xer & EMU_XER_SO) ? 1 : 0));
+	NEXT;
+}
+
+EMU_HANDLER(h_cmpli) {
+	uint64_t a = op->sh ? GPR(op->ra) : (uint32_t)GPR(op->ra);
+	uint64_t b = op->imm;
+	uint32_t bits = a < b ? 8 : (a > b ? 4 : 2);
+	SetCRField(e, op->aux, bits | ((e.cpu.xer & EMU_XER_SO) ? 1 : 0));
+	NEXT;
+}
+
+EMU_HANDLER(h_cmp) {
+	int64_t a = op->sh ? (int64_t)GPR(op->ra) : (int64_t)(int32_t)GPR(op->ra);
+	int64_t b = op->sh ? (int64_t)GPR(op->rb) : (int64_t)(int32_t)GPR(op->rb);
+	uint32_t bits = a < b ? 8 : (a > b ? 4 : 2);
+	SetCRField(e, op->aux, bits | ((e.cpu.xer & EMU_XER_SO) ? 1 : 0));
+	NEXT;
+}
+
+EMU_HANDLER(h_cmpl) {
+	uint64_t a = op->sh ? GPR(op->ra) : (uint32_t)GPR(op->ra);
+	uint64_t b = op->sh ? GPR(op->rb) : (uint32_t)GPR(op->rb);
+	uint32_t bits = a < b ? 8 : (a > b ? 4 : 2);
+	SetCRField(e, op->aux, bits | ((e.cpu.xer & EMU_XER_SO) ? 1 : 0));
+	NEXT;
+}
+
+/* Logical with immediate: RA <- RS op imm */
+
+EMU_HANDLER(h_ori) {
+	GPR(op->ra) = GPR(op->rt) | op->imm;
+	NEXT;
+}
+
+EMU_HANDLER(h_xori) {
+	GPR(op->ra) = GPR(op->rt) ^ op->imm;
+	NEXT;
+}
+
+EMU_HANDLER(h_andi) {
+	uint64_t r = GPR(op->rt) & op->imm;
+	GPR(op->ra) = r;
+	SetCR0(e, r);
+	NEXT;
+}
+
+/* Rotates: RA <- f(RS) */
+
+EMU_HANDLER(h_rlwinm) {
+	uint64_t r = Rotl32(GPR(op->rt), op->sh) & op->imm;
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_rlwnm) {
+	uint64_t r = Rotl32(GPR(op->rt), GPR(op->rb) & 31) & op->imm;
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_rlwimi) {
+	uint64_t r = (Rotl32(GPR(op->rt), op->sh) & op->imm) | (GPR(op->ra) & ~op->imm);
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_rldi) {
+	uint64_t r = Rotl64(GPR(op->rt), op->sh) & op->imm;
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_rldimi) {
+	uint64_t r = (Rotl64(GPR(op->rt), op->sh) & op->imm) | (GPR(op->ra) & ~op->imm);
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_rldc) {
+	uint64_t r = Rotl64(GPR(op->rt), GPR(op->rb) & 63) & op->imm;
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+/* Group 31 arithmetic: RT <- f(RA, RB) */
+
+#define XO_HANDLER(name, expr) \
+	EMU_HANDLER(name) { \
+		uint64_t a = GPR(op->ra), b = GPR(op->rb); \
+		(void)a; (void)b; \
+		uint64_t r = (expr); \
+		GPR(op->rt) = r; \
+		if (op->rc) SetCR0(e, r); \
+		NEXT; \
+	}
+
+XO_HANDLER(h_add, a + b)
+XO_HANDLER(h_subf, b - a)
+XO_HANDLER(h_neg, 0 - a)
+XO_HANDLER(h_mulld, a * b)
+XO_HANDLER(h_mullw, (uint64_t)((int64_t)(int32_t)a * (int64_t)(int32_t)b))
+XO_HANDLER(h_mulhw, (uint32_t)(((int64_t)(int32_t)a * (int64_t)(int32_t)b) >> 32))
+XO_HANDLER(h_mulhwu, (uint32_t)(((uint64_t)(uint32_t)a * (uint32_t)b) >> 32))
+XO_HANDLER(h_mulhd, (uint64_t)(((__int128)(int64_t)a * (int64_t)b) >> 64))
+XO_HANDLER(h_mulhdu, (uint64_t)(((unsigned __int128)a * b) >> 64))
+XO_HANDLER(h_divw, ((uint32_t)b == 0 || ((int32_t)a == INT32_MIN && (int32_t)b == -1)) ? 0 : (uint32_t)((int32_t)a / (int32_t)b))
+XO_HANDLER(h_divwu, (uint32_t)b == 0 ? 0 : (uint32_t)a / (uint32_t)b)
+XO_HANDLER(h_divd, (b == 0 || ((int64_t)a == INT64_MIN && (int64_t)b == -1)) ? 0 : (uint64_t)((int64_t)a / (int64_t)b))
+XO_HANDLER(h_divdu, b == 0 ? 0 : a / b)
+
+EMU_HANDLER(h_addc) {
+	uint64_t a = GPR(op->ra), r = a + GPR(op->rb);
+	SetCA(e, r < a);
+	GPR(op->rt) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_subfc) {
+	uint64_t a = GPR(op->ra), b = GPR(op->rb);
+	SetCA(e, b >= a);
+	GPR(op->rt) = b - a;
+	if (op->rc) SetCR0(e, b - a);
+	NEXT;
+}
+
+EMU_HANDLER(h_adde) {
+	uint64_t a = GPR(op->ra), c = CA(e), r = a + GPR(op->rb) + c;
+	SetCA(e, c ? r <= a : r < a);
+	GPR(op->rt) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_subfe) {
+	uint64_t a = ~GPR(op->ra), c = CA(e), r = a + GPR(op->rb) + c;
+	SetCA(e, c ? r <= a : r < a);
+	GPR(op->rt) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_addze) {
+	uint64_t a = GPR(op->ra), c = CA(e), r = a + c;
+	SetCA(e, c && r == 0);
+	GPR(op->rt) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_subfze) {
+	uint64_t a = ~GPR(op->ra), c = CA(e), r = a + c;
+	SetCA(e, c && r == 0);
+	GPR(op->rt) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_addme) {
+	uint64_t a = GPR(op->ra), c = CA(e), r = a + c - 1;
+	SetCA(e, c || a != 0);
+	GPR(op->rt) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_subfme) {
+	uint64_t a = ~GPR(op->ra), c = CA(e), r = a + c - 1;
+	SetCA(e, c || a != 0);
+	GPR(op->rt) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+/* Group 31 logical and shifts: RA <- f(RS, RB) */
+
+#define X_HANDLER(name, expr) \
+	EMU_HANDLER(name) { \
+		uint64_t s = GPR(op->rt), b = GPR(op->rb); \
+		(void)s; (void)b; \
+		uint64_t r = (expr); \
+		GPR(op->ra) = r; \
+		if (op->rc) SetCR0(e, r); \
+		NEXT; \
+	}
+
+X_HANDLER(h_and, s & b)
+X_HANDLER(h_andc, s & ~b)
+X_HANDLER(h_or, s | b)
+X_HANDLER(h_orc, s | ~b)
+X_HANDLER(h_xor, s ^ b)
+X_HANDLER(h_nor, ~(s | b))
+X_HANDLER(h_nand, ~(s & b))
+X_HANDLER(h_eqv, ~(s ^ b))
+X_HANDLER(h_slw, (b & 0x20) ? 0 : (uint32_t)(s << (b & 0x1f)))
+X_HANDLER(h_srw, (b & 0x20) ? 0 : (uint32_t)s >> (b & 0x1f))
+X_HANDLER(h_sld, (b & 0x40) ? 0 : s << (b & 0x3f))
+X_HANDLER(h_srd, (b & 0x40) ? 0 : s >> (b & 0x3f))
+X_HANDLER(h_cntlzw, (uint32_t)s ? __builtin_clz((uint32_t)s) : 32)
+X_HANDLER(h_cntlzd, s ? __builtin_clzll(s) : 64)
+X_HANDLER(h_extsb, (uint64_t)(int64_t)(int8_t)s)
+X_HANDLER(h_extsh, (uint64_t)(int64_t)(int16_t)s)
+X_HANDLER(h_extsw, (uint64_t)(int64_t)(int32_t)s)
+
+static inline uint64_t ShiftRightAlgebraic(PpcEmulator &e, int64_t s, unsigned n, unsigned width) {
+	if (n >= width) {
+		SetCA(e, s < 0);
+		return s < 0 ? ~0ull : 0;
+	}
+	SetCA(e, s < 0 && (s & ((1ll << n) - 1)) != 0);
+	return (uint64_t)(s >> n);
+}
+
+EMU_HANDLER(h_sraw) {
+	uint64_t r = ShiftRightAlgebraic(e, (int32_t)GPR(op->rt), GPR(op->rb) & 0x3f, 32);
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_srawi) {
+	uint64_t r = ShiftRightAlgebraic(e, (int32_t)GPR(op->rt), op->sh, 32);
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_srad) {
+	uint64_t r = ShiftRightAlgebraic(e, (int64_t)GPR(op->rt), GPR(op->rb) & 0x7f, 64);
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+EMU_HANDLER(h_sradi) {
+	uint64_t r = ShiftRightAlgebraic(e, (int64_t)GPR(op->rt), op->sh, 64);
+	GPR(op->ra) = r;
+	if (op->rc) SetCR0(e, r);
+	NEXT;
+}
+
+/* Special registers */
+
+EMU_HANDLER(h_mfcr) { GPR(op->rt) = e.cpu.cr; NEXT; }
+EMU_HANDLER(h_mflr) { GPR(op->rt) = e.cpu.lr; NEXT; }
+EMU_HANDLER(h_mfctr) { GPR(op->rt) = e.cpu.ctr; NEXT; }
+EMU_HANDLER(h_mfxer) { GPR(op->rt) = e.cpu.xer; NEXT; }
+EMU_HANDLER(h_mftb) { GPR(op->rt) = e.executed; NEXT; }
+EMU_HANDLER(h_mtlr) { e.cpu.lr = GPR(op->rt); NEXT; }
+EMU_HANDLER(h_mtctr) { e.cpu.ctr = GPR(op->rt); NEXT; }
+EMU_HANDLER(h_mtxer) { e.cpu.xer = GPR(op->rt) & 0xffffffff; NEXT; }
+
+EMU_HANDLER(h_mtcrf) {
+	uint32_t mask = 0;
+	for (int i = 0; i < 8; i++)
+		if (op->imm & (0x80 >> i))
+			mask |= 0xf0000000u >> (i * 4);
+	e.cpu.cr = (e.cpu.cr & ~mask) | ((uint32_t)GPR(op->rt) & mask);
+	NEXT;
+}
+
+/* Loads and stores */
+
+template <int size, bool sign, bool update, bool indexed>
+EMU_HANDLER(h_load) {
+	uint64_t ea = GPR0(op->ra) + (indexed ? GPR(op->rb) : op->imm);
+	uint64_t v;
+	if (!GuestLoad<size>(e, ea, v))
+		return Fault(e, op, ea);
+	if (sign && size == 2) v = (uint64_t)(int64_t)(int16_t)v;
+	if (sign && size == 4) v = (uint64_t)(int64_t)(int32_t)v;
+	GPR(op->rt) = v;
+	if (update) GPR(op->ra) = ea;
+	NEXT;
+}
+
+template <int size, bool update, bool indexed>
+EMU_HANDLER(h_store) {
+	uint64_t ea = GPR0(op->ra) + (indexed ? GPR(op->rb) : op->imm);
+	if (!GuestStore<size>(e, ea, GPR(op->rt)))
+		return Fault(e, op, ea);
+	if (update) GPR(op->ra) = ea;
+	NEXT;
+}
+
+EMU_HANDLER(h_lmw) {
+	uint64_t ea = GPR0(op->ra) + op->imm;
+	for (unsigned r = op->rt; r < 32; r++, ea += 4) {
+		uint64_t v;
+		if (!GuestLoad<4>(e, ea, v))
+			return Fault(e, op, ea);
+		GPR(r) = v;
+	}
+	NEXT;
+}
+
+EMU_HANDLER(h_stmw) {
+	uint64_t ea = GPR0(op->ra) + op->imm;
+	for (unsigned r = op->rt; r < 32; r++, ea += 4) {
+		if (!GuestStore<4>(e, ea, GPR(r)))
+			return Fault(e, op, ea);
+	}
+	NEXT;
+}
+
+// lswi/stswi: op->imm bytes, four per register from rt, wrapping past r31
+EMU_HANDLER(h_lswi) {
+	uint64_t ea = GPR0(op->ra);
+	uint64_t v = 0;
+	unsigned r = op->rt;
+	for (unsigned i = 0; i < op->imm; i++, ea++) {
+		uint64_t b;
+		if (!GuestLoad<1>(e, ea, b))
+			return Fault(e, op, ea);
+		v |= b << (24 - 8 * (i & 3));
+		if ((i & 3) == 3 || i + 1 == op->imm) {
+			GPR(r) = v;
+			r = (r + 1) & 31;
+			v = 0;
+		}
+	}
+	NEXT;
+}
+
+EMU_HANDLER(h_stswi) {
+	uint64_t ea = GPR0(op->ra);
+	for (unsigned i = 0; i < op->imm; i++, ea++) {
+		if (!GuestStore<1>(e, ea, GPR((op->rt + i / 4) & 31) >> (24 - 8 * (i & 3))))
+			return Fault(e, op, ea);
+	}
+	NEXT;
+}
+
+template <int size>
+EMU_HANDLER(h_larx) {
+	uint64_t ea = GPR0(op->ra) + GPR(op->rb);
+	uint64_t v;
+	if (!GuestLoad<size>(e, ea, v))
+		return Fault(e, op, ea);
+	GPR(op->rt) = v;
+	e.reserved = true;
+	e.reserveAddr = ea;
+	NEXT;
+}
+
+template <int size>
+EMU_HANDLER(h_stcx) {
+	uint64_t ea = GPR0(op->ra) + GPR(op->rb);
+	bool ok = e.reserved && e.reserveAddr == ea;
+	if (ok && !GuestStore<size>(e, ea, GPR(op->rt)))
+		return Fault(e, op, ea);
+	e.reserved = false;
+	SetCRField(e, 0, (ok ? 2 : 0) | ((e.cpu.xer & EMU_XER_SO) ? 1 : 0));
+	NEXT;
+}
+
+/* Branches and block terminators. These return nullptr after setting pc. */
+
+static inline bool BranchTaken(PpcEmulator &e, uint32_t bo, uint32_t bi) {
+	bool ctrOk = true;
+	if (!(bo & 0x04)) {
+		e.cpu.ctr--;
+		ctrOk = (e.cpu.ctr != 0) != ((bo & 0x02) != 0);
+	}
+	bool condOk = (bo & 0x10) || (((e.cpu.cr >> (31 - bi)) & 1) == ((bo >> 3) & 1));
+	return ctrOk && condOk;
+}
+
+EMU_HANDLER(h_b) {
+	if (op->rc) e.cpu.lr = op->pc + 4;
+	e.cpu.pc = op->imm;
+	return nullptr;
+}
+
+EMU_HANDLER(h_bc) {
+	bool taken = BranchTaken(e, op->aux, op->sh);
+	if (op->rc) e.cpu.lr = op->pc + 4;
+	e.cpu.pc = taken ? op->imm : op->pc + 4;
+	return nullptr;
+}
+
+EMU_HANDLER(h_bclr) {
+	uint64_t target = e.cpu.lr & ~3ull;
+	bool taken = BranchTaken(e, op->aux, op->sh);
+	if (op->rc) e.cpu.lr = op->pc + 4;
+	e.cpu.pc = taken ? target : op->pc + 4;
+	return nullptr;
+}
+
+EMU_HANDLER(h_bcctr) {
+	bool taken = BranchTaken(e, op->aux | 0x04, op->sh);
+	if (op->rc) e.cpu.lr = op->pc + 4;
+	e.cpu.pc = taken ? (e.cpu.ctr & ~3ull) : op->pc + 4;
+	return nullptr;
+}
+
+EMU_HANDLER(h_jump) {
+	e.cpu.pc = op->imm;
+	return nullptr;
+}
+
+EMU_HANDLER(h_sc) {
+	return Stop(e, op, EmuStatus::SystemCall, op->pc + 4);
+}
+
+static inline bool TrapTaken(uint32_t to, int64_t a, int64_t b) {
+	return ((to & 0x10) && a < b) || ((to & 0x08) && a > b) || ((to & 0x04) && a == b)
+		|| ((to & 0x02) && (uint64_t)a < (uint64_t)b) || ((to & 0x01) && (uint64_t)a > (uint64_t)b);
+}
+
+template <bool word, bool immediate>
+EMU_HANDLER(h_trap) {
+	int64_t a = GPR(op->ra);
+	int64_t b = immediate ? (int64_t)op->imm : (int64_t)GPR(op->rb);
+	if (word) {
+		a = (int32_t)a;
+		b = (int32_t)b;
+	}
+	if (TrapTaken(op->aux, a, b))
+		return Stop(e, op, EmuStatus::Trap, op->pc);
+	NEXT;
+}
+
+EMU_HANDLER(h_invalid) {
+	return Stop(e, op, EmuStatus::InvalidInstruction, op->pc);
+}
+
+EMU_HANDLER(h_unimplemented) {
+	return Stop(e, op, EmuStatus::Unimplemented, op->pc);
+}
+
+EMU_HANDLER(h_fetchfault) {
+	return Fault(e, op, op->pc);
+}
+
+/* Translation */
+
+bool PpcEmulator::TranslateOne(uint32_t inst, uint64_t pc, EmuOp &op, bool &terminator) {
+	op.inst = inst;
+	op.pc = pc;
+	op.rt = DFORM_RT(inst);
+	op.ra = DFORM_RA(inst);
+	op.rb = XFORM_RB(inst);
+	op.rc = inst & 1;
+	op.sh = 0;
+	op.aux = 0;
+	op.imm = 0;
+	terminator = false;
+
+	switch (inst >> 26) {
+	case 2:
+		op.fn = h_trap<false, true>;
+		op.aux = DFORM_RT(inst);
+		op.imm = SEXT16(DFORM_UI(inst));
+		return true;
+	case 3:
+		op.fn = h_trap<true, true>;
+		op.aux = DFORM_RT(inst);
+		op.imm = SEXT16(DFORM_UI(inst));
+		return true;
+	case 7:
+		op.fn = h_mulli;
+		op.imm = SEXT16(DFORM_UI(inst));
+		return true;
+	case 8:
+		op.fn = h_subfic;
+		op.imm = SEXT16(DFORM_UI(inst));
+		return true;
+	case 10:
+		op.fn = h_cmpli;
+		op.aux = DFORM_BF(inst);
+		op.sh = DFORM_L(inst);
+		op.imm = DFORM_UI(inst);
+		return true;
+	case 11:
+		op.fn = h_cmpi;
+		op.aux = DFORM_BF(inst);
+		op.sh = DFORM_L(inst);
+		op.imm = SEXT16(DFORM_UI(inst));
+		return true;
+	case 12:
+	case 13:
+		op.fn = h_addic;
+		op.rc = (inst >> 26) == 13;
+		op.imm = SEXT16(DFORM_UI(inst));
+		return true;
+	case 14:
+		op.fn = h_addi;
+		op.imm = SEXT16(DFORM_UI(inst));
+		return true;
+	case 15:
+		op.fn = h_addi;
+		op.imm = SEXT32(DFORM_UI(inst) << 16);
+		return true;
+	case 16:
+		op.fn = h_bc;
+		op.aux = BFORM_BO(inst);
+		op.sh = BFORM_BI(inst);
+		op.imm = PpcDecoder::BranchTarget(inst, pc);
+		terminator = true;
+		return true;
+	case 17:
+		op.fn = h_sc;
+		terminator = true;
+		return true;
+	case 18:
+		op.fn = h_b;
+		op.imm = PpcDecoder::BranchTarget(inst, pc);
+		terminator = true;
+		return true;
+	case 19:
+		if (((inst >> 1) & 0x1f) == 2) {
+			/* addpcis */
+			op.fn = h_addi;
+			op.ra = 0;
+			op.imm = pc + 4 + (SEXT16(DXFORM_D(inst)) << 16);
+			return true;
+		}
+		switch ((inst >> 1) & 0x3ff) {
+		case 16:
+			op.fn = h_bclr;
+			op.aux = BFORM_BO(inst);
+			op.sh = BFORM_BI(inst);
+			terminator = true;
+			return true;
+		case 528:
+			op.fn = h_bcctr;
+			op.aux = BFORM_BO(inst);
+			op.sh = BFORM_BI(inst);
+			terminator = true;
+			return true;
+		case 150:
+			op.fn = h_nop;
+			return true;
+		}
+		return false;
+	case 20:
+		op.fn = h_rlwimi;
+		op.sh = MFORM_sh(inst);
+		op.imm = Mask64(MFORM_mb(inst) + 32, MFORM_me(inst) + 32);
+		return true;
+	case 21:
+		op.fn = h_rlwinm;
+		op.sh = MFORM_sh(inst);
+		op.imm = Mask64(MFORM_mb(inst) + 32, MFORM_me(inst) + 32);
+		return true;
+	case 23:
+		op.fn = h_rlwnm;
+		op.imm = Mask64(MFORM_mb(inst) + 32, MFORM_me(inst) + 32);
+		return true;
+	case 24:
+	case 25:
+		op.fn = h_ori;
+		op.imm = (inst >> 26) == 25 ? (uint64_t)DFORM_UI(inst) << 16 : DFORM_UI(inst);
+		return true;
+	case 26:
+	case 27:
+		op.fn = h_xori;
+		op.imm = (inst >> 26) == 27 ? (uint64_t)DFORM_UI(inst) << 16 : DFORM_UI(inst);
+		return true;
+	case 28:
+	case 29:
+		op.fn = h_andi;
+		op.imm = (inst >> 26) == 29 ? (uint64_t)DFORM_UI(inst) << 16 : DFORM_UI(inst);
+		return true;
+	case 30:
+		op.sh = MDFORM_sh(inst);
+		switch (MDSFORM_XO(inst)) {
+		case 0: case 1:
+			/* rldicl */
+			op.fn = h_rldi;
+			op.imm = Mask64(MDFORM_mb(inst), 63);
+			return true;
+		case 2: case 3:
+			/* rldicr */
+			op.fn = h_rldi;
+			op.imm = Mask64(0, MDFORM_mb(inst));
+			return true;
+		case 4: case 5:
+			/* rldic */
+			op.fn = h_rldi;
+			op.imm = Mask64(MDFORM_mb(inst), 63 - op.sh);
+			return true;
+		case 6: case 7:
+			op.fn = h_rldimi;
+			op.imm = Mask64(MDFORM_mb(inst), 63 - op.sh);
+			return true;
+		case 8:
+			/* rldcl */
+			op.fn = h_rldc;
+			op.imm = Mask64(MDFORM_mb(inst), 63);
+			return true;
+		case 9:
+			/* rldcr */
+			op.fn = h_rldc;
+			op.imm = Mask64(0, MDFORM_mb(inst));
+			return true;
+		}
+		return false;
+	case 31:
+		switch ((inst >> 1) & 0x3ff) {
+		case 0: op.fn = h_cmp; op.aux = DFORM_BF(inst); op.sh = DFORM_L(inst); return true;
+		case 32: op.fn = h_cmpl; op.aux = DFORM_BF(inst); op.sh = DFORM_L(inst); return true;
+		case 4: op.fn = h_trap<true, false>; op.aux = DFORM_RT(inst); return true;
+		case 68: op.fn = h_trap<false, false>; op.aux = DFORM_RT(inst); return true;
+		case 8: case 520: op.fn = h_subfc; return true;
+		case 10: case 522: op.fn = h_addc; return true;
+		case 136: case 648: op.fn = h_subfe; return true;
+		case 138: case 650: op.fn = h_adde; return true;
+		case 200: case 712: op.fn = h_subfze; return true;
+		case 202: case 714: op.fn = h_addze; return true;
+		case 232: case 744: op.fn = h_subfme; return true;
+		case 234: case 746: op.fn = h_addme; return true;
+		case 40: case 552: op.fn = h_subf; return true;
+		case 104: case 616: op.fn = h_neg; return true;
+		case 266: case 778: op.fn = h_add; return true;
+		case 9: case 521: op.fn = h_mulhdu; return true;
+		case 11: case 523: op.fn = h_mulhwu; return true;
+		case 73: case 585: op.fn = h_mulhd; return true;
+		case 75: case 587: op.fn = h_mulhw; return true;
+		case 233: case 745: op.fn = h_mulld; return true;
+		case 235: case 747: op.fn = h_mullw; return true;
+		case 457: case 969: op.fn = h_divdu; return true;
+		case 459: case 971: op.fn = h_divwu; return true;
+		case 489: case 1001: op.fn = h_divd; return true;
+		case 491: case 1003: op.fn = h_divw; return true;
+		case 28: op.fn = h_and; return true;
+		case 60: op.fn = h_andc; return true;
+		case 444: op.fn = h_or; return true;
+		case 412: op.fn = h_orc; return true;
+		case 316: op.fn = h_xor; return true;
+		case 124: op.fn = h_nor; return true;
+		case 476: op.fn = h_nand; return true;
+		case 284: op.fn = h_eqv; return true;
+		case 24: op.fn = h_slw; return true;
+		case 536: op.fn = h_srw; return true;
+		case 27: op.fn = h_sld; return true;
+		case 539: op.fn = h_srd; return true;
+		case 792: op.fn = h_sraw; return true;
+		case 794: op.fn = h_srad; return true;
+		case 824: op.fn = h_srawi; op.sh = XFORM_RB(inst); return true;
+		case 826: case 827: op.fn = h_sradi; op.sh = MDFORM_sh(inst); return true;
+		case 26: op.fn = h_cntlzw; return true;
+		case 58: op.fn = h_cntlzd; return true;
+		case 954: op.fn = h_extsb; return true;
+		case 922: op.fn = h_extsh; return true;
+		case 986: op.fn = h_extsw; return true;
+		case 19: op.fn = h_mfcr; return true;
+		case 144: op.fn = h_mtcrf; op.imm = (inst >> 12) & 0xff; return true;
+		case 339:
+			switch (XFXFORM_SPR(inst)) {
+			case 1: op.fn = h_mfxer; return true;
+			case 8: op.fn = h_mflr; return true;
+			case 9: op.fn = h_mfctr; return true;
+			case 268: op.fn = h_mftb; return true;
+			}
+			return false;
+		case 371:
+			/* mftb */
+			op.fn = h_mftb;
+			return true;
+		case 467:
+			switch (XFXFORM_SPR(inst)) {
+			case 1: op.fn = h_mtxer; return true;
+			case 8: op.fn = h_mtlr; return true;
+			case 9: op.fn = h_mtctr; return true;
+			}
+			return false;
+		case 20: op.fn = h_larx<4>; return true;
+		case 84: op.fn = h_larx<8>; return true;
+		case 150: op.fn = h_stcx<4>; return true;
+		case 214: op.fn = h_stcx<8>; return true;
+		case 21: op.fn = h_load<8, false, false, true>; return true;
+		case 53: op.fn = h_load<8, false, true, true>; return true;
+		case 23: op.fn = h_load<4, false, false, true>; return true;
+		case 55: op.fn = h_load<4, false, true, true>; return true;
+		case 341: op.fn = h_load<4, true, false, true>; return true;
+		case 87: op.fn = h_load<1, false, false, true>; return true;
+		case 119: op.fn = h_load<1, false, true, true>; return true;
+		case 279: op.fn = h_load<2, false, false, true>; return true;
+		case 311: op.fn = h_load<2, false, true, true>; return true;
+		case 343: op.fn = h_load<2, true, false, true>; return true;
+		case 149: op.fn = h_store<8, false, true>; return true;
+		case 181: op.fn = h_store<8, true, true>; return true;
+		case 151: op.fn = h_store<4, false, true>; return true;
+		case 183: op.fn = h_store<4, true, true>; return true;
+		case 215: op.fn = h_store<1, false, true>; return true;
+		case 247: op.fn = h_store<1, true, true>; return true;
+		case 407: op.fn = h_store<2, false, true>; return true;
+		case 439: op.fn = h_store<2, true, true>; return true;
+		case 597: op.fn = h_lswi; op.imm = XFORM_NB(inst); return true;
+		case 725: op.fn = h_stswi; op.imm = XFORM_NB(inst); return true;
+		case 54: case 86: case 246: case 278: case 598: case 854: case 982:
+			/* dcbst, dcbf, dcbtst, dcbt, sync, eieio, icbi */
+			op.fn = h_nop;
+			return true;
+		}
+		return false;
+	case 32: op.fn = h_load<4, false, false, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 33: op.fn = h_load<4, false, true, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 34: op.fn = h_load<1, false, false, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 35: op.fn = h_load<1, false, true, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 36: op.fn = h_store<4, false, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 37: op.fn = h_store<4, true, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 38: op.fn = h_store<1, false, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 39: op.fn = h_store<1, true, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 40: op.fn = h_load<2, false, false, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 41: op.fn = h_load<2, false, true, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 42: op.fn = h_load<2, true, false, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 43: op.fn = h_load<2, true, true, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 44: op.fn = h_store<2, false, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 45: op.fn = h_store<2, true, false>; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 46: op.fn = h_lmw; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 47: op.fn = h_stmw; op.imm = SEXT16(DFORM_D(inst)); return true;
+	case 58:
+		op.imm = SEXT16(DSFORM_DS(inst));
+		switch (inst & 3) {
+		case 0: op.fn = h_load<8, false, false, false>; return true;
+		case 1: op.fn = h_load<8, false, true, false>; return true;
+		case 2: op.fn = h_load<4, true, false, false>; return true;
+		}
+		return false;
+	case 62:
+		op.imm = SEXT16(DSFORM_DS(inst));
+		switch (inst & 3) {
+		case 0: op.fn = h_store<8, false, false>; return true;
+		case 1: op.fn = h_store<8, true, false>; return true;
+		}
+		return false;
+	}
+	return false;
+}
+
+EmuBlock *PpcEmulator::Translate(uint64_t pc) {
+	auto block = std::make_unique<EmuBlock>();
+	block->start = pc;
+	block->count = 0;
+
+	uint64_t addr = pc;
+	for (;;) {
+		EmuOp op;
+		EmuPage *page = mem.Page(addr);
+		if (!page || (addr & 3)) {
+			memset(&op, 0, sizeof(op));
+			op.fn = h_fetchfault;
+			op.pc = addr;
+			block->ops.push_back(op);
+			break;
+		}
+		page->code = true;
+		uint32_t inst = ReadInstruction(page->data + (addr & (EMU_PAGE_SIZE - 1)));
+
+		bool terminator = false;
+		if (!(RECORD_FLAGS(PpcDecoder::Decode(inst, addr)) & INSN_VALID)) {
+			op.fn = h_invalid;
+			op.pc = addr;
+			terminator = true;
+		} else if (!TranslateOne(inst, addr, op, terminator)) {
+			op.fn = h_unimplemented;
+			op.pc = addr;
+			terminator = true;
+		}
+		block->ops.push_back(op);
+		block->count++;
+		addr += 4;
+		if (terminator)
+			break;
+		if (block->ops.size() >= EMU_MAX_BLOCK_OPS) {
+			memset(&op, 0, sizeof(op));
+			op.fn = h_jump;
+			op.pc = addr;
+			op.imm = addr;
+			block->ops.push_back(op);
+			break;
+		}
+	}
+
+	EmuBlock *b = block.get();
+	blocks[pc] = std::move(block);
+	return b;
+}
+
+EmuBlock *PpcEmulator::GetBlock(uint64_t pc) {
+	EmuBlock *&slot = blockCache[(pc >> 2) % EMU_BLOCK_CACHE_SIZE];
+	if (slot && slot->start == pc)
+		return slot;
+	auto it = blocks.find(pc);
+	slot = it != blocks.end() ? it->second.get() : Translate(pc);
+	return slot;
+}
+
+void PpcEmulator::FlushBlocks() {
+	blocks.clear();
+	memset(blockCache, 0, sizeof(blockCache));
+	mem.ClearCodeMarks();
+	codeDirty = false;
+}
+
+PpcEmulator::PpcEmulator() {
+	memset(&cpu, 0, sizeof(cpu));
+	memset(blockCache, 0, sizeof(blockCache));
+}
+
+EmuStatus PpcEmulator::Run(uint64_t stopAddr, uint64_t maxInsns) {
+	uint64_t limit = executed + maxInsns;
+	status = EmuStatus::Running;
+	while (status == EmuStatus::Running) {
+		if (cpu.pc == stopAddr) {
+			status = EmuStatus::Stopped;
+			break;
+		}
+		if (executed >= limit) {
+			status = EmuStatus::InstructionLimit;
+			break;
+		}
+
+		EmuBlock *block = GetBlock(cpu.pc);
+		executed += block->count;
+		const EmuOp *op = block->ops.data();
+		do {
+			op = op->fn(*this, op);
+		} while (op);
+
+		// Handlers that stop mid-block leave pc at the first instruction
+		// that did not complete.
+		if (status != EmuStatus::Running)
+			executed -= block->count - std::min(block->count, (cpu.pc - block->start) / 4);
+		// Guest code wrote to a page blocks were translated from
+		if (codeDirty)
+			FlushBlocks();
+	}
+	return status;
+}
@@ -0,0 +1,154 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Standalone PPC64 (big-endian, 64-bit mode) emulator for running small
+ * routines such as decompressors and string decryptors.
+ *
+ * Code is translated one basic block at a time into arrays of predecoded
+ * ops. Each op carries a pointer to its handler and the handler returns the
+ * next op to run, so execution never goes back through the decoder.
+ * Translated blocks are cached until guest code writes to a page that
+ * blocks were translated from.
+ *
+ * Memory is sparse and paged; guest accesses to pages that were never
+ * mapped fault. OE (XER.OV) and FP/vector state are not modelled.
+ */
+
+#define EMU_PAGE_SHIFT 12
+#define EMU_PAGE_SIZE (1 << EMU_PAGE_SHIFT)
+#define EMU_TLB_SIZE 256
+#define EMU_BLOCK_CACHE_SIZE 4096
+#define EMU_MAX_BLOCK_OPS 128
+
+#define EMU_XER_SO 0x80000000ull
+#define EMU_XER_OV 0x40000000ull
+#define EMU_XER_CA 0x20000000ull
+
+enum class EmuStatus {
+	Running,
+	Stopped,		// reached the stop address
+	InstructionLimit,
+	MemoryFault,
+	InvalidInstruction,
+	Unimplemented,
+	SystemCall,
+	Trap,
+};
+
+struct EmuCpu {
+	uint64_t gpr[32];
+	uint64_t lr;
+	uint64_t ctr;
+	uint64_t xer;
+	uint32_t cr;
+	uint64_t pc;
+};
+
+struct EmuPage {
+	uint8_t data[EMU_PAGE_SIZE];
+	bool code = false;	// blocks were translated from this page
+};
+
+class EmuMemory {
+private:
+	struct TlbEntry {
+		uint64_t tag;
+		EmuPage *page;
+	};
+	std::unordered_map<uint64_t, std::unique_ptr<EmuPage>> pages;
+	TlbEntry tlb[EMU_TLB_SIZE];
+
+	EmuPage *Lookup(uint64_t addr);
+public:
+	EmuMemory();
+
+	// Maps zero-filled pages covering [addr, addr+len).
+	void Map(uint64_t addr, uint64_t len);
+	// Host-side access. Write maps pages as needed; Read fails on
+	// unmapped pages.
+	void Write(uint64_t addr, const void *data, size_t len);
+	bool Read(uint64_t addr, void *data, size_t len);
+
+	EmuPage *Page(uint64_t addr) {
+		TlbEntry &e = tlb[(addr >> EMU_PAGE_SHIFT) % EMU_TLB_SIZE];
+		if (e.page && e.tag == (addr >> EMU_PAGE_SHIFT))
+			return e.page;
+		return Lookup(addr);
+	}
+
+	void ClearCodeMarks();
+};
+
+class PpcEmulator;
+struct EmuOp;
+
+typedef const EmuOp *(*EmuHandler)(PpcEmulator &e, const EmuOp *op);
+
+struct EmuOp {
+	EmuHandler fn;
+	uint64_t imm;	// immediate, mask or branch target
+	uint64_t pc;
+	uint32_t inst;
+	uint8_t rt, ra, rb;
+	uint8_t rc;	// record bit (Rc) or link bit (LK)
+	uint8_t sh;
+	uint8_t aux;	// BO, BF, TO, ...
+};
+
+struct EmuBlock {
+	uint64_t start;
+	uint64_t count;	// guest instructions in the block
+	std::vector<EmuOp> ops;
+};
+
+class PpcEmulator {
+private:
+	std::unordered_map<uint64_t, std::unique_ptr<EmuBlock>> blocks;
+	EmuBlock *blockCache[EMU_BLOCK_CACHE_SIZE];
+
+	EmuBlock *GetBlock(uint64_t pc);
+	EmuBlock *Translate(uint64_t pc);
+	bool TranslateOne(uint32_t inst, uint64_t pc, EmuOp &op, bool &terminator);
+	void FlushBlocks();
+public:
+	EmuCpu cpu;
+	EmuMemory mem;
+	EmuStatus status = EmuStatus::Stopped;
+	uint64_t executed = 0;
+	uint64_t faultAddr = 0;
+	bool codeDirty = false;
+
+	// Reservation for lwarx/ldarx and stwcx./stdcx.
+	bool reserved = false;
+	uint64_t reserveAddr = 0;
+
+	PpcEmulator();
+
+	// Runs from cpu.pc until the stop address is reached at a block
+	// boundary, maxInsns instructions have run, or the guest stops. On a
+	// fault or trap, cpu.pc is the address of the offending instruction;
+	// on sc it is the address after it.
+	EmuStatus Run(uint64_t stopAddr, uint64_t maxInsns);
+};
@@ -0,0 +1,243 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "funchash.h"
+#include "decoder.h"
+#include "regmask.h"
+#include "threadpool.h"
+
+#include "decode_macros.h"
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+#define FUNCHASH_CHUNK 256
+#define FUNCHASH_ROWS (FUNCHASH_MINHASH / FUNCHASH_BANDS)
+// Band buckets this full hold boilerplate (stubs, thunks) and are skipped
+#define FUNCHASH_MAX_BUCKET 64
+
+static const uint64_t K = 0x9e3779b97f4a7c15ull;
+
+static inline uint64_t Mix(uint64_t h, uint64_t v) {
+	h = (h ^ v) * K;
+	return h ^ (h >> 29);
+}
+
+// Multiply-shift hash family for the MinHash slots, fixed so signatures
+// compare across runs
+struct MinHashFamily {
+	uint64_t a[FUNCHASH_MINHASH];
+	uint64_t b[FUNCHASH_MINHASH];
+
+	MinHashFamily() {
+		uint64_t state = 0x70706336;
+		for (size_t i = 0; i < FUNCHASH_MINHASH; i++) {
+			state = Mix(state, i);
+			a[i] = state | 1;
+			state = Mix(state, i);
+			b[i] = state;
+		}
+	}
+};
+
+static const MinHashFamily &Family() {
+	static const MinHashFamily family;
+	return family;
+}
+
+uint32_t PpcMaskWord(uint32_t inst, uint32_t &high) {
+	uint32_t primary = inst >> 26;
+	uint32_t rt = DFORM_RT(inst), ra = DFORM_RA(inst);
+	// Bases whose displacements depend on where the code or data landed
+	uint32_t bases = high | REGMASK_GPR(2);
+	bool based = ra != 0 && (bases & REGMASK_GPR(ra));
+	uint32_t masked = inst;
+
+	switch (primary) {
+	case 16:
+		/* bc: BD */
+		masked &= ~0xfffcu;
+		break;
+	case 18:
+		/* b: LI */
+		masked &= ~0x03fffffcu;
+		break;
+	case 15:
+		/* addis/lis */
+		masked &= ~0xffffu;
+		break;
+	case 24:
+		/* ori: the low half of a lis/ori pair */
+		if (high & REGMASK_GPR(rt))
+			masked &= ~0xffffu;
+		break;
+	case 14:
+		/* addi */
+		if (based)
+			masked &= ~0xffffu;
+		break;
+	case 58:
+	case 62:
+		/* ld/ldu/lwa, std/stdu: DS */
+		if (based)
+			masked &= ~0xfffcu;
+		break;
+	default:
+		if (primary >= 32 && primary <= 55 && based)
+			masked &= ~0xffffu;
+		break;
+	}
+
+	PpcRegUsage u = PpcGetRegUsage(inst);
+	if (!(u.defs & REGMASK_UNKNOWN))
+		high &= ~(uint32_t)u.defs;
+	if (primary == 15)
+		high |= REGMASK_GPR(rt);
+	return masked;
+}
+
+void PpcHashFunction(const PpcCodeSpan &code, PpcFunctionHash &hash) {
+	const MinHashFamily &family = Family();
+	size_t words = code.len / 4;
+	hash.words = words;
+	std::fill(hash.minhash, hash.minhash + FUNCHASH_MINHASH, UINT32_MAX);
+
+	uint64_t exact = words * K;
+	uint32_t high = 0;
+	// Ring of the last FUNCHASH_SHINGLE masked words
+	uint32_t ring[FUNCHASH_SHINGLE] = {};
+	for (size_t i = 0; i < words; i++) {
+		uint32_t m = PpcMaskWord(ReadInstruction(code.data + i * 4), high);
+		exact = Mix(exact, m);
+		ring[i % FUNCHASH_SHINGLE] = m;
+		// Functions shorter than a shingle get one shingle of all words
+		if (i + 1 < FUNCHASH_SHINGLE && i + 1 < words)
+			continue;
+		uint64_t s = 0;
+		size_t n = std::min<size_t>(i + 1, FUNCHASH_SHINGLE);
+		for (size_t k = 0; k < n; k++)
+			s = Mix(s, ring[(i + 1 - n + k) % FUNCHASH_SHINGLE]);
+		for (size_t j = 0; j < FUNCHASH_MINHASH; j++)
+			hash.minhash[j] = std::min(hash.minhash[j], (uint32_t)((family.a[j] * s + family.b[j]) >> 32));
+	}
+	hash.exact = exact ^ (exact >> 32);
+
+	for (size_t band = 0; band < FUNCHASH_BANDS; band++) {
+		uint64_t h = band * K;
+		for (size_t r = 0; r < FUNCHASH_ROWS; r++)
+			h = Mix(h, hash.minhash[band * FUNCHASH_ROWS + r]);
+		hash.bands[band] = h;
+	}
+}
+
+void PpcHashFunctions(const std::vector<PpcCodeSpan> &functions, std::vector<PpcFunctionHash> &hashes, size_t threads) {
+	hashes.resize(functions.size());
+	size_t count = (functions.size() + FUNCHASH_CHUNK - 1) / FUNCHASH_CHUNK;
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	ThreadPool pool(std::min(threads, std::max<size_t>(count, 1)), false);
+	for (size_t c = 0; c < count; c++) {
+		pool.Enqueue([&, c]() {
+			size_t end = std::min(functions.size(), (c + 1) * FUNCHASH_CHUNK);
+			for (size_t i = c * FUNCHASH_CHUNK; i < end; i++)
+				PpcHashFunction(functions[i], hashes[i]);
+		});
+	}
+	// The pool's destructor waits for the queue to drain
+}
+
+double PpcSimilarity(const PpcFunctionHash &a, const PpcFunctionHash &b) {
+	size_t same = 0;
+	for (size_t i = 0; i < FUNCHASH_MINHASH; i++)
+		same += a.minhash[i] == b.minhash[i];
+	return (double)same / FUNCHASH_MINHASH;
+}
+
+// Index of each exact hash, or -1 when it occurs more than once
+static std::unordered_map<uint64_t, int64_t> UniqueExact(const std::vector<PpcFunctionHash> &v) {
+	std::unordered_map<uint64_t, int64_t> m;
+	for (size_t i = 0; i < v.size(); i++) {
+		auto it = m.emplace(v[i].exact, i);
+		if (!it.second)
+			it.first->second = -1;
+	}
+	return m;
+}
+
+void PpcMatchFunctions(const std::vector<PpcFunctionHash> &a, const std::vector<PpcFunctionHash> &b,
+	double threshold, std::vector<PpcFunctionMatch> &matches) {
+	matches.clear();
+	std::vector<bool> usedA(a.size()), usedB(b.size());
+
+	auto exactA = UniqueExact(a), exactB = UniqueExact(b);
+	for (size_t i = 0; i < a.size(); i++) {
+		if (exactA[a[i].exact] < 0)
+			continue;
+		auto it = exactB.find(a[i].exact);
+		if (it == exactB.end() || it->second < 0)
+			continue;
+		matches.push_back({i, (size_t)it->second, 1.0});
+		usedA[i] = true;
+		usedB[it->second] = true;
+	}
+
+	// Empty functions would share every band, so they only match exactly
+	std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+	for (size_t j = 0; j < b.size(); j++) {
+		if (usedB[j] || !b[j].words)
+			continue;
+		for (size_t band = 0; band < FUNCHASH_BANDS; band++)
+			buckets[b[j].bands[band]].push_back(j);
+	}
+
+	std::vector<PpcFunctionMatch> candidates;
+	std::vector<uint32_t> seen;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (usedA[i] || !a[i].words)
+			continue;
+		seen.clear();
+		for (size_t band = 0; band < FUNCHASH_BANDS; band++) {
+			auto it = buckets.find(a[i].bands[band]);
+			if (it == buckets.end() || it->second.size() > FUNCHASH_MAX_BUCKET)
+				continue;
+			seen.insert(seen.end(), it->second.begin(), it->second.end());
+		}
+		std::sort(seen.begin(), seen.end());
+		seen.erase(std::unique(seen.begin(), seen.end()), seen.end());
+		for (uint32_t j : seen) {
+			// Identical bodies that repeat on either side are ambiguous
+			if (a[i].exact == b[j].exact)
+				continue;
+			double s = PpcSimilarity(a[i], b[j]);
+			if (s >= threshold)
+				candidates.push_back({i, j, s});
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const PpcFunctionMatch &x, const PpcFunctionMatch &y) {
+		if (x.similarity != y.similarity)
+			return x.similarity > y.similarity;
+		return x.a != y.a ? x.a < y.a : x.b < y.b;
+	});
+	for (const PpcFunctionMatch &c : candidates) {
+		if (usedA[c.a] || usedB[c.b])
+			continue;
+		usedA[c.a] = usedB[c.b] = true;
+		matches.push_back(c);
+	}
+}
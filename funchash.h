@@ -0,0 +1,80 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Relocation-masked function signatures for matching functions across
+ * builds.
+ *
+ * Before hashing, each word has its position-dependent fields cleared:
+ * - branch displacements (LI, BD);
+ * - addis/lis immediates;
+ * - D/DS displacements based on r2;
+ * - D/DS displacements and ori immediates based on a register whose
+ *   value last came from addis/lis.
+ *
+ * The exact hash covers the whole masked stream. The MinHash signature
+ * covers the set of FUNCHASH_SHINGLE-word runs, so the fraction of equal
+ * slots estimates how similar two functions' bodies are. The slots are
+ * grouped into FUNCHASH_BANDS LSH bands; functions that share any band
+ * key are match candidates.
+ */
+
+#define FUNCHASH_SHINGLE	4
+#define FUNCHASH_MINHASH	64
+#define FUNCHASH_BANDS		16	// of FUNCHASH_MINHASH / FUNCHASH_BANDS rows
+
+struct PpcCodeSpan {
+	const uint8_t *data;	// big-endian words
+	size_t len;
+};
+
+struct PpcFunctionHash {
+	uint64_t exact;
+	uint32_t words;
+	uint32_t minhash[FUNCHASH_MINHASH];
+	uint64_t bands[FUNCHASH_BANDS];
+};
+
+struct PpcFunctionMatch {
+	size_t a;
+	size_t b;
+	double similarity;	// 1.0 for exact matches
+};
+
+// inst with its position-dependent fields cleared. high holds the GPRs
+// whose value last came from addis/lis and is updated for the next word.
+uint32_t PpcMaskWord(uint32_t inst, uint32_t &high);
+
+void PpcHashFunction(const PpcCodeSpan &code, PpcFunctionHash &hash);
+
+// Hashes every span on threads workers (0 = one per core).
+void PpcHashFunctions(const std::vector<PpcCodeSpan> &functions, std::vector<PpcFunctionHash> &hashes, size_t threads = 0);
+
+// Estimated Jaccard similarity of the two functions' shingle sets
+double PpcSimilarity(const PpcFunctionHash &a, const PpcFunctionHash &b);
+
+// Pairs functions of two builds, each at most once. Exact hashes that
+// are unique on both sides match first; the rest are paired best first
+// among LSH candidates whose similarity is at least threshold. Bodies
+// repeated on either side are left unmatched rather than guessed.
+void PpcMatchFunctions(const std::vector<PpcFunctionHash> &a, const std::vector<PpcFunctionHash> &b,
+	double threshold, std::vector<PpcFunctionMatch> &matches);
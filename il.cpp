@@ -15,16 +15,541 @@
  */
 
 #include "il.h"
+#include "decoder.h"
 #include "intrinsics.h"
+#include "regmask.h"
+#include "spr.h"
+#include "toc.h"
 
 #include <lowlevelilinstruction.h>
 
+#include <algorithm>
+
 using namespace BinaryNinja;
 
 #include "decode_macros.h"
 
+/* Fidelity */
+
+#define CARRY_LOOKAHEAD 4
+
+uint32_t PpcLifter::Cr0Write() {
+	return fidelity == LiftFidelity::Fast ? FLAG_WRITE_CR0_NOSO : FLAG_WRITE_CR0;
+}
+
+// At the fast level CA is only dropped when a following instruction in
+// the same block writes it before anything reads it.
+uint32_t PpcLifter::CarryWrite() {
+	if (fidelity != LiftFidelity::Fast)
+		return FLAG_WRITE_CA;
+	size_t followingLen = windowLen < 4 ? 0 : windowLen - 4;
+	size_t count = std::min<size_t>(CARRY_LOOKAHEAD, followingLen / 4);
+	PpcRegUsage usage[CARRY_LOOKAHEAD];
+	PpcGetRegUsageBlock(window + 4, count, usage);
+	for (size_t i = 0; i < count; i++) {
+		uint32_t primary = ReadInstruction(window + 4 + i * 4) >> 26;
+		if (primary == 16 || primary == 18 || primary == 19)
+			return FLAG_WRITE_CA;
+		if (usage[i].uses & (REGMASK_CA | REGMASK_UNKNOWN))
+			return FLAG_WRITE_CA;
+		if (usage[i].defs & REGMASK_CA)
+			return 0;
+	}
+	return FLAG_WRITE_CA;
+}
+
+// The so bit of a CR field, copied from XER.SO
+void PpcLifter::SetSummaryOverflow(uint32_t flag) {
+	if (fidelity != LiftFidelity::Fast)
+		il->AddInstruction(il->SetFlag(flag, il->Flag(FLAG_XER_SO)));
+}
+
+// Rc=1 floating-point forms copy FPSCR[FX,FEX,VX,OX] into CR1. The
+// arithmetic does not model FPSCR status bits, so this is the FPSCR as
+// last written by mtfsf, mtfsfi and mtfsb0/1.
+void PpcLifter::SetCr1() {
+	for (uint32_t i = 0; i < 4; i++) {
+		ExprId bit = il->And(4, il->Register(4, PPC_REG_FPSCR), il->Const(4, 0x80000000u >> i));
+		il->AddInstruction(il->SetFlag(FLAG_CR1_FX + i, il->CompareNotEqual(4, bit, il->Const(4, 0))));
+	}
+}
+
+// XER.SO, OV and CA are the FLAG_XER_* flags that arithmetic reads and
+// writes; the xer register holds the remaining bits. mfxer and mtxer
+// compose and split the two.
+void PpcLifter::MoveFromXer(uint32_t rt) {
+	ExprId value = il->And(8, il->Register(8, PPC_REG_SPR(1)), il->Const(8, ~0xe0000000ull));
+	for (uint32_t i = 0; i < 3; i++) {
+		ExprId bit = il->ShiftLeft(8, il->BoolToInt(8, il->Flag(FLAG_XER_SO + i)), il->Const(1, 31 - i));
+		value = il->Or(8, value, bit);
+	}
+	il->AddInstruction(il->SetRegister(8, rt, value));
+}
+
+void PpcLifter::MoveToXer(uint32_t rs) {
+	il->AddInstruction(il->SetRegister(8, PPC_REG_SPR(1), il->Register(8, rs)));
+	for (uint32_t i = 0; i < 3; i++) {
+		ExprId bit = il->And(8, il->Register(8, rs), il->Const(8, 0x80000000u >> i));
+		il->AddInstruction(il->SetFlag(FLAG_XER_SO + i, il->CompareNotEqual(8, bit, il->Const(8, 0))));
+	}
+}
+
+// Cache hints, barriers and TLB/SLB maintenance lift to Nop at the fast
+// level; callers emit their intrinsic when this returns false.
+bool PpcLifter::SkipBarrier() {
+	if (fidelity != LiftFidelity::Fast)
+		return false;
+	il->AddInstruction(il->Nop());
+	return true;
+}
+
+/* Helpers */
+
+// ELFv2 global entry: r12 holds the entry address, so r2 is a constant.
+// Callers of the local entry are folded into this one (see toc.h).
+bool PpcLifter::LiftGlobalEntry(uint64_t addr) {
+	uint64_t toc;
+	if (!window || !PpcMatchGlobalEntry(window, windowLen, addr, toc))
+		return false;
+	// The addi that follows adds its own half
+	uint32_t lo = ReadInstruction(window + 4) & 0xffff;
+	il->AddInstruction(il->SetRegister(8, 2, il->ConstPointer(8, toc - SEXT16(lo))));
+	return true;
+}
+
+uint64_t PpcLifter::FoldCall(uint64_t dst) {
+	return tocTable ? tocTable->Fold(dst) : dst;
+}
+
+ExprId PpcLifter::FReg(uint32_t reg) {
+	return il->Register(8, PPC_REG_FPR(reg));
+}
+
+ExprId PpcLifter::SetFReg(uint32_t reg, ExprId value) {
+	return il->SetRegister(8, PPC_REG_FPR(reg), value);
+}
+
+// FPRs always hold doubles; single-precision results are rounded to
+// single and widened back.
+ExprId PpcLifter::RoundSingle(ExprId value) {
+	return il->FloatConvert(8, il->FloatConvert(4, value));
+}
+
+ExprId PpcLifter::AddressD(uint32_t ra, uint32_t d) {
+	if (ra == 0)
+		return il->ConstPointer(8, SEXT16(d));
+	return il->Add(8, il->Register(8, ra), il->Const(8, SEXT16(d)));
+}
+
+ExprId PpcLifter::AddressX(uint32_t ra, uint32_t rb) {
+	if (ra == 0)
+		return il->Register(8, rb);
+	return il->Add(8, il->Register(8, ra), il->Register(8, rb));
+}
+
+/* Load/store multiple and string moves */
+
+// (ra|0) + disp, where disp may run past the 16-bit D field
+ExprId PpcLifter::BlockAddress(uint32_t ra, int64_t disp) {
+	if (ra == 0)
+		return il->ConstPointer(8, disp);
+	if (disp == 0)
+		return il->Register(8, ra);
+	return il->Add(8, il->Register(8, ra), il->Const(8, disp));
+}
+
+// n bytes placed from the top of the low word down, rest zeroed
+ExprId PpcLifter::BlockLoadWord(uint32_t ra, int64_t disp, uint32_t n) {
+	if (n == 4)
+		return il->ZeroExtend(8, il->Load(4, BlockAddress(ra, disp)));
+	uint32_t head = n == 1 ? 1 : 2;
+	ExprId value = il->ShiftLeft(8, il->ZeroExtend(8, il->Load(head, BlockAddress(ra, disp))), il->Const(1, 32 - 8 * head));
+	if (n == 3)
+		value = il->Or(8, value, il->ShiftLeft(8, il->ZeroExtend(8, il->Load(1, BlockAddress(ra, disp + 2))), il->Const(1, 8)));
+	return value;
+}
+
+void PpcLifter::BlockStoreWord(uint32_t rs, uint32_t ra, int64_t disp, uint32_t n) {
+	if (n == 4) {
+		il->AddInstruction(il->Store(4, BlockAddress(ra, disp), il->LowPart(4, il->Register(8, rs))));
+		return;
+	}
+	uint32_t head = n == 1 ? 1 : 2;
+	il->AddInstruction(il->Store(head, BlockAddress(ra, disp),
+		il->LowPart(head, il->LogicalShiftRight(8, il->Register(8, rs), il->Const(1, 32 - 8 * head)))));
+	if (n == 3)
+		il->AddInstruction(il->Store(1, BlockAddress(ra, disp + 2),
+			il->LowPart(1, il->LogicalShiftRight(8, il->Register(8, rs), il->Const(1, 8)))));
+}
+
+// lmw/lswi: bytes fill rt, rt+1, ... four at a time, wrapping past r31,
+// one load per register so every register write stays visible.
+void PpcLifter::LiftBlockLoad(uint32_t rt, uint32_t ra, int64_t disp, uint32_t bytes) {
+	uint32_t count = (bytes + 3) / 4;
+	auto load = [&](uint32_t k) {
+		uint32_t reg = (rt + k) & 31, n = std::min(4u, bytes - 4 * k);
+		il->AddInstruction(il->SetRegister(8, reg, BlockLoadWord(ra, disp + 4 * k, n)));
+	};
+	// A base register inside the range is an invalid form. Load it last
+	// so every address is formed from its old value.
+	uint32_t base = count;
+	for (uint32_t k = 0; k < count; k++) {
+		if (ra != 0 && ((rt + k) & 31) == ra)
+			base = k;
+	}
+	for (uint32_t k = 0; k < count; k++) {
+		if (k != base)
+			load(k);
+	}
+	if (base < count)
+		load(base);
+}
+
+// stmw/stswi: the store counterpart, reading the low word of each register
+void PpcLifter::LiftBlockStore(uint32_t rs, uint32_t ra, int64_t disp, uint32_t bytes) {
+	uint32_t count = (bytes + 3) / 4;
+	for (uint32_t k = 0; k < count; k++)
+		BlockStoreWord((rs + k) & 31, ra, disp + 4 * k, std::min(4u, bytes - 4 * k));
+}
+
+ExprId PpcLifter::VecValue(const VecOperand &op) {
+	switch (op.kind) {
+	case VecOperandKind::VR:
+		return il->Register(16, PPC_REG_VR(op.value));
+	case VecOperandKind::VSR:
+		return il->Register(16, PPC_REG_VSR(op.value));
+	case VecOperandKind::GPR:
+		return il->Register(8, op.value);
+	case VecOperandKind::Mem:
+		if (op.value == 0)
+			return il->ConstPointer(8, op.disp);
+		return il->Add(8, il->Register(8, op.value), il->Const(8, op.disp));
+	case VecOperandKind::MemX:
+		return AddressX(op.value, op.index);
+	default:
+		return il->Const(VecOperandSize(op.kind), op.value);
+	}
+}
+
+/*
+ * Builds the condition for a BO/BI pair. Decrementing forms emit the CTR
+ * update here, once, and test the new value. A plain "branch if CR bit
+ * false" returns the flag itself with negate set, so callers swap their
+ * targets instead of comparing. Returns BN_INVALID_EXPR for branch always.
+ */
+ExprId PpcLifter::BranchCondition(uint32_t bo, uint32_t bi, bool &negate) {
+	ExprId ctr = BN_INVALID_EXPR, cr = BN_INVALID_EXPR;
+	negate = false;
+	if ((bo & 0b00100) == 0) {
+		il->AddInstruction(il->SetRegister(8, PPC_REG_CTR, il->Sub(8, il->Register(8, PPC_REG_CTR), il->Const(8, 1))));
+		if (bo & 0b00010)
+			ctr = il->CompareEqual(8, il->Register(8, PPC_REG_CTR), il->Const(8, 0));
+		else
+			ctr = il->CompareNotEqual(8, il->Register(8, PPC_REG_CTR), il->Const(8, 0));
+	}
+	if ((bo & 0b10000) == 0) {
+		cr = il->Flag(bi);
+		if ((bo & 0b01000) == 0) {
+			if (ctr == BN_INVALID_EXPR) {
+				negate = true;
+				return cr;
+			}
+			cr = il->CompareEqual(1, cr, il->Const(1, 0));
+		}
+	}
+	if (ctr == BN_INVALID_EXPR)
+		return cr;
+	if (cr == BN_INVALID_EXPR)
+		return ctr;
+	return il->And(1, ctr, cr);
+}
+
+// Runs taken only when the condition holds, then falls through.
+void PpcLifter::BranchIf(ExprId cond, bool negate, ExprId taken) {
+	LowLevelILLabel takenLabel, skipLabel;
+	if (negate)
+		il->AddInstruction(il->If(cond, skipLabel, takenLabel));
+	else
+		il->AddInstruction(il->If(cond, takenLabel, skipLabel));
+	il->MarkLabel(takenLabel);
+	il->AddInstruction(taken);
+	il->MarkLabel(skipLabel);
+}
+
+void PpcLifter::ConditionalJump(ExprId cond, bool negate, uint64_t dst, uint64_t next) {
+	if (negate)
+		std::swap(dst, next);
+	BNLowLevelILLabel *t = il->GetLabelForAddress(arch, dst);
+	BNLowLevelILLabel *f = il->GetLabelForAddress(arch, next);
+	LowLevelILLabel trueLabel, falseLabel;
+	il->AddInstruction(il->If(cond, t ? *t : trueLabel, f ? *f : falseLabel));
+	if (!t) {
+		il->MarkLabel(trueLabel);
+		il->AddInstruction(il->Jump(il->ConstPointer(8, dst)));
+	}
+	if (!f) {
+		il->MarkLabel(falseLabel);
+		il->AddInstruction(il->Jump(il->ConstPointer(8, next)));
+	}
+}
+
+// tw/td/twi/tdi: trap when any comparison selected by TO holds
+void PpcLifter::LiftTrap(uint32_t inst, size_t size, ExprId a, ExprId b) {
+	switch (PpcDecoder::ClassifyTrap(inst)) {
+	case TrapKind::Never:
+		il->AddInstruction(il->Nop());
+		return;
+	case TrapKind::Always:
+		il->AddInstruction(il->Trap(0));
+		return;
+	default:
+		break;
+	}
+
+	uint32_t to = (inst >> 21) & 0x1f;
+	ExprId cond = BN_INVALID_EXPR, ei0;
+	for (uint32_t bit = 0x10; bit; bit >>= 1) {
+		if (!(to & bit))
+			continue;
+		switch (bit) {
+		case 0x10: ei0 = il->CompareSignedLessThan(size, a, b); break;
+		case 0x08: ei0 = il->CompareSignedGreaterThan(size, a, b); break;
+		case 0x04: ei0 = il->CompareEqual(size, a, b); break;
+		case 0x02: ei0 = il->CompareUnsignedLessThan(size, a, b); break;
+		default: ei0 = il->CompareUnsignedGreaterThan(size, a, b); break;
+		}
+		cond = cond == BN_INVALID_EXPR ? ei0 : il->Or(1, cond, ei0);
+	}
+	BranchIf(cond, false, il->Trap(0));
+}
+
+static uint32_t VecRegister(const VecOperand &op) {
+	switch (op.kind) {
+	case VecOperandKind::VR: return PPC_REG_VR(op.value);
+	case VecOperandKind::VSR: return PPC_REG_VSR(op.value);
+	default: return op.value;
+	}
+}
+
+/*
+ * Lifts logic, select, whole-register loads/stores and VSCR moves to
+ * LLIL, as well as scalar double ops when every VSR involved overlays an
+ * FPR. Everything else becomes an intrinsic named after the instruction.
+ */
+bool PpcLifter::LiftVectorOp(const VecOpcode &op, uint32_t inst) {
+	VecOperand ops[VEC_MAX_OPERANDS];
+	size_t n = VecDecodeOperands(op, inst, ops);
+	ExprId ei0;
+
+	bool fprOnly = true;
+	for (size_t i = 0; i < n; i++) {
+		if (ops[i].kind == VecOperandKind::VSR && ops[i].value >= 32)
+			fprOnly = false;
+	}
+
+	switch (op.lift) {
+	case VEC_LIFT_AND:
+		ei0 = il->And(16, VecValue(ops[1]), VecValue(ops[2]));
+		break;
+	case VEC_LIFT_ANDC:
+		ei0 = il->And(16, VecValue(ops[1]), il->Not(16, VecValue(ops[2])));
+		break;
+	case VEC_LIFT_OR:
+		ei0 = il->Or(16, VecValue(ops[1]), VecValue(ops[2]));
+		break;
+	case VEC_LIFT_ORC:
+		ei0 = il->Or(16, VecValue(ops[1]), il->Not(16, VecValue(ops[2])));
+		break;
+	case VEC_LIFT_XOR:
+		// vxor vt, va, va is the usual way to zero a register
+		if (ops[1].value == ops[2].value)
+			ei0 = il->Const(16, 0);
+		else
+			ei0 = il->Xor(16, VecValue(ops[1]), VecValue(ops[2]));
+		break;
+	case VEC_LIFT_NOR:
+		ei0 = il->Not(16, il->Or(16, VecValue(ops[1]), VecValue(ops[2])));
+		break;
+	case VEC_LIFT_NAND:
+		ei0 = il->Not(16, il->And(16, VecValue(ops[1]), VecValue(ops[2])));
+		break;
+	case VEC_LIFT_EQV:
+		ei0 = il->Not(16, il->Xor(16, VecValue(ops[1]), VecValue(ops[2])));
+		break;
+	case VEC_LIFT_SEL:
+		ei0 = il->Or(16,
+			il->And(16, VecValue(ops[2]), VecValue(ops[3])),
+			il->And(16, VecValue(ops[1]), il->Not(16, VecValue(ops[3])))
+		);
+		break;
+	case VEC_LIFT_LOAD:
+		ei0 = il->Load(16, VecValue(ops[1]));
+		break;
+	case VEC_LIFT_LOAD_ALIGNED:
+		ei0 = il->Load(16, il->And(8, VecValue(ops[1]), il->Const(8, ~0xfull)));
+		break;
+	case VEC_LIFT_STORE:
+		il->AddInstruction(il->Store(16, VecValue(ops[1]), VecValue(ops[0])));
+		return true;
+	case VEC_LIFT_STORE_ALIGNED:
+		il->AddInstruction(il->Store(16, il->And(8, VecValue(ops[1]), il->Const(8, ~0xfull)), VecValue(ops[0])));
+		return true;
+	case VEC_LIFT_MFVSCR:
+		ei0 = il->ZeroExtend(16, il->Register(4, PPC_REG_VSCR));
+		break;
+	case VEC_LIFT_MTVSCR:
+		il->AddInstruction(il->SetRegister(4, PPC_REG_VSCR, il->LowPart(4, VecValue(ops[0]))));
+		return true;
+	default:
+		break;
+	}
+	if (op.lift >= VEC_LIFT_AND && op.lift <= VEC_LIFT_MFVSCR) {
+		il->AddInstruction(il->SetRegister(16, VecRegister(ops[0]), ei0));
+		return true;
+	}
+
+	if (fprOnly) {
+		switch (op.lift) {
+		case VEC_LIFT_FADD:
+			il->AddInstruction(SetFReg(ops[0].value, il->FloatAdd(8, FReg(ops[1].value), FReg(ops[2].value))));
+			return true;
+		case VEC_LIFT_FSUB:
+			il->AddInstruction(SetFReg(ops[0].value, il->FloatSub(8, FReg(ops[1].value), FReg(ops[2].value))));
+			return true;
+		case VEC_LIFT_FMUL:
+			il->AddInstruction(SetFReg(ops[0].value, il->FloatMult(8, FReg(ops[1].value), FReg(ops[2].value))));
+			return true;
+		case VEC_LIFT_FDIV:
+			il->AddInstruction(SetFReg(ops[0].value, il->FloatDiv(8, FReg(ops[1].value), FReg(ops[2].value))));
+			return true;
+		case VEC_LIFT_FSQRT:
+			il->AddInstruction(SetFReg(ops[0].value, il->FloatSqrt(8, FReg(ops[1].value))));
+			return true;
+		case VEC_LIFT_FABS:
+			il->AddInstruction(SetFReg(ops[0].value, il->FloatAbs(8, FReg(ops[1].value))));
+			return true;
+		case VEC_LIFT_FNABS:
+			il->AddInstruction(SetFReg(ops[0].value, il->FloatNeg(8, il->FloatAbs(8, FReg(ops[1].value)))));
+			return true;
+		case VEC_LIFT_FNEG:
+			il->AddInstruction(SetFReg(ops[0].value, il->FloatNeg(8, FReg(ops[1].value))));
+			return true;
+		case VEC_LIFT_LOAD_SCALAR:
+			il->AddInstruction(SetFReg(ops[0].value, il->Load(8, VecValue(ops[1]))));
+			return true;
+		case VEC_LIFT_STORE_SCALAR:
+			il->AddInstruction(il->Store(8, VecValue(ops[1]), FReg(ops[0].value)));
+			return true;
+		case VEC_LIFT_MFVSRD:
+			il->AddInstruction(il->SetRegister(8, ops[0].value, FReg(ops[1].value)));
+			return true;
+		case VEC_LIFT_MTVSRD:
+			il->AddInstruction(SetFReg(ops[0].value, il->Register(8, ops[1].value)));
+			return true;
+		default:
+			break;
+		}
+	}
+
+	std::vector<RegisterOrFlag> outputs;
+	std::vector<ExprId> inputs;
+	if (op.flags & VEC_TARGET_IN)
+		inputs.push_back(VecValue(ops[0]));
+	for (size_t i = 0; i < n; i++) {
+		if (!ops[i].dest) {
+			inputs.push_back(VecValue(ops[i]));
+		} else if (ops[i].kind == VecOperandKind::CRF) {
+			for (uint32_t bit = 0; bit < 4; bit++)
+				outputs.push_back(RegisterOrFlag::Flag(ops[i].value*4 + bit));
+		} else {
+			outputs.push_back(RegisterOrFlag::Register(VecRegister(ops[i])));
+		}
+	}
+	if (op.form == VEC_VC_RC || op.form == VEC_XX3_RC) {
+		// Record forms summarize the compare in cr6
+		for (uint32_t bit = 0; bit < 4; bit++)
+			outputs.push_back(RegisterOrFlag::Flag(6*4 + bit));
+	}
+	il->AddInstruction(il->Intrinsic(outputs, VEC_INTRINSIC_BASE + VecOpcodeIndex(op), inputs));
+	return true;
+}
+
 /* Implementation */
 
+/*
+ * Lifts a reservation loop matched by PpcMatchAtomic as one intrinsic
+ * returning the old value. The stored value and compare flags are then
+ * recomputed from it, so registers live out of the loop stay correct.
+ * cr0 is only set for loops that always exit through the stcx.
+ */
+bool PpcLifter::LiftAtomic(const AtomicSequence &seq, uint64_t addr) {
+	static const Intrinsic intrinsics[] = {
+		Intrinsic::atomic_add,
+		Intrinsic::atomic_sub,
+		Intrinsic::atomic_and,
+		Intrinsic::atomic_andc,
+		Intrinsic::atomic_or,
+		Intrinsic::atomic_xor,
+		Intrinsic::atomic_swap,
+		Intrinsic::atomic_cas,
+	};
+	uint32_t id = static_cast<uint32_t>(intrinsics[static_cast<size_t>(seq.op)]);
+	ExprId operand = seq.imm ? il->Const(seq.size, seq.value) : il->Register(seq.size, seq.rx);
+	ExprId ea = AddressX(seq.ra, seq.rb);
+
+	std::vector<ExprId> inputs;
+	if (seq.op == AtomicOp::Swap)
+		inputs = {ea, il->Register(seq.size, seq.rs)};
+	else if (seq.op == AtomicOp::Cas)
+		inputs = {ea, operand, il->Register(seq.size, seq.rs)};
+	else
+		inputs = {ea, operand};
+	il->AddInstruction(il->Intrinsic({RegisterOrFlag::Register(seq.rt)}, id, inputs));
+
+	if (seq.op == AtomicOp::Cas) {
+		uint32_t bf = (seq.middle >> 23) & 7;
+		bool sign = (seq.middle >> 26) == 11 || ((seq.middle >> 26) == 31 && ((seq.middle >> 1) & 0x3ff) == 0);
+		size_t width = seq.size == 8 ? 8 : 4;
+		ExprId old = il->Register(width, seq.rt);
+		ExprId expected = seq.imm ? il->Const(width, seq.value) : il->Register(width, seq.rx);
+		if (sign) {
+			il->AddInstruction(il->SetFlag(bf*4+0, il->CompareSignedLessThan(width, old, expected)));
+			il->AddInstruction(il->SetFlag(bf*4+1, il->CompareSignedGreaterThan(width, old, expected)));
+		} else {
+			il->AddInstruction(il->SetFlag(bf*4+0, il->CompareUnsignedLessThan(width, old, expected)));
+			il->AddInstruction(il->SetFlag(bf*4+1, il->CompareUnsignedGreaterThan(width, old, expected)));
+		}
+		il->AddInstruction(il->SetFlag(bf*4+2, il->CompareEqual(width, old, expected)));
+		SetSummaryOverflow(bf*4+3);
+
+		// Strong CAS usually fails straight to the loop exit
+		uint64_t next = addr + seq.count * 4;
+		if (seq.fail != next)
+			ConditionalJump(il->Flag(bf*4+2), false, next, seq.fail);
+		return true;
+	}
+
+	if (seq.op != AtomicOp::Swap) {
+		ExprId old = il->Register(8, seq.rt);
+		ExprId x = seq.imm ? il->Const(8, seq.value) : il->Register(8, seq.rx);
+		ExprId value;
+		switch (seq.op) {
+		case AtomicOp::Add: value = il->Add(8, old, x); break;
+		case AtomicOp::Sub: value = il->Sub(8, old, x); break;
+		case AtomicOp::And: value = il->And(8, old, x); break;
+		case AtomicOp::Andc: value = il->And(8, old, il->Not(8, x)); break;
+		case AtomicOp::Or: value = il->Or(8, old, x); break;
+		default: value = il->Xor(8, old, x); break;
+		}
+		il->AddInstruction(il->SetRegister(8, seq.rs, value));
+	}
+	il->AddInstruction(il->SetFlag(FLAG_CR0_LT, il->Const(1, 0)));
+	il->AddInstruction(il->SetFlag(FLAG_CR0_GT, il->Const(1, 0)));
+	il->AddInstruction(il->SetFlag(FLAG_CR0_EQ, il->Const(1, 1)));
+	SetSummaryOverflow(FLAG_CR0_SO);
+	return true;
+}
+
 #define DECODE_MAIN PpcLifter::LiftInstruction
 #define DECODE_GROUP(g) PpcLifter::lift##g
 #define EMIT_IL
@@ -14,14 +14,41 @@
  * with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#pragma once
+
 #include <binaryninjaapi.h>
 
+#include "atomic.h"
+#include "intrinsics.h"
+#include "vector.h"
+
 using namespace BinaryNinja;
 
+class TocTable;
+
+/*
+ * How much of the architecture state the lifter models. Fast drops XER.SO
+ * and cr0.so tracking, lifts cache, TLB, SLB and barrier instructions to
+ * Nop, lifts load/store multiple and string moves as one intrinsic per
+ * register, and skips an XER.CA write that the next few instructions
+ * overwrite before reading it.
+ * It is meant for first-pass triage of very large images.
+ */
+enum class LiftFidelity : uint8_t {
+	Precise,
+	Fast,
+};
+
 class PpcLifter {
 private:
 	LowLevelILFunction *il;
 	Architecture *arch;
+	LiftFidelity fidelity;
+	// Bytes from the instruction being lifted on, for matching sequences
+	const uint8_t *window = nullptr;
+	size_t windowLen = 0;
+	// ELFv2 global entries of the view, for folding calls
+	const TocTable *tocTable = nullptr;
 
 	bool lift19(uint32_t inst);
 	bool lift30(uint32_t inst);
@@ -30,11 +57,50 @@ private:
 	bool lift59(uint32_t inst);
 	bool lift62(uint32_t inst);
 	bool lift63(uint32_t inst);
+	bool liftFloatA(uint32_t inst, bool single);
+	bool liftVector(uint32_t inst);
+	bool LiftVectorOp(const VecOpcode &op, uint32_t inst);
+
+	ExprId FReg(uint32_t reg);
+	ExprId SetFReg(uint32_t reg, ExprId value);
+	ExprId RoundSingle(ExprId value);
+	ExprId AddressD(uint32_t ra, uint32_t d);
+	ExprId AddressX(uint32_t ra, uint32_t rb);
+	ExprId BlockAddress(uint32_t ra, int64_t disp);
+	ExprId BlockLoadWord(uint32_t ra, int64_t disp, uint32_t n);
+	void BlockStoreWord(uint32_t rs, uint32_t ra, int64_t disp, uint32_t n);
+	void LiftBlockLoad(uint32_t rt, uint32_t ra, int64_t disp, uint32_t bytes);
+	void LiftBlockStore(uint32_t rs, uint32_t ra, int64_t disp, uint32_t bytes);
+	ExprId VecValue(const VecOperand &op);
+	ExprId BranchCondition(uint32_t bo, uint32_t bi, bool &negate);
+	void BranchIf(ExprId cond, bool negate, ExprId taken);
+	void ConditionalJump(ExprId cond, bool negate, uint64_t dst, uint64_t next);
+	void LiftTrap(uint32_t inst, size_t size, ExprId a, ExprId b);
+	uint32_t Cr0Write();
+	uint32_t CarryWrite();
+	void SetSummaryOverflow(uint32_t flag);
+	void SetCr1();
+	void MoveFromXer(uint32_t rt);
+	void MoveToXer(uint32_t rs);
+	bool SkipBarrier();
+	bool LiftGlobalEntry(uint64_t addr);
+	uint64_t FoldCall(uint64_t dst);
 public:
-	PpcLifter(LowLevelILFunction *il, Architecture *arch) {
+	PpcLifter(LowLevelILFunction *il, Architecture *arch, LiftFidelity fidelity = LiftFidelity::Precise) {
 		this->il = il;
 		this->arch = arch;
+		this->fidelity = fidelity;
+	}
+
+	void SetWindow(const uint8_t *data, size_t len) {
+		window = data;
+		windowLen = len;
+	}
+
+	void SetTocTable(const TocTable *table) {
+		tocTable = table;
 	}
 
 	bool LiftInstruction(const uint8_t *data, uint64_t addr);
+	bool LiftAtomic(const AtomicSequence &seq, uint64_t addr);
 };
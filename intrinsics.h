@@ -35,7 +35,9 @@
 
 #define FLAG_WRITE_CR0	1 << 0
 #define FLAG_WRITE_CA	1 << 1
-#define FLAG_WRITE__MAX	1 << 2
+// cr0.lt/gt/eq only, for the fast lifting level
+#define FLAG_WRITE_CR0_NOSO	1 << 2
+#define FLAG_WRITE__MAX	1 << 3
 
 enum class Intrinsic : uint32_t {
 	dcbt,
@@ -52,5 +54,15 @@ enum class Intrinsic : uint32_t {
 	tlbsync,
 	sync,
 	eieio,
+	stcx,
+	/* Fused reservation loops, see atomic.h */
+	atomic_add,
+	atomic_sub,
+	atomic_and,
+	atomic_andc,
+	atomic_or,
+	atomic_xor,
+	atomic_swap,
+	atomic_cas,
 	ENUM_LAST
 };
@@ -0,0 +1,297 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "memprof.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#define SITE_COUNT static_cast<size_t>(MemSite::ENUM_LAST)
+#define CACHE_COUNT static_cast<size_t>(MemCache::ENUM_LAST)
+
+std::atomic<bool> PpcMemProfile::enabled(false);
+
+/*
+ * Counters for one thread. Only the owning thread writes them, so updates
+ * are plain load/store pairs; readers may see a slightly stale total.
+ */
+struct MemSlot {
+	std::atomic<uint64_t> calls[SITE_COUNT];
+	std::atomic<uint64_t> allocations[SITE_COUNT];
+	std::atomic<uint64_t> bytes[SITE_COUNT];
+};
+
+static std::mutex slotsLock;
+static std::vector<std::shared_ptr<MemSlot>> slots;
+static std::string exitPath;
+
+// Read by operator new, so both are trivially constructed
+static thread_local MemSlot *threadSlot = nullptr;
+static thread_local MemSite currentSite = MemSite::None;
+
+static std::atomic<int64_t> held[CACHE_COUNT];
+static std::atomic<int64_t> peak[CACHE_COUNT];
+
+static void Bump(std::atomic<uint64_t> &counter, uint64_t n) {
+	counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+static MemSlot *ThreadSlot() {
+	thread_local std::shared_ptr<MemSlot> slot;
+	if (!slot) {
+		// Allocations made while registering are not counted: no site is
+		// current yet on this thread.
+		slot = std::make_shared<MemSlot>();
+		for (size_t i = 0; i < SITE_COUNT; i++) {
+			slot->calls[i].store(0, std::memory_order_relaxed);
+			slot->allocations[i].store(0, std::memory_order_relaxed);
+			slot->bytes[i].store(0, std::memory_order_relaxed);
+		}
+		std::lock_guard<std::mutex> guard(slotsLock);
+		slots.push_back(slot);
+		threadSlot = slot.get();
+	}
+	return slot.get();
+}
+
+static const char *SiteName(MemSite site) {
+	switch (site) {
+		case MemSite::InstructionInfo: return "GetInstructionInfo";
+		case MemSite::InstructionText: return "GetInstructionText";
+		case MemSite::InstructionLowLevelIL: return "GetInstructionLowLevelIL";
+		case MemSite::Names: return "names";
+		case MemSite::Lists: return "lists";
+		default: return "none";
+	}
+}
+
+static const char *CacheName(MemCache cache) {
+	switch (cache) {
+		case MemCache::DecodeRegions: return "decodeRegions";
+		case MemCache::DecodeIndexes: return "decodeIndexes";
+		case MemCache::TocTables: return "tocTables";
+		case MemCache::CallStubs: return "callStubs";
+		case MemCache::TraceRings: return "traceRings";
+		default: return "unknown";
+	}
+}
+
+struct MemTotals {
+	uint64_t calls[SITE_COUNT] = {};
+	uint64_t allocations[SITE_COUNT] = {};
+	uint64_t bytes[SITE_COUNT] = {};
+};
+
+static MemTotals Collect() {
+	MemTotals t;
+	std::lock_guard<std::mutex> guard(slotsLock);
+	for (auto &s : slots) {
+		for (size_t i = 0; i < SITE_COUNT; i++) {
+			t.calls[i] += s->calls[i].load(std::memory_order_relaxed);
+			t.allocations[i] += s->allocations[i].load(std::memory_order_relaxed);
+			t.bytes[i] += s->bytes[i].load(std::memory_order_relaxed);
+		}
+	}
+	return t;
+}
+
+static double PerMillion(uint64_t n, uint64_t calls) {
+	return calls ? n * 1e6 / calls : 0.0;
+}
+
+static void ExportAtExit() {
+	PpcMemProfile::enabled.store(false);
+	PpcMemProfile::ExportJson(exitPath);
+}
+
+void PpcMemProfile::Init() {
+	const char *path = getenv("BN_PPC64_MEMPROF");
+	if (path && *path) {
+		exitPath = path;
+		atexit(ExportAtExit);
+		enabled.store(true);
+	}
+}
+
+MemSite PpcMemProfile::Enter(MemSite site) {
+	MemSlot *slot = threadSlot ? threadSlot : ThreadSlot();
+	Bump(slot->calls[static_cast<size_t>(site)], 1);
+	MemSite previous = currentSite;
+	currentSite = site;
+	return previous;
+}
+
+void PpcMemProfile::Leave(MemSite previous) {
+	currentSite = previous;
+}
+
+void PpcMemProfile::CountAllocation(size_t size) {
+	MemSite site = currentSite;
+	if (site == MemSite::None || !threadSlot)
+		return;
+	Bump(threadSlot->allocations[static_cast<size_t>(site)], 1);
+	Bump(threadSlot->bytes[static_cast<size_t>(site)], size);
+}
+
+void PpcMemProfile::Hold(MemCache cache, int64_t delta) {
+	size_t i = static_cast<size_t>(cache);
+	int64_t now = held[i].fetch_add(delta, std::memory_order_relaxed) + delta;
+	int64_t top = peak[i].load(std::memory_order_relaxed);
+	while (now > top && !peak[i].compare_exchange_weak(top, now, std::memory_order_relaxed))
+		;
+}
+
+void PpcMemProfile::Reset() {
+	{
+		std::lock_guard<std::mutex> guard(slotsLock);
+		for (auto &s : slots) {
+			for (size_t i = 0; i < SITE_COUNT; i++) {
+				s->calls[i].store(0, std::memory_order_relaxed);
+				s->allocations[i].store(0, std::memory_order_relaxed);
+				s->bytes[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+	for (size_t i = 0; i < CACHE_COUNT; i++)
+		peak[i].store(held[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+std::string PpcMemProfile::Summary() {
+	MemTotals t = Collect();
+	std::string out;
+	char line[256];
+	snprintf(line, sizeof(line), "%-26s %12s %12s %14s %12s %14s\n",
+		"callback", "calls", "allocs", "bytes", "allocs/M", "bytes/M");
+	out += line;
+	for (size_t i = 1; i < SITE_COUNT; i++) {
+		snprintf(line, sizeof(line), "%-26s %12llu %12llu %14llu %12.0f %14.0f\n",
+			SiteName(static_cast<MemSite>(i)),
+			(unsigned long long)t.calls[i], (unsigned long long)t.allocations[i], (unsigned long long)t.bytes[i],
+			PerMillion(t.allocations[i], t.calls[i]), PerMillion(t.bytes[i], t.calls[i]));
+		out += line;
+	}
+	snprintf(line, sizeof(line), "%-26s %14s %14s\n", "cache", "bytes", "peak");
+	out += line;
+	for (size_t i = 0; i < CACHE_COUNT; i++) {
+		snprintf(line, sizeof(line), "%-26s %14lld %14lld\n", CacheName(static_cast<MemCache>(i)),
+			(long long)held[i].load(std::memory_order_relaxed), (long long)peak[i].load(std::memory_order_relaxed));
+		out += line;
+	}
+	return out;
+}
+
+bool PpcMemProfile::ExportJson(const std::string &path) {
+	FILE *f = fopen(path.c_str(), "w");
+	if (!f)
+		return false;
+
+	MemTotals t = Collect();
+	// Costs per million instructions, counting one info call per instruction
+	uint64_t insns = t.calls[static_cast<size_t>(MemSite::InstructionInfo)];
+	uint64_t allocations = 0, bytes = 0;
+	fputs("{\"callbacks\":{", f);
+	for (size_t i = 1; i < SITE_COUNT; i++) {
+		allocations += t.allocations[i];
+		bytes += t.bytes[i];
+		fprintf(f, "%s\n\"%s\":{\"calls\":%llu,\"allocations\":%llu,\"bytes\":%llu,"
+			"\"allocationsPerMillionCalls\":%.1f,\"bytesPerMillionCalls\":%.1f}",
+			i == 1 ? "" : ",", SiteName(static_cast<MemSite>(i)),
+			(unsigned long long)t.calls[i], (unsigned long long)t.allocations[i], (unsigned long long)t.bytes[i],
+			PerMillion(t.allocations[i], t.calls[i]), PerMillion(t.bytes[i], t.calls[i]));
+	}
+	fprintf(f, "\n},\n\"instructions\":%llu,\"allocationsPerMillionInstructions\":%.1f,\"bytesPerMillionInstructions\":%.1f,\n",
+		(unsigned long long)insns, PerMillion(allocations, insns), PerMillion(bytes, insns));
+	fputs("\"caches\":{", f);
+	for (size_t i = 0; i < CACHE_COUNT; i++) {
+		fprintf(f, "%s\n\"%s\":{\"bytes\":%lld,\"peakBytes\":%lld}", i == 0 ? "" : ",",
+			CacheName(static_cast<MemCache>(i)),
+			(long long)held[i].load(std::memory_order_relaxed), (long long)peak[i].load(std::memory_order_relaxed));
+	}
+	fputs("\n}}\n", f);
+	return fclose(f) == 0;
+}
+
+/*
+ * Replacement operator new. The plugin is linked with -Bsymbolic-functions
+ * where supported, so its own allocations bind here while the rest of the
+ * process keeps the standard library's. Memory still comes from malloc,
+ * so either side's delete can free it.
+ */
+static void *Allocate(size_t size) {
+	if (PpcMemProfile::enabled.load(std::memory_order_relaxed))
+		PpcMemProfile::CountAllocation(size);
+	if (size == 0)
+		size = 1;
+	for (;;) {
+		void *p = malloc(size);
+		if (p)
+			return p;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			return nullptr;
+		handler();
+	}
+}
+
+void *operator new(size_t size) {
+	void *p = Allocate(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) {
+	void *p = Allocate(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	try {
+		return Allocate(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	try {
+		return Allocate(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+	free(p);
+}
@@ -0,0 +1,102 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Optional allocation profiling of the architecture callbacks.
+ *
+ * The plugin replaces operator new. While profiling is on, allocations
+ * made inside a MemScope are counted against that scope's site in a
+ * per-thread slot. Only allocations made by plugin code are counted.
+ * Memory the core allocates, for example when it copies tokens or builds
+ * IL from our expressions, is not. When profiling is off, a scope costs
+ * one predictable branch, like TraceSpan.
+ *
+ * Plugin-side caches report the bytes they hold through Hold(). These
+ * gauges and their peaks are always kept, since they only change when a
+ * region or table entry is added.
+ *
+ * Profiling is enabled by the BN_PPC64_MEMPROF environment variable (its
+ * value is the path the JSON report is written to at exit) or by the
+ * "ppc64.memprof.enabled" setting.
+ */
+
+enum class MemSite : uint8_t {
+	None,
+	InstructionInfo,
+	InstructionText,
+	InstructionLowLevelIL,
+	Names,		// GetRegisterName, GetFlagName, GetIntrinsicName, ...
+	Lists,		// GetAllRegisters, GetAllFlags, ...
+	ENUM_LAST
+};
+
+enum class MemCache : uint8_t {
+	DecodeRegions,	// heap decode records
+	DecodeIndexes,	// mapped on-disk indexes
+	TocTables,
+	CallStubs,
+	TraceRings,
+	ENUM_LAST
+};
+
+class PpcMemProfile {
+public:
+	static std::atomic<bool> enabled;
+
+	static void Init();
+	// Counts a call to site and makes it current on this thread; returns
+	// the site that was current before.
+	static MemSite Enter(MemSite site);
+	static void Leave(MemSite previous);
+	static void CountAllocation(size_t size);
+	static void Hold(MemCache cache, int64_t delta);
+	static void Reset();
+
+	// Plain-text table for the log
+	static std::string Summary();
+	// Returns false if the file could not be written.
+	static bool ExportJson(const std::string &path);
+};
+
+// Approximate footprint of a node-based hash map
+template <typename M>
+static inline int64_t MemMapBytes(const M &m) {
+	return m.size() * (sizeof(typename M::value_type) + 2 * sizeof(void *)) + m.bucket_count() * sizeof(void *);
+}
+
+class MemScope {
+private:
+	MemSite previous;
+	bool active;
+public:
+	MemScope(MemSite site) {
+		active = PpcMemProfile::enabled.load(std::memory_order_relaxed);
+		if (active)
+			previous = PpcMemProfile::Enter(site);
+	}
+
+	~MemScope() {
+		if (active)
+			PpcMemProfile::Leave(previous);
+	}
+};
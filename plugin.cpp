@@ -17,6 +17,9 @@
 #include <binaryninjaapi.h>
 
 #include <ppc64_arch.h>
+#include "memprof.h"
+#include "trace.h"
+#include "view.h"
 
 extern "C"
 {
@@ -26,6 +29,81 @@ extern "C"
 	{
 		BinaryNinja::LogInfo("Better PowerPC plugin loaded!");
 
+		Ref<Settings> settings = Settings::Instance();
+		settings->RegisterGroup("ppc64", "PowerPC 64");
+		settings->RegisterSetting("ppc64.trace.enabled", R"({
+			"title" : "Trace architecture callbacks",
+			"type" : "boolean",
+			"default" : false,
+			"description" : "Record per-callback latency spans for GetInstructionInfo, GetInstructionText and GetInstructionLowLevelIL. Export them with the 'Export callback trace' command."
+		})");
+
+		settings->RegisterSetting("ppc64.memprof.enabled", R"({
+			"title" : "Profile plugin allocations",
+			"type" : "boolean",
+			"default" : false,
+			"description" : "Count allocations and bytes made by the plugin in each architecture callback. Show them with the 'Show memory profile' command or write them with 'Export memory profile'."
+		})");
+
+		settings->RegisterSetting("ppc64.strictDecode.enabled", R"({
+			"title" : "Strict decoding",
+			"type" : "boolean",
+			"default" : false,
+			"description" : "Reject instructions with reserved fields set or invalid forms (update loads and stores with RA=0, update loads with RA=RT, multiple and string loads that overwrite RA), so that data in code segments stops decoding early. Applies to every view and is read when Binary Ninja starts, so a change takes effect after a restart.",
+			"ignore" : ["SettingsProjectScope", "SettingsResourceScope"]
+		})");
+
+		PpcRegisterViewSettings();
+
+		PpcTrace::Init();
+		if (settings->Get<bool>("ppc64.trace.enabled"))
+			PpcTrace::enabled.store(true);
+		PpcMemProfile::Init();
+		if (settings->Get<bool>("ppc64.memprof.enabled"))
+			PpcMemProfile::enabled.store(true);
+		if (settings->Get<bool>("ppc64.strictDecode.enabled"))
+			PpcDecoder::strict.store(true);
+
+		PluginCommand::Register("PowerPC64\\Toggle callback tracing", "Start or stop recording architecture callback spans", [](BinaryView *view) {
+			bool on = !PpcTrace::enabled.load();
+			PpcTrace::enabled.store(on);
+			LogInfo("ppc64: callback tracing %s", on ? "enabled" : "disabled");
+		});
+		PluginCommand::Register("PowerPC64\\Export callback trace", "Write recorded callback spans as Chrome trace JSON", [](BinaryView *view) {
+			std::string path;
+			if (!GetSaveFileNameInput(path, "Trace output", "*.json", "ppc64-trace.json"))
+				return;
+			if (!PpcTrace::ExportChromeTrace(path))
+				LogError("ppc64: failed to write trace to %s", path.c_str());
+		});
+
+		PluginCommand::Register("PowerPC64\\Toggle memory profiling", "Start or stop counting plugin allocations per callback", [](BinaryView *view) {
+			bool on = !PpcMemProfile::enabled.load();
+			if (on)
+				PpcMemProfile::Reset();
+			PpcMemProfile::enabled.store(on);
+			LogInfo("ppc64: memory profiling %s", on ? "enabled" : "disabled");
+		});
+		PluginCommand::Register("PowerPC64\\Show memory profile", "Log plugin allocations per callback and the memory held by plugin caches", [](BinaryView *view) {
+			LogInfo("ppc64: memory profile\n%s", PpcMemProfile::Summary().c_str());
+		});
+		PluginCommand::Register("PowerPC64\\Export memory profile", "Write plugin allocation counts and cache sizes as JSON", [](BinaryView *view) {
+			std::string path;
+			if (!GetSaveFileNameInput(path, "Memory profile output", "*.json", "ppc64-memprof.json"))
+				return;
+			if (!PpcMemProfile::ExportJson(path))
+				LogError("ppc64: failed to write memory profile to %s", path.c_str());
+		});
+
+		PluginCommand::Register("PowerPC64\\Apply patch file", "Assemble and write a list of 'address: instructions' patches", PpcApplyPatchFile);
+		PluginCommand::Register("PowerPC64\\Export disassembly", "Write the disassembly of all executable segments as objdump-style text or JSONL", PpcExportDisassembly);
+		PluginCommand::Register("PowerPC64\\Export branch graph", "Write the direct branches and indirect branch sites of all executable segments as JSONL", PpcExportBranchGraph);
+		PluginCommand::Register("PowerPC64\\Export function hashes", "Write relocation-masked exact and MinHash signatures of all functions as JSONL", PpcExportFunctionHashes);
+		PluginCommand::Register("PowerPC64\\Mark data in code segments", "Define runs of executable segments that do not decode as plausible code as data", PpcMarkDataRegions);
+		PluginCommand::RegisterForAddress("PowerPC64\\Emulate from here", "Run the emulator from this address until the routine returns", PpcEmulateAt);
+
+		BinaryViewType::RegisterBinaryViewFinalizationEvent(PpcViewInit);
+
 		Ppc64Architecture* arch = new Ppc64Architecture("ppc64");
 		Architecture::Register(arch);
 		return true;
@@ -17,16 +17,23 @@
 #include <binaryninjaapi.h>
 #include <fmt/core.h>
 
+#include "assembler.h"
+#include "atomic.h"
+#include "decode_cache.h"
 #include "disasm.h"
 #include "il.h"
 #include "intrinsics.h"
+#include "memprof.h"
+#include "registers.h"
+#include "spr.h"
+#include "stubs.h"
+#include "toc.h"
+#include "trace.h"
+#include "vector.h"
+#include "viewstate.h"
 
 using namespace BinaryNinja;
 
-#define SEXT16(i) (((i)&0x8000) ? (0xffffffffffff0000 | (i)) : (i))
-#define SEXT26(i) (((i)&0x2000000) ? (0xfffffffffc000000 | (i)) : (i))
-#define SEXT32(i) (((i)&0x80000000) ? (0xffffffff00000000 | (i)) : (i))
-
 class Ppc64Architecture: public Architecture {
 public:
 	Ppc64Architecture(const std::string &name) : Architecture(name) {}
@@ -39,62 +46,209 @@ public:
 		return 8;
 	}
 
+	// Instructions are 4 bytes, but the lifter may consume a whole
+	// reservation loop at once.
 	virtual size_t GetMaxInstructionLength() const override {
-		return 4;
+		return 4 * ATOMIC_MAX_INSNS;
 	}
 
 	virtual bool GetInstructionInfo(const uint8_t *data, uint64_t addr, size_t maxLen, InstructionInfo &result) override {
+		TraceSpan span(TraceCallback::InstructionInfo, data, addr, maxLen);
+		MemScope scope(MemSite::InstructionInfo);
 		if (maxLen < 4)
 			return false;
 
+		// The lifter consumes a whole reservation loop, so the loop is one
+		// instruction here too. Only a CAS keeps an exit, the compare-failed
+		// branch; the retry edge is internal.
+		AtomicSequence seq;
+		if (PpcMatchAtomic(data, maxLen, addr, seq)) {
+			result.length = seq.count * 4;
+			uint64_t next = addr + result.length;
+			if (seq.op == AtomicOp::Cas && seq.fail != next) {
+				result.AddBranch(TrueBranch, next);
+				result.AddBranch(FalseBranch, seq.fail);
+			}
+			return true;
+		}
+
 		result.length = 4;
-		uint32_t inst = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
-		uint32_t op = inst >> 26;
-		uint64_t dst;
-		switch(op) {
-		case 16:
-			/* bc/bca/bcl/bcla */
-			if (inst & 0x2)
-				dst = SEXT16(inst & 0xfffc);
-			else
-				dst = addr + SEXT16(inst & 0xfffc);
-			if (inst & 0x1) {
-				result.AddBranch(CallDestination, dst);
-			} else {
+		uint32_t inst = ReadInstruction(data);
+		uint64_t rec = DecodeCache::Get(addr, inst);
+		uint32_t flags = RECORD_FLAGS(rec);
+		if (PpcDecoder::strict.load(std::memory_order_relaxed) && PpcDecoder::Rejected(rec))
+			return false;
+		if (flags & INSN_BRANCH) {
+			uint64_t dst = PpcDecoder::BranchTarget(inst, addr);
+			if (flags & INSN_CALL) {
+				// Local entries fold into their global entry (see toc.h), so
+				// no function is ever created at one
+				result.AddBranch(CallDestination, PpcViewState::FoldCall(addr, dst));
+			} else if (flags & INSN_CONDITIONAL) {
 				result.AddBranch(TrueBranch, dst);
 				result.AddBranch(FalseBranch, addr+4);
-			}
-			return true;
-		case 18:
-			/* b/ba/bl/bla */
-			if (inst & 0x2)
-				dst = SEXT26(inst & 0x3fffffc);
-			else
-				dst = addr + SEXT26(inst & 0x3fffffc);
-			if (inst & 0x1)
-				result.AddBranch(CallDestination, dst);
-			else
+			} else {
 				result.AddBranch(UnconditionalBranch, dst);
-			return true;
+			}
+		} else if (flags & INSN_TRAP) {
+			result.AddBranch(ExceptionBranch);
+		} else if (flags & (INSN_RETURN | INSN_INDIRECT)) {
+			result.AddBranch((flags & INSN_RETURN) ? FunctionReturn : UnresolvedBranch);
+			if (flags & INSN_CONDITIONAL)
+				result.AddBranch(FalseBranch, addr+4);
 		}
 		return true;
 	}
 
 	virtual bool GetInstructionText(const uint8_t *data, uint64_t addr, size_t &len, std::vector<InstructionTextToken> &result) override {
+		TraceSpan span(TraceCallback::InstructionText, data, addr, len);
+		MemScope scope(MemSite::InstructionText);
+		if (len < 4)
+			return false;
+		size_t maxLen = len;
 		len = 4;
+		// Words already known to be invalid are rejected without building tokens
+		uint64_t rec;
+		if (PpcDecoder::strict.load(std::memory_order_relaxed)) {
+			if (PpcDecoder::Rejected(DecodeCache::Get(addr, ReadInstruction(data))))
+				return false;
+		} else if (DecodeCache::Lookup(addr, ReadInstruction(data), rec) && !(RECORD_FLAGS(rec) & INSN_VALID)) {
+			return false;
+		}
+		// A fused reservation loop is shown on one line, word by word
+		AtomicSequence seq;
+		if (PpcMatchAtomic(data, maxLen, addr, seq)) {
+			for (size_t i = 0; i < seq.count; i++) {
+				std::vector<InstructionTextToken> part;
+				PpcDisassembler disasm(&part);
+				if (!disasm.DecodeInstruction(data + i * 4, addr + i * 4))
+					return false;
+				if (i)
+					result.emplace_back(TextToken, "; ");
+				result.insert(result.end(), part.begin(), part.end());
+			}
+			len = seq.count * 4;
+			return true;
+		}
 		PpcDisassembler disasm(&result);
 		return disasm.DecodeInstruction(data, addr);
 	}
 
 	virtual bool GetInstructionLowLevelIL(const uint8_t *data, uint64_t addr, size_t &len, LowLevelILFunction &il) override {
+		TraceSpan span(TraceCallback::InstructionLowLevelIL, data, addr, len);
+		MemScope scope(MemSite::InstructionLowLevelIL);
+		Ref<Function> func = il.GetFunction();
+		std::shared_ptr<PpcViewState> state = func ? PpcViewState::Lookup(func->GetView()->GetObject()) : nullptr;
+		PpcLifter lift(&il, this, state ? state->fidelity.load(std::memory_order_relaxed) : LiftFidelity::Precise);
+		AtomicSequence seq;
+		if (PpcMatchAtomic(data, len, addr, seq)) {
+			len = seq.count * 4;
+			return lift.LiftAtomic(seq, addr);
+		}
+		if (len < 4)
+			return false;
+		lift.SetWindow(data, len);
+		if (state)
+			lift.SetTocTable(&state->toc);
 		len = 4;
-		PpcLifter lift(&il, this);
+		uint64_t slot;
+		if (state && ReadInstruction(data) == 0x4e800420 && state->stubs.Lookup(addr, slot)) {
+			// bctr of a PLT call stub
+			il.AddInstruction(il.TailCall(il.Load(8, il.ConstPointer(8, slot))));
+			return true;
+		}
+		if (PpcDecoder::strict.load(std::memory_order_relaxed) && PpcDecoder::Rejected(DecodeCache::Get(addr, ReadInstruction(data))))
+			return false;
+		uint64_t toc;
+		if (state && state->toc.EntryToc(addr, toc)) {
+			// ELFv1 function entry: r2 holds the TOC from its descriptor
+			il.AddInstruction(il.SetRegister(8, 2, il.ConstPointer(8, toc)));
+		}
 		return lift.LiftInstruction(data, addr);
 	}
 
+	virtual bool Assemble(const std::string &code, uint64_t addr, DataBuffer &result, std::string &errors) override {
+		std::vector<uint8_t> out;
+		if (!PpcAssembler::Assemble(code, addr, out, errors))
+			return false;
+		result.Append(out.data(), out.size());
+		return true;
+	}
+
+	virtual bool IsNeverBranchPatchAvailable(const uint8_t *data, uint64_t addr, size_t len) override {
+		return len >= 4 && PpcAssembler::IsConditionalBranch(ReadInstruction(data));
+	}
+
+	virtual bool IsAlwaysBranchPatchAvailable(const uint8_t *data, uint64_t addr, size_t len) override {
+		return len >= 4 && PpcAssembler::IsConditionalBranch(ReadInstruction(data));
+	}
+
+	virtual bool IsInvertBranchPatchAvailable(const uint8_t *data, uint64_t addr, size_t len) override {
+		return len >= 4 && PpcAssembler::CanInvert(ReadInstruction(data));
+	}
+
+	virtual bool IsSkipAndReturnZeroPatchAvailable(const uint8_t *data, uint64_t addr, size_t len) override {
+		return len >= 4 && PpcAssembler::IsCall(ReadInstruction(data));
+	}
+
+	// The value is not known yet. A call is one word, so SkipAndReturnValue
+	// rejects values that no single li or lis loads.
+	virtual bool IsSkipAndReturnValuePatchAvailable(const uint8_t *data, uint64_t addr, size_t len) override {
+		return len >= 4 && PpcAssembler::IsCall(ReadInstruction(data));
+	}
+
+	virtual bool ConvertToNop(uint8_t *data, uint64_t addr, size_t len) override {
+		if (len % 4)
+			return false;
+		for (size_t i = 0; i < len; i += 4)
+			WriteInstruction(data + i, 0x60000000);	// ori r0, r0, 0
+		return true;
+	}
+
+	virtual bool AlwaysBranch(uint8_t *data, uint64_t addr, size_t len) override {
+		if (len < 4 || !PpcAssembler::IsConditionalBranch(ReadInstruction(data)))
+			return false;
+		WriteInstruction(data, PpcAssembler::MakeAlways(ReadInstruction(data)));
+		return true;
+	}
+
+	virtual bool InvertBranch(uint8_t *data, uint64_t addr, size_t len) override {
+		if (len < 4 || !PpcAssembler::CanInvert(ReadInstruction(data)))
+			return false;
+		WriteInstruction(data, PpcAssembler::Invert(ReadInstruction(data)));
+		return true;
+	}
+
+	virtual bool SkipAndReturnValue(uint8_t *data, uint64_t addr, size_t len, uint64_t value) override {
+		// li r3 or lis r3 in place of the call
+		uint32_t inst;
+		if (len < 4 || !PpcAssembler::LoadImmediate(3, value, inst)) {
+			LogError("ppc64: 0x%llx does not fit a single li or lis in place of the call", (unsigned long long)value);
+			return false;
+		}
+		WriteInstruction(data, inst);
+		return true;
+	}
+
 	virtual std::string GetRegisterName(uint32_t reg) override {
-		if (reg == 32) {
+		MemScope scope(MemSite::Names);
+		if (reg == PPC_REG_CTR) {
 			return "ctr";
+		} else if (reg == PPC_REG_LR) {
+			return "lr";
+		} else if (reg == PPC_REG_FPSCR) {
+			return "fpscr";
+		} else if (reg == PPC_REG_VSCR) {
+			return "vscr";
+		} else if (PPC_REG_IS_FPR(reg)) {
+			return fmt::format("f{}", reg - PPC_REG_FPR(0));
+		} else if (PPC_REG_IS_VSR(reg)) {
+			return fmt::format("vs{}", reg - PPC_REG_VSR(0));
+		} else if (PPC_REG_IS_VR(reg)) {
+			return fmt::format("v{}", reg - PPC_REG_VR(0));
+		} else if (PPC_REG_IS_SPR(reg)) {
+			const PpcSpr &spr = PpcSprInfo(reg - PPC_REG_SPR(0));
+			return spr.name ? spr.name : fmt::format("spr{}", reg - PPC_REG_SPR(0));
 		} else {
 			char buf[16];
 			snprintf(buf, sizeof(buf), "r%d", reg);
@@ -103,31 +257,63 @@ public:
 		}
 	}
 
+	virtual uint32_t GetLinkRegister() override {
+		return PPC_REG_LR;
+	}
+
 	virtual BNRegisterInfo GetRegisterInfo(uint32_t reg) override {
 		BNRegisterInfo i = {0};
 		i.fullWidthRegister = reg;
 		i.size = 8;
 		i.extend = NoExtend;
+		if (PPC_REG_IS_FPR(reg)) {
+			// Doubleword 0 (the high half) of the matching VSR
+			i.fullWidthRegister = PPC_REG_VSR(reg - PPC_REG_FPR(0));
+			i.offset = 8;
+		} else if (PPC_REG_IS_VR(reg)) {
+			i.fullWidthRegister = PPC_REG_VSR(32 + reg - PPC_REG_VR(0));
+			i.size = 16;
+		} else if (PPC_REG_IS_VSR(reg)) {
+			i.size = 16;
+		} else if (reg == PPC_REG_FPSCR || reg == PPC_REG_VSCR) {
+			i.size = 4;
+		}
 		return i;
 	}
 
 	virtual std::vector<uint32_t> GetAllRegisters() override {
-		std::vector<uint32_t> v(33);
-		for (int i = 0; i < 33; i++) {
-			v[i] = i;
+		MemScope scope(MemSite::Lists);
+		std::vector<uint32_t> v = GetFullWidthRegisters();
+		for (int i = 0; i < 32; i++) {
+			v.push_back(PPC_REG_FPR(i));
+			v.push_back(PPC_REG_VR(i));
 		}
 		return v;
 	}
 
 	virtual std::vector<uint32_t> GetFullWidthRegisters() override {
-		std::vector<uint32_t> v(33);
-		for (int i = 0; i < 33; i++) {
-			v[i] = i;
+		MemScope scope(MemSite::Lists);
+		std::vector<uint32_t> v;
+		for (int i = 0; i < 32; i++) {
+			v.push_back(PPC_REG_GPR(i));
+		}
+		v.push_back(PPC_REG_CTR);
+		v.push_back(PPC_REG_LR);
+		v.push_back(PPC_REG_FPSCR);
+		for (int i = 0; i < 64; i++) {
+			v.push_back(PPC_REG_VSR(i));
 		}
+		v.push_back(PPC_REG_VSCR);
+		uint32_t count;
+		const uint32_t *sprs = PpcSprRegisters(count);
+		v.insert(v.end(), sprs, sprs + count);
 		return v;
 	}
 
 	virtual std::string GetIntrinsicName(uint32_t i) override {
+		MemScope scope(MemSite::Names);
+		if (i >= VEC_INTRINSIC_BASE && i - VEC_INTRINSIC_BASE < VecOpcodeCount())
+			return VecOpcodeAt(i - VEC_INTRINSIC_BASE).name;
 		Intrinsic in = static_cast<Intrinsic>(i);
 		switch (in) {
 			case Intrinsic::dcbt: return "dcbt";
@@ -144,20 +330,92 @@ public:
 			case Intrinsic::tlbsync: return "tlbsync";
 			case Intrinsic::sync: return "sync";
 			case Intrinsic::eieio: return "eieio";
+			case Intrinsic::stcx: return "stcx";
+			case Intrinsic::atomic_add: return "atomic_add";
+			case Intrinsic::atomic_sub: return "atomic_sub";
+			case Intrinsic::atomic_and: return "atomic_and";
+			case Intrinsic::atomic_andc: return "atomic_andc";
+			case Intrinsic::atomic_or: return "atomic_or";
+			case Intrinsic::atomic_xor: return "atomic_xor";
+			case Intrinsic::atomic_swap: return "atomic_swap";
+			case Intrinsic::atomic_cas: return "atomic_cas";
 			default: return "";
 		}
 	}
 
 	virtual std::vector<uint32_t> GetAllIntrinsics() override {
+		MemScope scope(MemSite::Lists);
 		uint32_t max = static_cast<uint32_t>(Intrinsic::ENUM_LAST);
 		std::vector<uint32_t> v(max);
 		for (int i = 0; i < max; i++) {
 			v[i] = i;
 		}
+		for (size_t i = 0; i < VecOpcodeCount(); i++) {
+			v.push_back(VEC_INTRINSIC_BASE + i);
+		}
+		return v;
+	}
+
+	virtual std::vector<NameAndType> GetIntrinsicInputs(uint32_t i) override {
+		MemScope scope(MemSite::Lists);
+		std::vector<NameAndType> v;
+		Intrinsic in = static_cast<Intrinsic>(i);
+		if (in == Intrinsic::stcx || (in >= Intrinsic::atomic_add && in <= Intrinsic::atomic_cas)) {
+			v.emplace_back("address", Type::PointerType(8, Type::IntegerType(8, false)));
+			if (in == Intrinsic::atomic_cas)
+				v.emplace_back("expected", Type::IntegerType(8, false));
+			v.emplace_back("value", Type::IntegerType(8, false));
+			return v;
+		}
+		if (i < VEC_INTRINSIC_BASE || i - VEC_INTRINSIC_BASE >= VecOpcodeCount())
+			return v;
+		// Operand kinds depend only on the form, so a zero word describes them
+		const VecOpcode &op = VecOpcodeAt(i - VEC_INTRINSIC_BASE);
+		VecOperand ops[VEC_MAX_OPERANDS];
+		size_t n = VecDecodeOperands(op, 0, ops);
+		if (op.flags & VEC_TARGET_IN)
+			v.emplace_back(Type::IntegerType(16, false));
+		for (size_t j = 0; j < n; j++) {
+			if (!ops[j].dest)
+				v.emplace_back(Type::IntegerType(VecOperandSize(ops[j].kind), false));
+		}
+		return v;
+	}
+
+	virtual std::vector<Confidence<Ref<Type>>> GetIntrinsicOutputs(uint32_t i) override {
+		MemScope scope(MemSite::Lists);
+		std::vector<Confidence<Ref<Type>>> v;
+		Intrinsic in = static_cast<Intrinsic>(i);
+		if (in == Intrinsic::stcx) {
+			v.push_back(Type::BoolType());
+			return v;
+		}
+		if (in >= Intrinsic::atomic_add && in <= Intrinsic::atomic_cas) {
+			// The previous memory value
+			v.push_back(Type::IntegerType(8, false));
+			return v;
+		}
+		if (i < VEC_INTRINSIC_BASE || i - VEC_INTRINSIC_BASE >= VecOpcodeCount())
+			return v;
+		const VecOpcode &op = VecOpcodeAt(i - VEC_INTRINSIC_BASE);
+		VecOperand ops[VEC_MAX_OPERANDS];
+		size_t n = VecDecodeOperands(op, 0, ops);
+		for (size_t j = 0; j < n; j++) {
+			if (!ops[j].dest)
+				continue;
+			size_t count = ops[j].kind == VecOperandKind::CRF ? 4 : 1;
+			for (size_t k = 0; k < count; k++)
+				v.push_back(Type::IntegerType(VecOperandSize(ops[j].kind), false));
+		}
+		if (op.form == VEC_VC_RC || op.form == VEC_XX3_RC) {
+			for (size_t k = 0; k < 4; k++)
+				v.push_back(Type::IntegerType(1, false));
+		}
 		return v;
 	}
 
 	virtual std::vector<uint32_t> GetAllFlags() override {
+		MemScope scope(MemSite::Lists);
 		std::vector<uint32_t> v(FLAG__LAST);
 		for (int i = 0; i < FLAG__LAST; i++) {
 			v[i] = i;
@@ -166,6 +424,7 @@ public:
 	}
 
 	virtual std::vector<uint32_t> GetAllFlagWriteTypes() override {
+		MemScope scope(MemSite::Lists);
 		std::vector<uint32_t> v(FLAG_WRITE__MAX);
 		for (int i = 0; i < FLAG_WRITE__MAX; i++) {
 			v[i] = i;
@@ -188,6 +447,7 @@ public:
 	}
 
 	virtual std::string GetFlagName(uint32_t flag) override {
+		MemScope scope(MemSite::Names);
 		char buf[16];
 		switch (flag) {
 			case FLAG_CR0_LT: return "cr0.lt";
@@ -212,10 +472,15 @@ public:
 	}
 
 	virtual std::string GetFlagWriteTypeName(uint32_t flag) override {
+		MemScope scope(MemSite::Names);
 		std::string str;
 		if (flag & FLAG_WRITE_CR0) {
 			str.append("cr0");
 		}
+		if (flag & FLAG_WRITE_CR0_NOSO) {
+			if (str.size()) str.append(".");
+			str.append("cr0_noso");
+		}
 		if (flag & FLAG_WRITE_CA) {
 			if (str.size()) str.append(".");
 			str.append("ca");
@@ -224,9 +489,12 @@ public:
 	}
 
 	virtual std::vector<uint32_t> GetFlagsWrittenByFlagWriteType(uint32_t flag) override {
+		MemScope scope(MemSite::Lists);
 		std::vector<uint32_t> vec;
 		if (flag & FLAG_WRITE_CR0) {
 			vec.insert(vec.end(), {FLAG_CR0_LT, FLAG_CR0_GT, FLAG_CR0_EQ, FLAG_CR0_SO});
+		} else if (flag & FLAG_WRITE_CR0_NOSO) {
+			vec.insert(vec.end(), {FLAG_CR0_LT, FLAG_CR0_GT, FLAG_CR0_EQ});
 		}
 		if (flag & FLAG_WRITE_CA) {
 			vec.insert(vec.end(), {FLAG_XER_CA});
@@ -0,0 +1,43 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ * Register IDs as exposed to Binary Ninja. Each register file starts at its
+ * own base so later additions don't renumber existing registers.
+ */
+
+#define PPC_REG_GPR(n)	(n)
+#define PPC_REG_CTR	32
+#define PPC_REG_LR	33
+
+#define PPC_REG_FPR(n)	(64 + (n))
+#define PPC_REG_FPSCR	96
+
+// VSR n holds FPR n in doubleword 0; VR n is VSR 32+n.
+#define PPC_REG_VSR(n)	(128 + (n))
+#define PPC_REG_VR(n)	(192 + (n))
+#define PPC_REG_VSCR	224
+
+// SPR n other than lr/ctr, see spr.h
+#define PPC_REG_SPR(n)	(256 + (n))
+
+#define PPC_REG_IS_GPR(r)	((r) < 32)
+#define PPC_REG_IS_FPR(r)	((r) >= 64 && (r) < 96)
+#define PPC_REG_IS_VSR(r)	((r) >= 128 && (r) < 192)
+#define PPC_REG_IS_VR(r)	((r) >= 192 && (r) < 224)
+#define PPC_REG_IS_SPR(r)	((r) >= 256 && (r) < 256 + 1024)
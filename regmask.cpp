@@ -0,0 +1,615 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "regmask.h"
+#include "decoder.h"
+#include "vector.h"
+
+#include "decode_macros.h"
+
+enum RegShape : uint8_t {
+	SHAPE_NONE,		// reads and writes no tracked register
+	SHAPE_D_LOAD,		// rt = f(ra|0)
+	SHAPE_D_LOAD_U,		// rt = f(ra); ra updated
+	SHAPE_D_STORE,		// f(rs, ra|0)
+	SHAPE_D_STORE_U,	// f(rs, ra); ra updated
+	SHAPE_D_FP,		// FPR load/store: reads ra|0
+	SHAPE_D_FP_U,		// reads and updates ra
+	SHAPE_D_ARITH,		// rt = f(ra)
+	SHAPE_D_ARITH_RA0,	// rt = f(ra|0): addi, addis
+	SHAPE_D_LOGICAL,	// ra = f(rs)
+	SHAPE_D_CMP,		// cr[bf] = f(ra)
+	SHAPE_D_TRAP,		// f(ra)
+	SHAPE_LMW,		// rt..r31 = f(ra|0)
+	SHAPE_STMW,		// f(rs..r31, ra|0)
+	SHAPE_LSWI,		// rt.. (nb bytes, wrapping) = f(ra|0)
+	SHAPE_STSWI,		// f(rs.., ra|0)
+	SHAPE_X_LOAD,		// rt = f(ra|0, rb)
+	SHAPE_X_LOAD_U,		// rt = f(ra, rb); ra updated
+	SHAPE_X_STORE,		// f(rs, ra|0, rb)
+	SHAPE_X_STORE_U,	// f(rs, ra, rb); ra updated
+	SHAPE_X_ADDR,		// f(ra|0, rb): FPR loads/stores, cache ops
+	SHAPE_X_ADDR_U,		// f(ra, rb); ra updated
+	SHAPE_X_RB,		// f(rb)
+	SHAPE_X_RS_RB,		// f(rs, rb)
+	SHAPE_XO_ARITH,		// rt = f(ra, rb)
+	SHAPE_XO_ARITH1,	// rt = f(ra)
+	SHAPE_X_LOGICAL,	// ra = f(rs, rb)
+	SHAPE_X_LOGICAL1,	// ra = f(rs)
+	SHAPE_X_CMP,		// cr[bf] = f(ra, rb)
+	SHAPE_X_TRAP,		// f(ra, rb)
+	SHAPE_MFCR,		// rt = cr
+	SHAPE_MTCRF,		// cr[fxm] = rs
+	SHAPE_MFSPR,
+	SHAPE_MTSPR,
+	SHAPE_MFTB,		// rt = tb
+	SHAPE_BC,
+	SHAPE_B,
+	SHAPE_SC,
+};
+
+#define SPEC_RC		0x01	/* bit 0 is Rc: writes cr0 */
+#define SPEC_OE		0x02	/* XO form: the xo|0x200 encoding sets OV */
+#define SPEC_CA_DEF	0x04	/* writes XER.CA */
+#define SPEC_CA_USE	0x08	/* reads XER.CA */
+#define SPEC_CR0	0x10	/* always writes cr0 (andi., stcx., ...) */
+#define SPEC_READS_RA	0x20	/* ra is also a source (rlwimi, rldimi) */
+
+struct RegSpec {
+	uint8_t primary;
+	uint16_t xo;
+	RegShape shape;
+	uint8_t flags;
+};
+
+static constexpr RegSpec specs[] = {
+	{2, 0, SHAPE_D_TRAP, 0},		// tdi
+	{3, 0, SHAPE_D_TRAP, 0},		// twi
+	{7, 0, SHAPE_D_ARITH, 0},		// mulli
+	{8, 0, SHAPE_D_ARITH, SPEC_CA_DEF},	// subfic
+	{10, 0, SHAPE_D_CMP, 0},		// cmpli
+	{11, 0, SHAPE_D_CMP, 0},		// cmpi
+	{12, 0, SHAPE_D_ARITH, SPEC_CA_DEF},	// addic
+	{13, 0, SHAPE_D_ARITH, SPEC_CA_DEF | SPEC_CR0},	// addic.
+	{14, 0, SHAPE_D_ARITH_RA0, 0},		// addi
+	{15, 0, SHAPE_D_ARITH_RA0, 0},		// addis
+	{16, 0, SHAPE_BC, 0},			// bc
+	{17, 0, SHAPE_SC, 0},			// sc
+	{18, 0, SHAPE_B, 0},			// b
+	{20, 0, SHAPE_X_LOGICAL1, SPEC_RC | SPEC_READS_RA},	// rlwimi
+	{21, 0, SHAPE_X_LOGICAL1, SPEC_RC},	// rlwinm
+	{23, 0, SHAPE_X_LOGICAL, SPEC_RC},	// rlwnm
+	{24, 0, SHAPE_D_LOGICAL, 0},		// ori
+	{25, 0, SHAPE_D_LOGICAL, 0},		// oris
+	{26, 0, SHAPE_D_LOGICAL, 0},		// xori
+	{27, 0, SHAPE_D_LOGICAL, 0},		// xoris
+	{28, 0, SHAPE_D_LOGICAL, SPEC_CR0},	// andi.
+	{29, 0, SHAPE_D_LOGICAL, SPEC_CR0},	// andis.
+	{32, 0, SHAPE_D_LOAD, 0},		// lwz
+	{33, 0, SHAPE_D_LOAD_U, 0},		// lwzu
+	{34, 0, SHAPE_D_LOAD, 0},		// lbz
+	{35, 0, SHAPE_D_LOAD_U, 0},		// lbzu
+	{36, 0, SHAPE_D_STORE, 0},		// stw
+	{37, 0, SHAPE_D_STORE_U, 0},		// stwu
+	{38, 0, SHAPE_D_STORE, 0},		// stb
+	{39, 0, SHAPE_D_STORE_U, 0},		// stbu
+	{40, 0, SHAPE_D_LOAD, 0},		// lhz
+	{41, 0, SHAPE_D_LOAD_U, 0},		// lhzu
+	{42, 0, SHAPE_D_LOAD, 0},		// lha
+	{43, 0, SHAPE_D_LOAD_U, 0},		// lhau
+	{44, 0, SHAPE_D_STORE, 0},		// sth
+	{45, 0, SHAPE_D_STORE_U, 0},		// sthu
+	{46, 0, SHAPE_LMW, 0},			// lmw
+	{47, 0, SHAPE_STMW, 0},			// stmw
+	{48, 0, SHAPE_D_FP, 0},			// lfs
+	{49, 0, SHAPE_D_FP_U, 0},		// lfsu
+	{50, 0, SHAPE_D_FP, 0},			// lfd
+	{51, 0, SHAPE_D_FP_U, 0},		// lfdu
+	{52, 0, SHAPE_D_FP, 0},			// stfs
+	{53, 0, SHAPE_D_FP_U, 0},		// stfsu
+	{54, 0, SHAPE_D_FP, 0},			// stfd
+	{55, 0, SHAPE_D_FP_U, 0},		// stfdu
+
+	/* Group 31 */
+	{31, 0, SHAPE_X_CMP, 0},		// cmp
+	{31, 32, SHAPE_X_CMP, 0},		// cmpl
+	{31, 4, SHAPE_X_TRAP, 0},		// tw
+	{31, 68, SHAPE_X_TRAP, 0},		// td
+	{31, 8, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE | SPEC_CA_DEF},	// subfc
+	{31, 10, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE | SPEC_CA_DEF},	// addc
+	{31, 136, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE | SPEC_CA_DEF | SPEC_CA_USE},	// subfe
+	{31, 138, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE | SPEC_CA_DEF | SPEC_CA_USE},	// adde
+	{31, 200, SHAPE_XO_ARITH1, SPEC_RC | SPEC_OE | SPEC_CA_DEF | SPEC_CA_USE},	// subfze
+	{31, 202, SHAPE_XO_ARITH1, SPEC_RC | SPEC_OE | SPEC_CA_DEF | SPEC_CA_USE},	// addze
+	{31, 232, SHAPE_XO_ARITH1, SPEC_RC | SPEC_OE | SPEC_CA_DEF | SPEC_CA_USE},	// subfme
+	{31, 234, SHAPE_XO_ARITH1, SPEC_RC | SPEC_OE | SPEC_CA_DEF | SPEC_CA_USE},	// addme
+	{31, 40, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE},	// subf
+	{31, 266, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE},	// add
+	{31, 104, SHAPE_XO_ARITH1, SPEC_RC | SPEC_OE},	// neg
+	{31, 9, SHAPE_XO_ARITH, SPEC_RC},	// mulhdu
+	{31, 11, SHAPE_XO_ARITH, SPEC_RC},	// mulhwu
+	{31, 73, SHAPE_XO_ARITH, SPEC_RC},	// mulhd
+	{31, 75, SHAPE_XO_ARITH, SPEC_RC},	// mulhw
+	{31, 233, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE},	// mulld
+	{31, 235, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE},	// mullw
+	{31, 457, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE},	// divdu
+	{31, 459, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE},	// divwu
+	{31, 489, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE},	// divd
+	{31, 491, SHAPE_XO_ARITH, SPEC_RC | SPEC_OE},	// divw
+	{31, 19, SHAPE_MFCR, 0},		// mfcr
+	{31, 144, SHAPE_MTCRF, 0},		// mtcrf
+	{31, 20, SHAPE_X_LOAD, 0},		// lwarx
+	{31, 52, SHAPE_X_LOAD, 0},		// lbarx
+	{31, 84, SHAPE_X_LOAD, 0},		// ldarx
+	{31, 116, SHAPE_X_LOAD, 0},		// lharx
+	{31, 150, SHAPE_X_STORE, SPEC_CR0},	// stwcx.
+	{31, 214, SHAPE_X_STORE, SPEC_CR0},	// stdcx.
+	{31, 694, SHAPE_X_STORE, SPEC_CR0},	// stbcx.
+	{31, 726, SHAPE_X_STORE, SPEC_CR0},	// sthcx.
+	{31, 21, SHAPE_X_LOAD, 0},		// ldx
+	{31, 23, SHAPE_X_LOAD, 0},		// lwzx
+	{31, 87, SHAPE_X_LOAD, 0},		// lbzx
+	{31, 279, SHAPE_X_LOAD, 0},		// lhzx
+	{31, 343, SHAPE_X_LOAD, 0},		// lhax
+	{31, 341, SHAPE_X_LOAD, 0},		// lwax
+	{31, 532, SHAPE_X_LOAD, 0},		// ldbrx
+	{31, 534, SHAPE_X_LOAD, 0},		// lwbrx
+	{31, 790, SHAPE_X_LOAD, 0},		// lhbrx
+	{31, 53, SHAPE_X_LOAD_U, 0},		// ldux
+	{31, 55, SHAPE_X_LOAD_U, 0},		// lwzux
+	{31, 119, SHAPE_X_LOAD_U, 0},		// lbzux
+	{31, 311, SHAPE_X_LOAD_U, 0},		// lhzux
+	{31, 375, SHAPE_X_LOAD_U, 0},		// lhaux
+	{31, 373, SHAPE_X_LOAD_U, 0},		// lwaux
+	{31, 149, SHAPE_X_STORE, 0},		// stdx
+	{31, 151, SHAPE_X_STORE, 0},		// stwx
+	{31, 215, SHAPE_X_STORE, 0},		// stbx
+	{31, 407, SHAPE_X_STORE, 0},		// sthx
+	{31, 660, SHAPE_X_STORE, 0},		// stdbrx
+	{31, 662, SHAPE_X_STORE, 0},		// stwbrx
+	{31, 918, SHAPE_X_STORE, 0},		// sthbrx
+	{31, 181, SHAPE_X_STORE_U, 0},		// stdux
+	{31, 183, SHAPE_X_STORE_U, 0},		// stwux
+	{31, 247, SHAPE_X_STORE_U, 0},		// stbux
+	{31, 439, SHAPE_X_STORE_U, 0},		// sthux
+	{31, 24, SHAPE_X_LOGICAL, SPEC_RC},	// slw
+	{31, 27, SHAPE_X_LOGICAL, SPEC_RC},	// sld
+	{31, 536, SHAPE_X_LOGICAL, SPEC_RC},	// srw
+	{31, 539, SHAPE_X_LOGICAL, SPEC_RC},	// srd
+	{31, 792, SHAPE_X_LOGICAL, SPEC_RC | SPEC_CA_DEF},	// sraw
+	{31, 794, SHAPE_X_LOGICAL, SPEC_RC | SPEC_CA_DEF},	// srad
+	{31, 28, SHAPE_X_LOGICAL, SPEC_RC},	// and
+	{31, 60, SHAPE_X_LOGICAL, SPEC_RC},	// andc
+	{31, 124, SHAPE_X_LOGICAL, SPEC_RC},	// nor
+	{31, 284, SHAPE_X_LOGICAL, SPEC_RC},	// eqv
+	{31, 316, SHAPE_X_LOGICAL, SPEC_RC},	// xor
+	{31, 412, SHAPE_X_LOGICAL, SPEC_RC},	// orc
+	{31, 444, SHAPE_X_LOGICAL, SPEC_RC},	// or
+	{31, 476, SHAPE_X_LOGICAL, SPEC_RC},	// nand
+	{31, 824, SHAPE_X_LOGICAL1, SPEC_RC | SPEC_CA_DEF},	// srawi
+	{31, 826, SHAPE_X_LOGICAL1, SPEC_RC | SPEC_CA_DEF},	// sradi
+	{31, 827, SHAPE_X_LOGICAL1, SPEC_RC | SPEC_CA_DEF},	// sradi (sh5 set)
+	{31, 26, SHAPE_X_LOGICAL1, SPEC_RC},	// cntlzw
+	{31, 58, SHAPE_X_LOGICAL1, SPEC_RC},	// cntlzd
+	{31, 538, SHAPE_X_LOGICAL1, SPEC_RC},	// cnttzw
+	{31, 570, SHAPE_X_LOGICAL1, SPEC_RC},	// cnttzd
+	{31, 122, SHAPE_X_LOGICAL1, 0},		// popcntb
+	{31, 378, SHAPE_X_LOGICAL1, 0},		// popcntw
+	{31, 506, SHAPE_X_LOGICAL1, 0},		// popcntd
+	{31, 922, SHAPE_X_LOGICAL1, SPEC_RC},	// extsh
+	{31, 954, SHAPE_X_LOGICAL1, SPEC_RC},	// extsb
+	{31, 986, SHAPE_X_LOGICAL1, SPEC_RC},	// extsw
+	{31, 339, SHAPE_MFSPR, 0},		// mfspr
+	{31, 467, SHAPE_MTSPR, 0},		// mtspr
+	{31, 371, SHAPE_MFTB, 0},		// mftb
+	{31, 535, SHAPE_X_ADDR, 0},		// lfsx
+	{31, 599, SHAPE_X_ADDR, 0},		// lfdx
+	{31, 855, SHAPE_X_ADDR, 0},		// lfiwax
+	{31, 887, SHAPE_X_ADDR, 0},		// lfiwzx
+	{31, 663, SHAPE_X_ADDR, 0},		// stfsx
+	{31, 727, SHAPE_X_ADDR, 0},		// stfdx
+	{31, 983, SHAPE_X_ADDR, 0},		// stfiwx
+	{31, 567, SHAPE_X_ADDR_U, 0},		// lfsux
+	{31, 631, SHAPE_X_ADDR_U, 0},		// lfdux
+	{31, 695, SHAPE_X_ADDR_U, 0},		// stfsux
+	{31, 759, SHAPE_X_ADDR_U, 0},		// stfdux
+	{31, 54, SHAPE_X_ADDR, 0},		// dcbst
+	{31, 86, SHAPE_X_ADDR, 0},		// dcbf
+	{31, 246, SHAPE_X_ADDR, 0},		// dcbtst
+	{31, 278, SHAPE_X_ADDR, 0},		// dcbt
+	{31, 982, SHAPE_X_ADDR, 0},		// icbi
+	{31, 1014, SHAPE_X_ADDR, 0},		// dcbz
+	{31, 274, SHAPE_X_RS_RB, 0},		// tlbiel
+	{31, 306, SHAPE_X_RS_RB, 0},		// tlbie
+	{31, 402, SHAPE_X_RS_RB, 0},		// slbmte
+	{31, 434, SHAPE_X_RB, 0},		// slbie
+	{31, 370, SHAPE_NONE, 0},		// tlbia
+	{31, 566, SHAPE_NONE, 0},		// tlbsync
+	{31, 597, SHAPE_LSWI, 0},		// lswi
+	{31, 598, SHAPE_NONE, 0},		// sync
+	{31, 725, SHAPE_STSWI, 0},		// stswi
+	{31, 854, SHAPE_NONE, 0},		// eieio
+};
+
+// Each slot holds a spec index + 1; zero means no entry.
+struct RegTables {
+	uint8_t primary[64];
+	uint8_t x31[1024];
+};
+
+static constexpr RegTables BuildTables() {
+	RegTables t = {};
+	for (size_t i = 0; i < sizeof(specs) / sizeof(specs[0]); i++) {
+		const RegSpec &s = specs[i];
+		if (s.primary != 31) {
+			t.primary[s.primary] = i + 1;
+			continue;
+		}
+		t.x31[s.xo] = i + 1;
+		if (s.flags & SPEC_OE)
+			t.x31[s.xo | 0x200] = i + 1;
+	}
+	return t;
+}
+
+static constexpr RegTables tables = BuildTables();
+static_assert(sizeof(specs) / sizeof(specs[0]) < 255, "spec index must fit the tables");
+
+static inline uint64_t Gpr0(uint32_t r) {
+	// ra = 0 means the literal 0 in address and addi forms
+	return r ? REGMASK_GPR(r) : 0;
+}
+
+// Registers filled by an nb-byte string move from rt, wrapping past r31
+static inline uint64_t StringRegs(uint32_t rt, uint32_t nb) {
+	uint64_t m = 0;
+	for (uint32_t k = 0; k < (nb + 3) / 4; k++)
+		m |= REGMASK_GPR((rt + k) & 31);
+	return m;
+}
+
+static inline uint64_t CrField(uint32_t bi) {
+	return REGMASK_CR(bi / 4);
+}
+
+// BO/BI condition of bc/bclr/bcctr
+static void BranchUses(uint32_t inst, PpcRegUsage &u) {
+	uint32_t bo = BFORM_BO(inst);
+	if (!(bo & 0b00100)) {
+		u.uses |= REGMASK_CTR;
+		u.defs |= REGMASK_CTR;
+	}
+	if (!(bo & 0b10000))
+		u.uses |= CrField(BFORM_BI(inst));
+	if (inst & 1)
+		u.defs |= REGMASK_LR;
+}
+
+static uint64_t SprMask(uint32_t spr) {
+	switch (spr) {
+	case 1: return REGMASK_XER;
+	case 8: return REGMASK_LR;
+	case 9: return REGMASK_CTR;
+	default: return 0;
+	}
+}
+
+static PpcRegUsage Group19(uint32_t inst) {
+	PpcRegUsage u = {0, 0};
+	uint32_t xo = (inst >> 1) & 0x3ff;
+	if ((xo & 0x1f) == 2) {
+		// addpcis
+		u.defs = REGMASK_GPR(DXFORM_RT(inst));
+		return u;
+	}
+	switch (xo) {
+	case 16:	// bclr
+		BranchUses(inst, u);
+		u.uses |= REGMASK_LR;
+		break;
+	case 528:	// bcctr
+		BranchUses(inst, u);
+		u.uses |= REGMASK_CTR;
+		break;
+	case 0:		// mcrf
+		u.uses = REGMASK_CR(XFORM_BFA(inst));
+		u.defs = REGMASK_CR(XFORM_BF(inst));
+		break;
+	case 33: case 129: case 193: case 225:
+	case 257: case 289: case 417: case 449:
+		// CR logical: crnor, crandc, crxor, crnand, crand, creqv, crorc, cror
+		u.uses = CrField(XFORM_RA(inst)) | CrField(XFORM_RB(inst));
+		u.defs = CrField(XFORM_BT(inst));
+		break;
+	case 150:	// isync
+		break;
+	default:
+		u.uses = u.defs = REGMASK_UNKNOWN;
+		break;
+	}
+	return u;
+}
+
+// FPR arithmetic: only cr1 (Rc) and compare targets are tracked
+static PpcRegUsage FloatGroup(uint32_t inst) {
+	PpcRegUsage u = {0, 0};
+	if (!(RECORD_FLAGS(PpcDecoder::Decode(inst, 0)) & INSN_VALID)) {
+		u.uses = u.defs = REGMASK_UNKNOWN;
+		return u;
+	}
+	uint32_t xo = (inst >> 1) & 0x3ff;
+	if ((inst >> 26) == 63 && (xo == 0 || xo == 32 || xo == 64)) {
+		// fcmpu, fcmpo, mcrfs
+		u.defs = REGMASK_CR(XFORM_BF(inst));
+		return u;
+	}
+	if (inst & 1)
+		u.defs = REGMASK_CR(1);
+	return u;
+}
+
+static PpcRegUsage VectorOp(uint32_t inst) {
+	PpcRegUsage u = {0, 0};
+	const VecOpcode *op = VecLookup(inst);
+	if (!op) {
+		u.uses = u.defs = REGMASK_UNKNOWN;
+		return u;
+	}
+	VecOperand ops[VEC_MAX_OPERANDS];
+	size_t n = VecDecodeOperands(*op, inst, ops);
+	for (size_t i = 0; i < n; i++) {
+		switch (ops[i].kind) {
+		case VecOperandKind::GPR:
+			(ops[i].dest ? u.defs : u.uses) |= REGMASK_GPR(ops[i].value);
+			break;
+		case VecOperandKind::CRF:
+			if (ops[i].dest)
+				u.defs |= REGMASK_CR(ops[i].value);
+			break;
+		case VecOperandKind::Mem:
+			u.uses |= Gpr0(ops[i].value);
+			break;
+		case VecOperandKind::MemX:
+			u.uses |= Gpr0(ops[i].value) | REGMASK_GPR(ops[i].index);
+			break;
+		default:
+			break;
+		}
+	}
+	if (op->form == VEC_VC_RC || op->form == VEC_XX3_RC)
+		u.defs |= REGMASK_CR(6);
+	return u;
+}
+
+PpcRegUsage PpcGetRegUsage(uint32_t inst) {
+	PpcRegUsage u = {0, 0};
+	uint32_t primary = inst >> 26;
+	uint32_t rt = XFORM_RS(inst), ra = XFORM_RA(inst), rb = XFORM_RB(inst);
+
+	switch (primary) {
+	case 4:
+	case 57:
+	case 60:
+	case 61:
+		return VectorOp(inst);
+	case 19:
+		return Group19(inst);
+	case 30:
+		/* rldicl/rldicr/rldic/rldimi, rldcl/rldcr */
+		u.uses = REGMASK_GPR(rt);
+		u.defs = REGMASK_GPR(ra);
+		if (MDFORM_Rc(inst))
+			u.defs |= REGMASK_CR(0);
+		if (((inst >> 2) & 7) == 3)
+			u.uses |= REGMASK_GPR(ra);
+		else if (MDSFORM_XO(inst) == 8 || MDSFORM_XO(inst) == 9)
+			u.uses |= REGMASK_GPR(rb);
+		return u;
+	case 58:
+		/* ld/ldu/lwa */
+		u.uses = Gpr0(ra);
+		u.defs = REGMASK_GPR(rt);
+		if ((inst & 3) == 1)
+			u.defs |= REGMASK_GPR(ra);
+		return u;
+	case 62:
+		/* std/stdu */
+		u.uses = REGMASK_GPR(rt) | Gpr0(ra);
+		if ((inst & 3) == 1)
+			u.defs = REGMASK_GPR(ra);
+		return u;
+	case 59:
+	case 63:
+		return FloatGroup(inst);
+	}
+
+	uint8_t slot = primary == 31 ? tables.x31[(inst >> 1) & 0x3ff] : tables.primary[primary];
+	if (!slot) {
+		// Vector loads/stores and moves live in group 31 too
+		if (primary == 31)
+			return VectorOp(inst);
+		u.uses = u.defs = REGMASK_UNKNOWN;
+		return u;
+	}
+	const RegSpec &s = specs[slot - 1];
+
+	switch (s.shape) {
+	case SHAPE_NONE:
+		break;
+	case SHAPE_D_LOAD:
+	case SHAPE_D_ARITH_RA0:
+		u.uses = Gpr0(ra);
+		u.defs = REGMASK_GPR(rt);
+		break;
+	case SHAPE_D_LOAD_U:
+		u.uses = REGMASK_GPR(ra);
+		u.defs = REGMASK_GPR(rt) | REGMASK_GPR(ra);
+		break;
+	case SHAPE_D_STORE:
+		u.uses = REGMASK_GPR(rt) | Gpr0(ra);
+		break;
+	case SHAPE_D_STORE_U:
+		u.uses = REGMASK_GPR(rt) | REGMASK_GPR(ra);
+		u.defs = REGMASK_GPR(ra);
+		break;
+	case SHAPE_D_FP:
+		u.uses = Gpr0(ra);
+		break;
+	case SHAPE_D_FP_U:
+		u.uses = REGMASK_GPR(ra);
+		u.defs = REGMASK_GPR(ra);
+		break;
+	case SHAPE_D_ARITH:
+		u.uses = REGMASK_GPR(ra);
+		u.defs = REGMASK_GPR(rt);
+		break;
+	case SHAPE_D_LOGICAL:
+		u.uses = REGMASK_GPR(rt);
+		u.defs = REGMASK_GPR(ra);
+		break;
+	case SHAPE_D_CMP:
+		u.uses = REGMASK_GPR(ra) | REGMASK_OV;
+		u.defs = REGMASK_CR(DFORM_BF(inst));
+		break;
+	case SHAPE_D_TRAP:
+		u.uses = REGMASK_GPR(ra);
+		break;
+	case SHAPE_LMW:
+		u.uses = Gpr0(ra);
+		u.defs = ~0ull << rt & 0xffffffffull;
+		break;
+	case SHAPE_STMW:
+		u.uses = (~0ull << rt & 0xffffffffull) | Gpr0(ra);
+		break;
+	case SHAPE_LSWI:
+		u.uses = Gpr0(ra);
+		u.defs = StringRegs(rt, XFORM_NB(inst));
+		break;
+	case SHAPE_STSWI:
+		u.uses = StringRegs(rt, XFORM_NB(inst)) | Gpr0(ra);
+		break;
+	case SHAPE_X_LOAD:
+		u.uses = Gpr0(ra) | REGMASK_GPR(rb);
+		u.defs = REGMASK_GPR(rt);
+		break;
+	case SHAPE_X_LOAD_U:
+		u.uses = REGMASK_GPR(ra) | REGMASK_GPR(rb);
+		u.defs = REGMASK_GPR(rt) | REGMASK_GPR(ra);
+		break;
+	case SHAPE_X_STORE:
+		u.uses = REGMASK_GPR(rt) | Gpr0(ra) | REGMASK_GPR(rb);
+		break;
+	case SHAPE_X_STORE_U:
+		u.uses = REGMASK_GPR(rt) | REGMASK_GPR(ra) | REGMASK_GPR(rb);
+		u.defs = REGMASK_GPR(ra);
+		break;
+	case SHAPE_X_ADDR:
+		u.uses = Gpr0(ra) | REGMASK_GPR(rb);
+		break;
+	case SHAPE_X_ADDR_U:
+		u.uses = REGMASK_GPR(ra) | REGMASK_GPR(rb);
+		u.defs = REGMASK_GPR(ra);
+		break;
+	case SHAPE_X_RB:
+		u.uses = REGMASK_GPR(rb);
+		break;
+	case SHAPE_X_RS_RB:
+		u.uses = REGMASK_GPR(rt) | REGMASK_GPR(rb);
+		break;
+	case SHAPE_XO_ARITH:
+		u.uses = REGMASK_GPR(ra) | REGMASK_GPR(rb);
+		u.defs = REGMASK_GPR(rt);
+		break;
+	case SHAPE_XO_ARITH1:
+		u.uses = REGMASK_GPR(ra);
+		u.defs = REGMASK_GPR(rt);
+		break;
+	case SHAPE_X_LOGICAL:
+		u.uses = REGMASK_GPR(rt) | REGMASK_GPR(rb);
+		u.defs = REGMASK_GPR(ra);
+		break;
+	case SHAPE_X_LOGICAL1:
+		u.uses = REGMASK_GPR(rt);
+		u.defs = REGMASK_GPR(ra);
+		break;
+	case SHAPE_X_CMP:
+		u.uses = REGMASK_GPR(ra) | REGMASK_GPR(rb) | REGMASK_OV;
+		u.defs = REGMASK_CR(XFORM_BF(inst));
+		break;
+	case SHAPE_X_TRAP:
+		u.uses = REGMASK_GPR(ra) | REGMASK_GPR(rb);
+		break;
+	case SHAPE_MFCR:
+		u.uses = REGMASK_CR_ALL;
+		u.defs = REGMASK_GPR(rt);
+		break;
+	case SHAPE_MTCRF:
+		u.uses = REGMASK_GPR(rt);
+		for (int i = 0; i < 8; i++) {
+			if (inst & (1 << (19 - i)))
+				u.defs |= REGMASK_CR(i);
+		}
+		break;
+	case SHAPE_MFSPR:
+		u.uses = SprMask(XFXFORM_SPR(inst));
+		u.defs = REGMASK_GPR(rt);
+		break;
+	case SHAPE_MTSPR:
+		u.uses = REGMASK_GPR(rt);
+		u.defs = SprMask(XFXFORM_SPR(inst));
+		break;
+	case SHAPE_MFTB:
+		u.defs = REGMASK_GPR(rt);
+		break;
+	case SHAPE_BC:
+		BranchUses(inst, u);
+		break;
+	case SHAPE_B:
+		if (inst & 1)
+			u.defs = REGMASK_LR;
+		break;
+	case SHAPE_SC:
+		// Linux convention: number in r0, arguments r3-r8, result in r3
+		// with the error flag in cr0.SO
+		u.uses = REGMASK_GPR(0) | (0x3full << 3);
+		u.defs = REGMASK_GPR(3) | REGMASK_CR(0);
+		break;
+	}
+
+	if ((s.flags & SPEC_RC) && (inst & 1))
+		u.defs |= REGMASK_CR(0);
+	if (s.flags & SPEC_CR0)
+		u.defs |= REGMASK_CR(0);
+	if ((s.flags & (SPEC_RC | SPEC_CR0)) && (u.defs & REGMASK_CR(0)))
+		u.uses |= REGMASK_OV;	// cr0.SO is a copy of XER.SO
+	if ((s.flags & SPEC_OE) && (inst & 0x400)) {
+		// SO is sticky, so setting it reads it
+		u.uses |= REGMASK_OV;
+		u.defs |= REGMASK_OV;
+	}
+	if (s.flags & SPEC_CA_DEF)
+		u.defs |= REGMASK_CA;
+	if (s.flags & SPEC_CA_USE)
+		u.uses |= REGMASK_CA;
+	if (s.flags & SPEC_READS_RA)
+		u.uses |= REGMASK_GPR(ra);
+	return u;
+}
+
+void PpcGetRegUsageBlock(const uint8_t *data, size_t count, PpcRegUsage *out) {
+	for (size_t i = 0; i < count; i++)
+		out[i] = PpcGetRegUsage(ReadInstruction(data + i * 4));
+}
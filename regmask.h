@@ -0,0 +1,50 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Register read/write sets without lifting.
+ *
+ * Every instruction maps to a shape (which fields are read and written)
+ * plus a few side effects (Rc, OE, carry, LR). The shapes come from a
+ * spec list that is turned into direct-indexed tables at compile time.
+ * FPRs and vector registers are not tracked; their address operands are.
+ */
+
+#define REGMASK_GPR(n)	(1ull << (n))
+#define REGMASK_CTR	(1ull << 32)
+#define REGMASK_LR	(1ull << 33)
+#define REGMASK_CR(n)	(1ull << (34 + (n)))
+#define REGMASK_CR_ALL	(0xffull << 34)
+#define REGMASK_CA	(1ull << 42)	// XER.CA
+#define REGMASK_OV	(1ull << 43)	// XER.OV and XER.SO
+#define REGMASK_XER	(REGMASK_CA | REGMASK_OV)
+// Set in both masks for words the tables don't know
+#define REGMASK_UNKNOWN	(1ull << 63)
+
+struct PpcRegUsage {
+	uint64_t uses;
+	uint64_t defs;
+};
+
+PpcRegUsage PpcGetRegUsage(uint32_t inst);
+
+// Fills out[i] for count consecutive big-endian instruction words.
+void PpcGetRegUsageBlock(const uint8_t *data, size_t count, PpcRegUsage *out);
@@ -0,0 +1,176 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "spr.h"
+#include "registers.h"
+
+#include <cstring>
+
+struct SprSpec {
+	uint16_t number;
+	const char *name;
+	const char *mf;
+	const char *mt;
+	uint16_t canonical;
+	uint8_t flags;
+};
+
+#define SPR(n, name, canonical, flags) {n, #name, "mf" #name, "mt" #name, canonical, flags}
+
+static constexpr SprSpec specs[] = {
+	SPR(1, xer, 1, 0),
+	SPR(3, dscr, 17, SPR_ALIAS),
+	SPR(8, lr, 8, 0),
+	SPR(9, ctr, 9, 0),
+	SPR(13, amr, 29, SPR_ALIAS),
+	SPR(17, dscr, 17, 0),
+	SPR(18, dsisr, 18, 0),
+	SPR(19, dar, 19, 0),
+	SPR(22, dec, 22, SPR_VOLATILE),
+	SPR(25, sdr1, 25, 0),
+	SPR(26, srr0, 26, 0),
+	SPR(27, srr1, 27, 0),
+	SPR(28, cfar, 28, 0),
+	SPR(29, amr, 29, 0),
+	SPR(48, pidr, 48, 0),
+	SPR(61, iamr, 61, 0),
+	SPR(128, tfhar, 128, 0),
+	SPR(129, tfiar, 129, 0),
+	SPR(130, texasr, 130, 0),
+	SPR(131, texasru, 131, 0),
+	SPR(136, ctrl, 152, SPR_ALIAS | SPR_READ),
+	SPR(152, ctrl, 152, SPR_WRITE),
+	SPR(153, fscr, 153, 0),
+	SPR(157, uamor, 157, 0),
+	SPR(256, vrsave, 256, 0),
+	SPR(259, sprg3, 275, SPR_ALIAS | SPR_READ),
+	SPR(268, tb, 268, SPR_VOLATILE | SPR_READ),
+	SPR(269, tbu, 269, SPR_VOLATILE | SPR_READ),
+	SPR(272, sprg0, 272, 0),
+	SPR(273, sprg1, 273, 0),
+	SPR(274, sprg2, 274, 0),
+	SPR(275, sprg3, 275, 0),
+	SPR(284, tbl, 284, SPR_VOLATILE | SPR_WRITE),
+	SPR(285, tbu, 285, SPR_VOLATILE | SPR_WRITE),
+	SPR(286, tbu40, 286, SPR_VOLATILE | SPR_WRITE),
+	SPR(287, pvr, 287, SPR_READ),
+	SPR(304, hsprg0, 304, 0),
+	SPR(305, hsprg1, 305, 0),
+	SPR(306, hdsisr, 306, 0),
+	SPR(307, hdar, 307, 0),
+	SPR(308, spurr, 308, SPR_VOLATILE),
+	SPR(309, purr, 309, SPR_VOLATILE),
+	SPR(310, hdec, 310, SPR_VOLATILE),
+	SPR(313, hrmor, 313, 0),
+	SPR(314, hsrr0, 314, 0),
+	SPR(315, hsrr1, 315, 0),
+	SPR(318, lpcr, 318, 0),
+	SPR(319, lpidr, 319, 0),
+	SPR(336, hmer, 336, 0),
+	SPR(337, hmeer, 337, 0),
+	SPR(338, pcr, 338, 0),
+	SPR(339, heir, 339, 0),
+	SPR(349, amor, 349, 0),
+	SPR(446, tir, 446, SPR_READ),
+	SPR(769, ummcr2, 785, SPR_ALIAS),
+	SPR(770, ummcra, 786, SPR_ALIAS),
+	SPR(771, upmc1, 787, SPR_ALIAS | SPR_VOLATILE),
+	SPR(772, upmc2, 788, SPR_ALIAS | SPR_VOLATILE),
+	SPR(773, upmc3, 789, SPR_ALIAS | SPR_VOLATILE),
+	SPR(774, upmc4, 790, SPR_ALIAS | SPR_VOLATILE),
+	SPR(775, upmc5, 791, SPR_ALIAS | SPR_VOLATILE),
+	SPR(776, upmc6, 792, SPR_ALIAS | SPR_VOLATILE),
+	SPR(779, ummcr0, 795, SPR_ALIAS),
+	SPR(780, usiar, 796, SPR_ALIAS | SPR_READ),
+	SPR(781, usdar, 797, SPR_ALIAS | SPR_READ),
+	SPR(782, ummcr1, 798, SPR_ALIAS | SPR_READ),
+	SPR(785, mmcr2, 785, 0),
+	SPR(786, mmcra, 786, 0),
+	SPR(787, pmc1, 787, SPR_VOLATILE),
+	SPR(788, pmc2, 788, SPR_VOLATILE),
+	SPR(789, pmc3, 789, SPR_VOLATILE),
+	SPR(790, pmc4, 790, SPR_VOLATILE),
+	SPR(791, pmc5, 791, SPR_VOLATILE),
+	SPR(792, pmc6, 792, SPR_VOLATILE),
+	SPR(795, mmcr0, 795, 0),
+	SPR(796, siar, 796, 0),
+	SPR(797, sdar, 797, 0),
+	SPR(798, mmcr1, 798, 0),
+	SPR(804, ebbhr, 804, 0),
+	SPR(805, ebbrr, 805, 0),
+	SPR(806, bescr, 806, 0),
+	SPR(815, tar, 815, 0),
+	SPR(816, asdr, 816, 0),
+	SPR(848, ic, 848, SPR_VOLATILE),
+	SPR(849, vtb, 849, SPR_VOLATILE),
+	SPR(855, psscr, 855, 0),
+	SPR(896, ppr, 896, 0),
+	SPR(898, ppr32, 898, 0),
+	SPR(1023, pir, 1023, SPR_READ),
+};
+
+#define SPR_COUNT (sizeof(specs) / sizeof(specs[0]))
+
+struct SprTable {
+	PpcSpr entries[1024];
+	uint32_t regs[SPR_COUNT];
+	uint32_t regCount;
+};
+
+static constexpr uint32_t SprRegister(const SprSpec &s) {
+	if (s.canonical == 8)
+		return PPC_REG_LR;
+	if (s.canonical == 9)
+		return PPC_REG_CTR;
+	return PPC_REG_SPR(s.canonical);
+}
+
+static constexpr SprTable BuildTable() {
+	SprTable t = {};
+	for (size_t i = 0; i < SPR_COUNT; i++) {
+		const SprSpec &s = specs[i];
+		t.entries[s.number] = {s.name, s.mf, s.mt, SprRegister(s), s.flags};
+		if (!(s.flags & (SPR_ALIAS | SPR_VOLATILE)) && s.canonical != 8 && s.canonical != 9 && s.canonical == s.number)
+			t.regs[t.regCount++] = SprRegister(s);
+	}
+	return t;
+}
+
+static constexpr SprTable table = BuildTable();
+
+const PpcSpr &PpcSprInfo(uint32_t spr) {
+	return table.entries[spr & 0x3ff];
+}
+
+int PpcSprByName(const char *name, bool write) {
+	// Aliases are only taken when nothing else has the name
+	int alias = -1;
+	for (size_t i = 0; i < SPR_COUNT; i++) {
+		const SprSpec &s = specs[i];
+		if (strcmp(s.name, name) != 0 || (s.flags & (write ? SPR_READ : SPR_WRITE)))
+			continue;
+		if (!(s.flags & SPR_ALIAS))
+			return s.number;
+		if (alias < 0)
+			alias = s.number;
+	}
+	return alias;
+}
+
+const uint32_t *PpcSprRegisters(uint32_t &count) {
+	count = table.regCount;
+	return table.regs;
+}
@@ -0,0 +1,55 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Special-purpose registers, indexed by the 10-bit SPR number (the
+ * swapped field, as returned by XFXFORM_SPR).
+ *
+ * Named SPRs move to and from a register of their own, so dataflow can
+ * follow them. User-mode aliases share the register of the SPR they
+ * alias. SPRs that change between reads (time base, decrementer,
+ * performance counters) keep lifting to the mfspr/mtspr intrinsics.
+ */
+
+#define SPR_VOLATILE	0x01	/* changes without being written */
+#define SPR_ALIAS	0x02	/* another number for an SPR listed elsewhere */
+#define SPR_READ	0x04	/* read-only number */
+#define SPR_WRITE	0x08	/* write-only number */
+
+struct PpcSpr {
+	const char *name;	// nullptr for unnamed SPRs
+	const char *mf;		// "mf" mnemonic
+	const char *mt;		// "mt" mnemonic
+	uint32_t reg;		// architecture register; lr/ctr for 8/9
+	uint8_t flags;
+};
+
+const PpcSpr &PpcSprInfo(uint32_t spr);
+
+// Named and not volatile: moves lift as register reads and writes
+static inline bool PpcSprLifts(const PpcSpr &s) {
+	return s.name && !(s.flags & SPR_VOLATILE);
+}
+
+// SPR number for an mf/mt mnemonic suffix ("srr0"), or -1
+int PpcSprByName(const char *name, bool write);
+
+// Registers the lifter can produce for SPRs, lr and ctr excluded
+const uint32_t *PpcSprRegisters(uint32_t &count);
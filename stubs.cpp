@@ -0,0 +1,142 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "stubs.h"
+#include "decoder.h"
+#include "memprof.h"
+
+#include "decode_macros.h"
+
+#define INSN_BCTR 0x4e800420
+
+static bool IsTocSave(uint32_t inst) {
+	// std r2,24(r1) or std r2,40(r1)
+	return inst == 0xf8410018 || inst == 0xf8410028;
+}
+
+static bool IsMtctr(uint32_t inst) {
+	return (inst & 0xfc1fffff) == 0x7c0903a6;
+}
+
+bool PpcMatchCallStub(const uint8_t *data, size_t len, uint64_t addr, uint64_t toc, PpcCallStub &stub) {
+	// Known values: base[r] is valid when known[r] is set. loaded[r] is
+	// the slot r was loaded from.
+	uint64_t base[32], loaded[32];
+	uint32_t known = 1u << 2, isLoaded = 0;
+	base[2] = toc;
+	uint64_t ctrSlot = 0;
+	bool ctrKnown = false;
+
+	size_t count = len / 4;
+	if (count > STUB_MAX_INSNS)
+		count = STUB_MAX_INSNS;
+	for (size_t i = 0; i < count; i++) {
+		uint32_t inst = ReadInstruction(data + i * 4);
+		uint32_t rt = DFORM_RT(inst), ra = DFORM_RA(inst);
+		switch (inst >> 26) {
+		case 15:
+			/* addis rt,ra,hi */
+			if (ra == 0 || !(known & (1u << ra)))
+				return false;
+			base[rt] = base[ra] + (SEXT16(DFORM_UI(inst)) << 16);
+			known |= 1u << rt;
+			isLoaded &= ~(1u << rt);
+			continue;
+		case 14:
+			/* addi rt,ra,lo */
+			if (ra == 0 || !(known & (1u << ra)))
+				return false;
+			base[rt] = base[ra] + SEXT16(DFORM_UI(inst));
+			known |= 1u << rt;
+			isLoaded &= ~(1u << rt);
+			continue;
+		case 58:
+			/* ld rt,ds(ra) */
+			if ((inst & 3) != 0 || ra == 0 || !(known & (1u << ra)))
+				return false;
+			if (rt == 2) {
+				// TOC of the callee (ELFv1); r2 is no longer ours
+				known &= ~(1u << 2);
+				continue;
+			}
+			loaded[rt] = base[ra] + SEXT16(inst & 0xfffc);
+			isLoaded |= 1u << rt;
+			known &= ~(1u << rt);
+			continue;
+		case 62:
+			if (IsTocSave(inst) && (known & (1u << 2)))
+				continue;
+			return false;
+		case 31:
+			if (!IsMtctr(inst))
+				return false;
+			rt = DFORM_RT(inst);
+			if (!(isLoaded & (1u << rt)))
+				return false;
+			ctrSlot = loaded[rt];
+			ctrKnown = true;
+			continue;
+		case 19:
+			if (inst != INSN_BCTR || !ctrKnown)
+				return false;
+			stub.start = addr;
+			stub.branch = addr + i * 4;
+			stub.slot = ctrSlot;
+			return true;
+		default:
+			return false;
+		}
+	}
+	return false;
+}
+
+void PpcFindCallStubs(const uint8_t *data, size_t len, uint64_t addr, uint64_t toc, std::vector<PpcCallStub> &stubs) {
+	size_t count = len / 4;
+	for (size_t i = 0; i < count; i++) {
+		uint32_t inst = ReadInstruction(data + i * 4);
+		// Stubs open with the TOC save, addis from r2 or ld from r2
+		bool candidate = IsTocSave(inst)
+			|| ((inst >> 26) == 15 && DFORM_RA(inst) == 2)
+			|| ((inst >> 26) == 58 && DFORM_RA(inst) == 2 && DFORM_RT(inst) != 2);
+		if (!candidate)
+			continue;
+		PpcCallStub stub;
+		if (!PpcMatchCallStub(data + i * 4, (count - i) * 4, addr + i * 4, toc, stub))
+			continue;
+		stubs.push_back(stub);
+		i = (stub.branch - addr) / 4;
+	}
+}
+
+CallStubTable::~CallStubTable() {
+	PpcMemProfile::Hold(MemCache::CallStubs, -MemMapBytes(slotByBranch));
+}
+
+void CallStubTable::Add(const PpcCallStub &stub) {
+	std::lock_guard<std::mutex> guard(lock);
+	int64_t before = MemMapBytes(slotByBranch);
+	slotByBranch[stub.branch] = stub.slot;
+	PpcMemProfile::Hold(MemCache::CallStubs, MemMapBytes(slotByBranch) - before);
+}
+
+bool CallStubTable::Lookup(uint64_t branch, uint64_t &slot) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = slotByBranch.find(branch);
+	if (it == slotByBranch.end())
+		return false;
+	slot = it->second;
+	return true;
+}
@@ -0,0 +1,65 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Recognizer for linker-generated PLT call stubs.
+ *
+ * ELFv1:  std r2,40(r1); addis r11,r2,hi; ld r12,lo(r11); mtctr r12;
+ *         ld r2,lo+8(r11); [ld r11,lo+16(r11);] bctr
+ * ELFv2:  std r2,24(r1); addis r12,r2,hi; ld r12,lo(r12); mtctr r12; bctr
+ *
+ * The addis is dropped for small offsets and the TOC save is dropped for
+ * tail calls. Stubs are matched by evaluating the sequence against a known
+ * TOC pointer, so the PLT slot falls out without any dataflow.
+ */
+
+#define STUB_MAX_INSNS 8
+
+struct PpcCallStub {
+	uint64_t start;
+	uint64_t branch;	// address of the bctr
+	uint64_t slot;		// PLT/GOT entry holding the target
+};
+
+// Matches a stub starting at addr; toc is the value of r2 on entry.
+bool PpcMatchCallStub(const uint8_t *data, size_t len, uint64_t addr, uint64_t toc, PpcCallStub &stub);
+
+// Finds every stub in [addr, addr+len).
+void PpcFindCallStubs(const uint8_t *data, size_t len, uint64_t addr, uint64_t toc, std::vector<PpcCallStub> &stubs);
+
+/*
+ * Stubs found in one view, keyed by the address of their bctr, so the
+ * lifter can turn the branch into a tail call through the slot. Owned by
+ * the view's PpcViewState.
+ */
+class CallStubTable {
+private:
+	std::mutex lock;
+	std::unordered_map<uint64_t, uint64_t> slotByBranch;
+public:
+	~CallStubTable();
+
+	void Add(const PpcCallStub &stub);
+	bool Lookup(uint64_t branch, uint64_t &slot);
+};
@@ -0,0 +1,247 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "text.h"
+#include "atomic.h"
+#include "decoder.h"
+#include "threadpool.h"
+#include "spr.h"
+#include "vector.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "decode_macros.h"
+
+// 256k instructions per job: large enough to amortize scheduling, small
+// enough that a few chunks in flight per thread bound memory use.
+#define EXPORT_CHUNK_WORDS (256 * 1024)
+#define EXPORT_CHUNKS_PER_THREAD 2
+
+static const char hexDigits[] = "0123456789abcdef";
+
+static void AppendHex(std::string *out, uint64_t v) {
+	char buf[16];
+	int n = 0;
+	do {
+		buf[n++] = hexDigits[v & 0xf];
+		v >>= 4;
+	} while (v);
+	while (n)
+		out->push_back(buf[--n]);
+}
+
+static void AppendDecimal(std::string *out, uint64_t v) {
+	char buf[20];
+	int n = 0;
+	do {
+		buf[n++] = '0' + v % 10;
+		v /= 10;
+	} while (v);
+	while (n)
+		out->push_back(buf[--n]);
+}
+
+void PpcTextFormatter::Op(const char *v) {
+	mnemonicStart = out->size();
+	out->append(v);
+	mnemonicEnd = out->size();
+	operands = 0;
+}
+
+void PpcTextFormatter::Op(const std::string &v) {
+	Op(v.c_str());
+}
+
+void PpcTextFormatter::OpRc(const std::string &v, uint32_t inst) {
+	Op(v.c_str());
+	if (inst & 1) {
+		out->push_back('.');
+		mnemonicEnd++;
+	}
+}
+
+void PpcTextFormatter::Separator() {
+	if (operands++) {
+		out->append(", ");
+		return;
+	}
+	size_t width = mnemonicEnd - mnemonicStart;
+	if (padTo > width)
+		out->append(padTo - width, ' ');
+	else
+		out->push_back(' ');
+}
+
+void PpcTextFormatter::Reg(uint32_t reg) {
+	Separator();
+	out->push_back('r');
+	AppendDecimal(out, reg);
+}
+
+void PpcTextFormatter::FReg(uint32_t reg) {
+	Separator();
+	out->push_back('f');
+	AppendDecimal(out, reg);
+}
+
+void PpcTextFormatter::VReg(uint32_t reg) {
+	Separator();
+	out->push_back('v');
+	AppendDecimal(out, reg);
+}
+
+void PpcTextFormatter::VsReg(uint32_t reg) {
+	Separator();
+	out->append("vs");
+	AppendDecimal(out, reg);
+}
+
+void PpcTextFormatter::Imm(uint64_t imm) {
+	Separator();
+	out->append("0x");
+	AppendHex(out, imm);
+}
+
+void PpcTextFormatter::Disp(uint32_t reg, uint64_t d) {
+	Separator();
+	if ((int64_t)d < 0) {
+		out->push_back('-');
+		d = -d;
+	}
+	AppendDecimal(out, d);
+	out->append("(r");
+	AppendDecimal(out, reg);
+	out->push_back(')');
+}
+
+bool PpcTextFormatter::Format(const uint8_t *data, uint64_t addr) {
+	size_t start = out->size();
+	mnemonicEnd = start;
+	if (!DecodeInstruction(data, addr) || out->size() == start) {
+		out->resize(start);
+		return false;
+	}
+	return true;
+}
+
+#define DECODE_MAIN PpcTextFormatter::DecodeInstruction
+#define DECODE_GROUP(g) PpcTextFormatter::decode##g
+#define EMIT_ASM
+#include "decode.inc.cpp"
+#undef EMIT_ASM
+#undef DECODE_MAIN
+#undef DECODE_GROUP
+
+static void AppendBytes(std::string *out, const uint8_t *p, bool spaced) {
+	for (int i = 0; i < 4; i++) {
+		out->push_back(hexDigits[p[i] >> 4]);
+		out->push_back(hexDigits[p[i] & 0xf]);
+		if (spaced)
+			out->push_back(' ');
+	}
+}
+
+void PpcRenderText(const uint8_t *data, size_t len, uint64_t addr, TextFormat format, std::string &out) {
+	PpcTextFormatter fmt(&out, 7);
+	// JSONL splits mnemonic and operands, so each line is formatted apart
+	std::string line;
+	PpcTextFormatter json(&line);
+	out.reserve(out.size() + len / 4 * (format == TextFormat::Objdump ? 48 : 96));
+	for (size_t off = 0; off + 4 <= len; off += 4) {
+		const uint8_t *p = data + off;
+		if (format == TextFormat::Objdump) {
+			size_t col = out.size();
+			AppendHex(&out, addr + off);
+			if (out.size() - col < 8)
+				out.insert(col, 8 - (out.size() - col), ' ');
+			out.append(":\t");
+			AppendBytes(&out, p, true);
+			out.push_back('\t');
+			if (!fmt.Format(p, addr + off)) {
+				out.append(".long 0x");
+				AppendHex(&out, ReadInstruction(p));
+			}
+			out.push_back('\n');
+			continue;
+		}
+
+		out.append("{\"address\":");
+		AppendDecimal(&out, addr + off);
+		out.append(",\"bytes\":\"");
+		AppendBytes(&out, p, false);
+		line.clear();
+		if (!json.Format(p, addr + off)) {
+			out.append("\",\"mnemonic\":null,\"operands\":null}\n");
+			continue;
+		}
+		// Neither part ever contains characters that need escaping
+		size_t end = json.MnemonicEnd();
+		out.append("\",\"mnemonic\":\"");
+		out.append(line, 0, end);
+		out.append("\",\"operands\":\"");
+		if (end < line.size())
+			out.append(line, end + 1, std::string::npos);
+		out.append("\"}\n");
+	}
+}
+
+bool PpcExportText(const uint8_t *data, size_t len, uint64_t addr, TextFormat format, FILE *f,
+	const std::function<bool(uint64_t)> &progress) {
+	size_t chunkBytes = EXPORT_CHUNK_WORDS * 4;
+	size_t count = (len / 4 * 4 + chunkBytes - 1) / chunkBytes;
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	size_t window = threads * EXPORT_CHUNKS_PER_THREAD;
+
+	std::mutex lock;
+	std::condition_variable cv;
+	std::vector<std::string> chunks(count);
+	std::vector<bool> done(count, false);
+
+	ThreadPool pool(threads, false);
+	size_t queued = 0;
+	for (size_t i = 0; i < count; i++) {
+		// Keep a bounded number of rendered chunks waiting for the writer
+		for (; queued < count && queued < i + window; queued++) {
+			pool.Enqueue([&, queued]() {
+				size_t off = queued * chunkBytes;
+				size_t n = std::min(chunkBytes, len / 4 * 4 - off);
+				std::string text;
+				PpcRenderText(data + off, n, addr + off, format, text);
+				std::lock_guard<std::mutex> guard(lock);
+				chunks[queued] = std::move(text);
+				done[queued] = true;
+				cv.notify_all();
+			});
+		}
+
+		std::string text;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			cv.wait(guard, [&]() { return done[i]; });
+			text = std::move(chunks[i]);
+		}
+		if (fwrite(text.data(), 1, text.size(), f) != text.size())
+			return false;
+		// Chunks still queued are rendered and dropped when the pool joins
+		if (progress && !progress(addr + std::min(len / 4 * 4, (i + 1) * chunkBytes)))
+			break;
+	}
+	return true;
+}
@@ -0,0 +1,89 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+/*
+ * Flat-text disassembly for bulk export.
+ *
+ * PpcTextFormatter runs the same EMIT_ASM decode paths as PpcDisassembler,
+ * so the text is identical, but it appends characters to one buffer
+ * instead of building token vectors. It does not need Binary Ninja.
+ */
+
+enum class TextFormat {
+	Objdump,	// "    1000:\t7c 08 02 a6 \tmflr    r0"
+	Jsonl,		// {"address":4096,"bytes":"7c0802a6","mnemonic":"mflr","operands":"r0"}
+};
+
+class PpcTextFormatter {
+private:
+	std::string *out;
+	size_t operands = 0;
+	size_t mnemonicStart = 0;
+	size_t mnemonicEnd = 0;
+	size_t padTo = 0;
+
+	void Op(const char *v);
+	void Op(const std::string &v);
+	void OpRc(const std::string &v, uint32_t inst);
+	void Separator();
+	void Reg(uint32_t reg);
+	void FReg(uint32_t reg);
+	void VReg(uint32_t reg);
+	void VsReg(uint32_t reg);
+	void Imm(uint64_t imm);
+	void Disp(uint32_t reg, uint64_t d);
+
+	bool decode19(uint32_t inst);
+	bool decode30(uint32_t inst);
+	bool decode31(uint32_t inst);
+	bool decode58(uint32_t inst);
+	bool decode59(uint32_t inst);
+	bool decode62(uint32_t inst);
+	bool decode63(uint32_t inst);
+	bool decodeFloatA(uint32_t inst, bool single);
+	bool decodeVector(uint32_t inst);
+public:
+	// padTo pads the mnemonic with spaces to that width, objdump style.
+	PpcTextFormatter(std::string *out, size_t padTo = 0) : out(out), padTo(padTo) {}
+
+	// Appends "mnemonic operands" for one instruction. Returns false, with
+	// out unchanged, for words that don't decode.
+	bool Format(const uint8_t *data, uint64_t addr);
+
+	// Offset in out just past the last mnemonic written
+	size_t MnemonicEnd() const { return mnemonicEnd; }
+
+	bool DecodeInstruction(const uint8_t *data, uint64_t addr);
+};
+
+// Renders len bytes of code at addr, one line per instruction, appending
+// to out. Words that don't decode are rendered as ".long".
+void PpcRenderText(const uint8_t *data, size_t len, uint64_t addr, TextFormat format, std::string &out);
+
+// Renders a range in chunks on a thread pool and writes the chunks to f in
+// address order. progress, if set, is called with the address reached
+// after each chunk is written; returning false stops the export there.
+// Returns false on a write error.
+bool PpcExportText(const uint8_t *data, size_t len, uint64_t addr, TextFormat format, FILE *f,
+	const std::function<bool(uint64_t)> &progress = nullptr);
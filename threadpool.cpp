@@ -0,0 +1,68 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "threadpool.h"
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+ThreadPool::ThreadPool(size_t threads, bool lowPriority) : lowPriority(lowPriority) {
+	if (threads == 0)
+		threads = 1;
+	for (size_t i = 0; i < threads; i++)
+		workers.emplace_back(&ThreadPool::Run, this);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	cv.notify_all();
+	for (auto &t : workers)
+		t.join();
+}
+
+void ThreadPool::Enqueue(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back(std::move(job));
+	}
+	cv.notify_one();
+}
+
+void ThreadPool::Run() {
+#ifdef __linux__
+	// On Linux the nice value is per thread.
+	if (lowPriority)
+		setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+#endif
+	for (;;) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			cv.wait(guard, [this]() { return stopping || !jobs.empty(); });
+			if (jobs.empty())
+				return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
@@ -0,0 +1,116 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "toc.h"
+#include "decoder.h"
+#include "memprof.h"
+
+#include "decode_macros.h"
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+bool PpcMatchGlobalEntry(const uint8_t *data, size_t len, uint64_t addr, uint64_t &toc) {
+	if (len < 8)
+		return false;
+	uint32_t hi = ReadInstruction(data), lo = ReadInstruction(data + 4);
+	// addis r2,r12,hi / addi r2,r2,lo
+	if ((hi & 0xffff0000) != 0x3c4c0000 || (lo & 0xffff0000) != 0x38420000)
+		return false;
+	toc = addr + (SEXT16(DFORM_UI(hi)) << 16) + SEXT16(DFORM_UI(lo));
+	return true;
+}
+
+void PpcFindGlobalEntries(const uint8_t *data, size_t len, uint64_t addr, std::vector<PpcFunctionEntry> &entries) {
+	size_t count = len / 4;
+	for (size_t i = 0; i + 1 < count; i++) {
+		uint64_t toc;
+		if (PpcMatchGlobalEntry(data + i * 4, len - i * 4, addr + i * 4, toc))
+			entries.push_back({addr + i * 4, toc});
+	}
+}
+
+static inline uint64_t ReadBE64(const uint8_t *p) {
+	return ((uint64_t)ReadInstruction(p) << 32) | ReadInstruction(p + 4);
+}
+
+void PpcParseOpd(const uint8_t *data, size_t len, std::vector<PpcFunctionEntry> &entries) {
+	size_t count = len / OPD_DESCRIPTOR_SIZE;
+	entries.resize(count);
+	// Straight-line loads and byte swaps only, so this vectorizes
+	for (size_t i = 0; i < count; i++) {
+		const uint8_t *d = data + i * OPD_DESCRIPTOR_SIZE;
+		entries[i].global = ReadBE64(d);
+		entries[i].toc = ReadBE64(d + 8);
+	}
+}
+
+TocTable::~TocTable() {
+	PpcMemProfile::Hold(MemCache::TocTables, -MemMapBytes(globalByLocal) - MemMapBytes(tocByEntry));
+}
+
+void TocTable::AddGlobalEntry(const PpcFunctionEntry &entry) {
+	std::unique_lock<std::shared_mutex> guard(lock);
+	int64_t before = MemMapBytes(globalByLocal);
+	globalByLocal[entry.global + ELFV2_LOCAL_ENTRY_OFFSET] = entry.global;
+	PpcMemProfile::Hold(MemCache::TocTables, MemMapBytes(globalByLocal) - before);
+	haveEntries.store(true, std::memory_order_release);
+}
+
+void TocTable::AddFoldRange(uint64_t start, uint64_t end) {
+	std::unique_lock<std::shared_mutex> guard(lock);
+	foldRanges.emplace_back(start, end);
+}
+
+bool TocTable::Covers(uint64_t addr) const {
+	if (!haveEntries.load(std::memory_order_acquire))
+		return false;
+	std::shared_lock<std::shared_mutex> guard(lock);
+	for (auto &r : foldRanges) {
+		if (addr >= r.first && addr < r.second)
+			return true;
+	}
+	return false;
+}
+
+uint64_t TocTable::Fold(uint64_t addr) const {
+	if (!haveEntries.load(std::memory_order_acquire))
+		return addr;
+	std::shared_lock<std::shared_mutex> guard(lock);
+	auto it = globalByLocal.find(addr);
+	return it == globalByLocal.end() ? addr : it->second;
+}
+
+void TocTable::SetEntryToc(uint64_t addr, uint64_t toc) {
+	std::unique_lock<std::shared_mutex> guard(lock);
+	int64_t before = MemMapBytes(tocByEntry);
+	tocByEntry[addr] = toc;
+	PpcMemProfile::Hold(MemCache::TocTables, MemMapBytes(tocByEntry) - before);
+	haveTocs.store(true, std::memory_order_release);
+}
+
+bool TocTable::EntryToc(uint64_t addr, uint64_t &toc) const {
+	if (!haveTocs.load(std::memory_order_acquire))
+		return false;
+	std::shared_lock<std::shared_mutex> guard(lock);
+	auto it = tocByEntry.find(addr);
+	if (it == tocByEntry.end())
+		return false;
+	toc = it->second;
+	return true;
+}
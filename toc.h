@@ -0,0 +1,89 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Function entry points and their TOC pointers.
+ *
+ * ELFv1 symbols name 24-byte .opd descriptors (entry, TOC, environment)
+ * rather than code. The view reads every descriptor at load, creates the
+ * functions at their entries and records each TOC. The lifter sets r2 to
+ * that TOC at the entry, so r2-relative loads resolve by constant
+ * propagation.
+ *
+ * ELFv2 functions that need a TOC open with a global entry that derives r2
+ * from r12 (the entry address); local callers skip it and "bl" to the
+ * local entry 8 bytes in. Calls to a known local entry are reported and
+ * lifted as calls to the global entry, so analysis only ever creates the
+ * function there and the local entry stays inside it. The global entry
+ * itself lifts r2 as the constant it computes.
+ *
+ * Both tables belong to one view and live in its PpcViewState.
+ */
+
+// Bytes from the global to the local entry, i.e. st_other value 3
+#define ELFV2_LOCAL_ENTRY_OFFSET 8
+
+// addis r2,r12,hi; addi r2,r2,lo at addr. Sets toc to what it computes.
+bool PpcMatchGlobalEntry(const uint8_t *data, size_t len, uint64_t addr, uint64_t &toc);
+
+struct PpcFunctionEntry {
+	uint64_t global;	// entry address; the global entry on ELFv2
+	uint64_t toc;
+};
+
+// Finds every global entry prologue in [addr, addr+len).
+void PpcFindGlobalEntries(const uint8_t *data, size_t len, uint64_t addr, std::vector<PpcFunctionEntry> &entries);
+
+#define OPD_DESCRIPTOR_SIZE 24
+
+// Decodes the big-endian descriptors of an .opd section, one entry per
+// descriptor. Entries are not checked.
+void PpcParseOpd(const uint8_t *data, size_t len, std::vector<PpcFunctionEntry> &entries);
+
+class TocTable {
+private:
+	mutable std::shared_mutex lock;
+	std::unordered_map<uint64_t, uint64_t> globalByLocal;
+	std::unordered_map<uint64_t, uint64_t> tocByEntry;
+	// Segments that were searched for global entries
+	std::vector<std::pair<uint64_t, uint64_t>> foldRanges;
+	// Let images without entries of either kind skip the lock
+	std::atomic<bool> haveEntries{false};
+	std::atomic<bool> haveTocs{false};
+public:
+	~TocTable();
+
+	void AddGlobalEntry(const PpcFunctionEntry &entry);
+	void AddFoldRange(uint64_t start, uint64_t end);
+	// Whether addr lies in a segment that was searched for global entries
+	bool Covers(uint64_t addr) const;
+	// The global entry for a local entry; anything else is returned as is
+	uint64_t Fold(uint64_t addr) const;
+
+	// TOC pointer on entry to the function at addr (ELFv1)
+	void SetEntryToc(uint64_t addr, uint64_t toc);
+	bool EntryToc(uint64_t addr, uint64_t &toc) const;
+};
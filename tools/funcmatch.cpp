@@ -0,0 +1,211 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Function matching between two builds.
+ *
+ * Reads two JSONL files written by the plugin's "Export function hashes"
+ * command, pairs their functions with PpcMatchFunctions and writes one
+ * JSON line per pair:
+ *
+ *   {"a":4096,"a_name":"f","b":8192,"b_name":"f","similarity":0.92}
+ *
+ * usage: ppc64-funcmatch [-t threshold] a.jsonl b.jsonl > matches.jsonl
+ *
+ * Pairs are written in the order PpcMatchFunctions returns them: exact
+ * matches first, then the rest best first. threshold (default 0.5) is the
+ * least estimated similarity a fuzzy pair may have.
+ */
+
+#include "funchash.h"
+#include "json.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define FUNCMATCH_THRESHOLD 0.5
+
+struct HashFile {
+	std::vector<uint64_t> address;
+	std::vector<std::string> name;
+	std::vector<PpcFunctionHash> hashes;
+};
+
+/* Parsing */
+
+// Position just past "key": in line, or nullptr
+static const char *Field(const std::string &line, const char *key) {
+	std::string pattern = std::string("\"") + key + "\":";
+	size_t at = line.find(pattern);
+	return at == std::string::npos ? nullptr : line.c_str() + at + pattern.size();
+}
+
+static bool ParseHex(const char *&p, size_t digits, uint64_t &v) {
+	v = 0;
+	for (size_t i = 0; i < digits; i++, p++) {
+		char c = *p;
+		if (c >= '0' && c <= '9')
+			v = (v << 4) | (c - '0');
+		else if (c >= 'a' && c <= 'f')
+			v = (v << 4) | (c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F')
+			v = (v << 4) | (c - 'A' + 10);
+		else
+			return false;
+	}
+	return true;
+}
+
+// A JSON string as written by PpcJsonString
+static bool ParseString(const char *&p, std::string &out) {
+	if (*p++ != '"')
+		return false;
+	out.clear();
+	while (*p && *p != '"') {
+		if (*p != '\\') {
+			out += *p++;
+			continue;
+		}
+		p++;
+		uint64_t code;
+		switch (*p++) {
+		case '"': out += '"'; break;
+		case '\\': out += '\\'; break;
+		case '/': out += '/'; break;
+		case 'n': out += '\n'; break;
+		case 't': out += '\t'; break;
+		case 'u':
+			// Only control characters are escaped this way
+			if (!ParseHex(p, 4, code) || code >= 0x80)
+				return false;
+			out += (char)code;
+			break;
+		default:
+			return false;
+		}
+	}
+	return *p++ == '"';
+}
+
+static bool ParseLine(const std::string &line, HashFile &file) {
+	const char *p;
+	uint64_t v;
+	PpcFunctionHash h;
+
+	if (!(p = Field(line, "address")))
+		return false;
+	char *end;
+	uint64_t address = strtoull(p, &end, 10);
+	if (end == p)
+		return false;
+
+	std::string name;
+	if (!(p = Field(line, "name")) || !ParseString(p, name))
+		return false;
+
+	if (!(p = Field(line, "words")))
+		return false;
+	h.words = strtoul(p, &end, 10);
+	if (end == p)
+		return false;
+
+	if (!(p = Field(line, "exact")) || *p++ != '"' || !ParseHex(p, 16, h.exact))
+		return false;
+
+	if (!(p = Field(line, "minhash")) || *p++ != '"')
+		return false;
+	for (size_t k = 0; k < FUNCHASH_MINHASH; k++) {
+		if (!ParseHex(p, 8, v))
+			return false;
+		h.minhash[k] = v;
+	}
+
+	if (!(p = Field(line, "bands")) || *p++ != '[')
+		return false;
+	for (size_t k = 0; k < FUNCHASH_BANDS; k++) {
+		if ((k && *p++ != ',') || *p++ != '"' || !ParseHex(p, 16, h.bands[k]) || *p++ != '"')
+			return false;
+	}
+
+	file.address.push_back(address);
+	file.name.push_back(std::move(name));
+	file.hashes.push_back(h);
+	return true;
+}
+
+static bool Load(const char *path, HashFile &file) {
+	std::ifstream in(path);
+	if (!in) {
+		fprintf(stderr, "%s: cannot open\n", path);
+		return false;
+	}
+	std::string line;
+	size_t lineNo = 0;
+	while (std::getline(in, line)) {
+		lineNo++;
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+		if (!ParseLine(line, file)) {
+			fprintf(stderr, "%s:%zu: not a function hash record\n", path, lineNo);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void Usage() {
+	fprintf(stderr, "usage: ppc64-funcmatch [-t threshold] a.jsonl b.jsonl\n");
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	double threshold = FUNCMATCH_THRESHOLD;
+
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc || arg != "-t")
+			Usage();
+		threshold = strtod(argv[++i], nullptr);
+	}
+	if (argc - i != 2)
+		Usage();
+
+	auto began = std::chrono::steady_clock::now();
+	HashFile a, b;
+	if (!Load(argv[i], a) || !Load(argv[i + 1], b))
+		return 1;
+
+	std::vector<PpcFunctionMatch> matches;
+	PpcMatchFunctions(a.hashes, b.hashes, threshold, matches);
+
+	size_t exact = 0;
+	for (const PpcFunctionMatch &m : matches) {
+		printf("{\"a\":%llu,\"a_name\":%s,\"b\":%llu,\"b_name\":%s,\"similarity\":%.4f}\n",
+			(unsigned long long)a.address[m.a], PpcJsonString(a.name[m.a]).c_str(),
+			(unsigned long long)b.address[m.b], PpcJsonString(b.name[m.b]).c_str(), m.similarity);
+		exact += m.similarity == 1.0 && a.hashes[m.a].exact == b.hashes[m.b].exact;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+	fprintf(stderr, "%zu of %zu/%zu functions matched (%zu exact) in %.2fs\n",
+		matches.size(), a.hashes.size(), b.hashes.size(), exact, seconds);
+	return 0;
+}
@@ -0,0 +1,211 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Stand-in for the parts of the Binary Ninja API that il.cpp uses, so the
+ * lifter can be built into tools that run without the core.
+ *
+ * LowLevelILFunction records a flat expression list instead of building
+ * real IL. Control flow operations keep their operands; everything else
+ * is recorded as LLIL_EXPR with its size.
+ */
+
+#define BN_INVALID_EXPR ((size_t)-1)
+
+enum BNLowLevelILOperation : uint8_t {
+	LLIL_EXPR,
+	LLIL_NOP,
+	LLIL_CONST,
+	LLIL_CONST_PTR,
+	LLIL_REG,
+	LLIL_JUMP,
+	LLIL_CALL,
+	LLIL_TAILCALL,
+	LLIL_RET,
+	LLIL_IF,
+	LLIL_GOTO,
+	LLIL_TRAP,
+	LLIL_SYSCALL,
+	LLIL_UNIMPL,
+	LLIL_INTRINSIC,
+};
+
+struct BNLowLevelILLabel {
+	bool resolved;
+	size_t ref;
+	size_t operand;
+};
+
+struct BNBinaryView;
+
+namespace BinaryNinja {
+	typedef size_t ExprId;
+
+	template <class T> class Ref {
+		T *p = nullptr;
+	public:
+		Ref() {}
+		Ref(T *t) : p(t) {}
+		T *operator->() const { return p; }
+		T *GetPtr() const { return p; }
+		operator T*() const { return p; }
+		bool operator!() const { return !p; }
+	};
+
+	class Architecture;
+
+	class BinaryView {
+	public:
+		BNBinaryView *GetObject() const { return nullptr; }
+	};
+
+	class Function {
+	public:
+		Ref<BinaryView> GetView() const { return nullptr; }
+	};
+
+	class LowLevelILLabel : public BNLowLevelILLabel {
+	public:
+		LowLevelILLabel() {
+			resolved = false;
+			ref = 0;
+			operand = BN_INVALID_EXPR;
+		}
+	};
+
+	class RegisterOrFlag {
+	public:
+		bool isFlag;
+		uint32_t index;
+
+		static RegisterOrFlag Register(uint32_t reg) { return {false, reg}; }
+		static RegisterOrFlag Flag(uint32_t flag) { return {true, flag}; }
+	};
+
+	struct SinkExpr {
+		BNLowLevelILOperation operation;
+		size_t size;
+		uint64_t value;		// constant, register, intrinsic or trap number
+		ExprId operand;		// destination or condition
+	};
+
+	class LowLevelILFunction {
+	private:
+		ExprId Expr(BNLowLevelILOperation op, size_t size = 0, uint64_t value = 0, ExprId operand = BN_INVALID_EXPR) {
+			exprs.push_back({op, size, value, operand});
+			return exprs.size() - 1;
+		}
+	public:
+		std::vector<SinkExpr> exprs;
+		std::vector<ExprId> instructions;
+
+		void Clear() {
+			exprs.clear();
+			instructions.clear();
+		}
+
+		Ref<Function> GetFunction() const { return nullptr; }
+
+		ExprId AddInstruction(ExprId expr) {
+			instructions.push_back(expr);
+			return instructions.size() - 1;
+		}
+
+		void MarkLabel(BNLowLevelILLabel &label) {
+			label.resolved = true;
+			label.operand = instructions.size();
+		}
+
+		// No instructions are lifted ahead, so no address has a label
+		BNLowLevelILLabel *GetLabelForAddress(Architecture *, uint64_t) { return nullptr; }
+
+		ExprId Nop() { return Expr(LLIL_NOP); }
+		ExprId Const(size_t size, uint64_t v) { return Expr(LLIL_CONST, size, v); }
+		ExprId ConstPointer(size_t size, uint64_t v) { return Expr(LLIL_CONST_PTR, size, v); }
+		ExprId FloatConstDouble(double) { return Expr(LLIL_EXPR, 8); }
+		ExprId Register(size_t size, uint32_t reg) { return Expr(LLIL_REG, size, reg); }
+		ExprId Flag(uint32_t flag) { return Expr(LLIL_EXPR, 0, flag); }
+
+		ExprId SetRegister(size_t size, uint32_t, ExprId, uint32_t = 0) { return Expr(LLIL_EXPR, size); }
+		ExprId SetFlag(uint32_t, ExprId) { return Expr(LLIL_EXPR); }
+		ExprId Load(size_t size, ExprId, uint32_t = 0) { return Expr(LLIL_EXPR, size); }
+		ExprId Store(size_t size, ExprId, ExprId, uint32_t = 0) { return Expr(LLIL_EXPR, size); }
+
+#define SINK_UNARY(name) ExprId name(size_t size, ExprId, uint32_t = 0) { return Expr(LLIL_EXPR, size); }
+#define SINK_BINARY(name) ExprId name(size_t size, ExprId, ExprId, uint32_t = 0) { return Expr(LLIL_EXPR, size); }
+		SINK_BINARY(Add)
+		SINK_BINARY(Sub)
+		SINK_BINARY(And)
+		SINK_BINARY(Or)
+		SINK_BINARY(Xor)
+		SINK_BINARY(ShiftLeft)
+		SINK_BINARY(LogicalShiftRight)
+		SINK_BINARY(RotateLeft)
+		SINK_BINARY(CompareEqual)
+		SINK_BINARY(CompareNotEqual)
+		SINK_BINARY(CompareSignedLessThan)
+		SINK_BINARY(CompareSignedGreaterThan)
+		SINK_BINARY(CompareUnsignedLessThan)
+		SINK_BINARY(CompareUnsignedGreaterThan)
+		SINK_BINARY(FloatAdd)
+		SINK_BINARY(FloatSub)
+		SINK_BINARY(FloatMult)
+		SINK_BINARY(FloatDiv)
+		SINK_BINARY(FloatCompareEqual)
+		SINK_BINARY(FloatCompareGreaterEqual)
+		SINK_BINARY(FloatCompareGreaterThan)
+		SINK_BINARY(FloatCompareLessThan)
+		SINK_BINARY(FloatCompareUnordered)
+		SINK_UNARY(Not)
+		SINK_UNARY(BoolToInt)
+		SINK_UNARY(LowPart)
+		SINK_UNARY(SignExtend)
+		SINK_UNARY(ZeroExtend)
+		SINK_UNARY(FloatAbs)
+		SINK_UNARY(FloatNeg)
+		SINK_UNARY(FloatSqrt)
+		SINK_UNARY(FloatConvert)
+		SINK_UNARY(FloatToInt)
+		SINK_UNARY(FloatTrunc)
+		SINK_UNARY(IntToFloat)
+		SINK_UNARY(RoundToInt)
+		SINK_UNARY(Ceil)
+		SINK_UNARY(Floor)
+#undef SINK_UNARY
+#undef SINK_BINARY
+
+		ExprId Intrinsic(const std::vector<RegisterOrFlag> &, uint32_t id, const std::vector<ExprId> &, uint32_t = 0) {
+			return Expr(LLIL_INTRINSIC, 0, id);
+		}
+
+		ExprId Jump(ExprId dest) { return Expr(LLIL_JUMP, 0, 0, dest); }
+		ExprId Call(ExprId dest) { return Expr(LLIL_CALL, 0, 0, dest); }
+		ExprId TailCall(ExprId dest) { return Expr(LLIL_TAILCALL, 0, 0, dest); }
+		ExprId Return(size_t dest) { return Expr(LLIL_RET, 0, 0, dest); }
+		ExprId Trap(int64_t num) { return Expr(LLIL_TRAP, 0, num); }
+		ExprId SystemCall() { return Expr(LLIL_SYSCALL); }
+		ExprId Unimplemented() { return Expr(LLIL_UNIMPL); }
+
+		ExprId If(ExprId cond, BNLowLevelILLabel &, BNLowLevelILLabel &) { return Expr(LLIL_IF, 0, 0, cond); }
+		ExprId Goto(BNLowLevelILLabel &) { return Expr(LLIL_GOTO); }
+	};
+}
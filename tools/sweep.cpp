@@ -0,0 +1,379 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Exhaustive encoding sweep.
+ *
+ * Runs every 32-bit word through the three per-instruction paths the
+ * architecture plugin exposes: instruction info (PpcDecoder::Decode), text
+ * (PpcTextFormatter) and IL (PpcLifter, built against the stand-in API in
+ * tools/ilsink). It reports words where the paths disagree on whether the
+ * word decodes or on its control flow, and the words that took longest.
+ *
+ * usage: ppc64-sweep [-j threads] [-s start] [-e end] [-k outliers] [-f]
+ *
+ * The range is [start, end) in words and defaults to all 2^32. -f lifts at
+ * the fast fidelity level. Exits with status 1 when any mismatch is found.
+ */
+
+#include "assembler.h"
+#include "decoder.h"
+#include "il.h"
+#include "text.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define SWEEP_ADDR 0x10000000
+#define SWEEP_CHUNK_WORDS (1 << 16)
+#define SWEEP_SAMPLES 8
+#define SWEEP_RETIME 16
+
+enum Mismatch {
+	MISMATCH_TEXT,		// text decodes iff the decoder accepts
+	MISMATCH_IL,		// IL lifts iff the decoder accepts
+	MISMATCH_IL_EMPTY,	// lifted without adding an instruction
+	MISMATCH_IL_PARTIAL,	// rejected after adding instructions
+	MISMATCH_BLOCK_END,	// info and IL disagree on fall-through
+	MISMATCH_CONDITION,	// info and IL disagree on a condition
+	MISMATCH_TARGET,	// IL does not reach the info branch target
+	MISMATCH_KIND,		// call/return/indirect kind differs
+	MISMATCH__COUNT,
+};
+
+static const char *mismatchNames[MISMATCH__COUNT] = {
+	"text-decode",
+	"il-decode",
+	"il-empty",
+	"il-partial",
+	"block-end",
+	"condition",
+	"target",
+	"kind",
+};
+
+struct Outlier {
+	uint64_t total;
+	uint32_t inst;
+	uint32_t info, text, il;	// nanoseconds per path
+
+	bool operator<(const Outlier &o) const { return total > o.total; }
+};
+
+struct Tally {
+	uint64_t words = 0;
+	uint64_t valid = 0;
+	uint64_t reserved = 0;
+	uint64_t mismatches[MISMATCH__COUNT] = {};
+	std::vector<uint32_t> samples[MISMATCH__COUNT];
+	// Min-heap on total, so the front is the cheapest kept outlier
+	std::vector<Outlier> slowest;
+};
+
+// Control flow of one lifted instruction, as the IL shows it
+struct IlShape {
+	std::vector<uint64_t> jumps;
+	std::vector<uint64_t> calls;
+	bool indirectJump = false;
+	bool indirectCall = false;
+	bool ret = false;
+	bool tailCall = false;
+	bool cond = false;
+	bool trap = false;
+
+	bool EndsBlock() const {
+		return !jumps.empty() || indirectJump || ret || tailCall || (trap && !cond);
+	}
+};
+
+static IlShape Shape(const LowLevelILFunction &il) {
+	IlShape s;
+	for (ExprId i : il.instructions) {
+		const SinkExpr &e = il.exprs[i];
+		bool direct = e.operand != BN_INVALID_EXPR && il.exprs[e.operand].operation == LLIL_CONST_PTR;
+		switch (e.operation) {
+		case LLIL_JUMP:
+			if (direct)
+				s.jumps.push_back(il.exprs[e.operand].value);
+			else
+				s.indirectJump = true;
+			break;
+		case LLIL_CALL:
+			if (direct)
+				s.calls.push_back(il.exprs[e.operand].value);
+			else
+				s.indirectCall = true;
+			break;
+		case LLIL_RET: s.ret = true; break;
+		case LLIL_TAILCALL: s.tailCall = true; break;
+		case LLIL_IF: s.cond = true; break;
+		case LLIL_TRAP: s.trap = true; break;
+		default: break;
+		}
+	}
+	return s;
+}
+
+static bool Contains(const std::vector<uint64_t> &v, uint64_t x) {
+	return std::find(v.begin(), v.end(), x) != v.end();
+}
+
+// Branch info against the IL, for a word every path accepted
+static void CheckControlFlow(uint32_t inst, uint32_t flags, const IlShape &s, bool mismatch[MISMATCH__COUNT]) {
+	bool ends = ((flags & INSN_BRANCH) && !(flags & INSN_CALL)) ||
+		(flags & (INSN_RETURN | INSN_INDIRECT | INSN_TRAP));
+	if (ends != s.EndsBlock())
+		mismatch[MISMATCH_BLOCK_END] = true;
+
+	if (flags & (INSN_BRANCH | INSN_RETURN | INSN_INDIRECT)) {
+		if (!!(flags & INSN_CONDITIONAL) != s.cond)
+			mismatch[MISMATCH_CONDITION] = true;
+	}
+
+	if (flags & INSN_BRANCH) {
+		uint64_t dst = PpcDecoder::BranchTarget(inst, SWEEP_ADDR);
+		if (flags & INSN_CALL) {
+			if (!Contains(s.calls, dst))
+				mismatch[MISMATCH_TARGET] = true;
+		} else if (!Contains(s.jumps, dst) ||
+			((flags & INSN_CONDITIONAL) && !Contains(s.jumps, SWEEP_ADDR + 4))) {
+			mismatch[MISMATCH_TARGET] = true;
+		}
+	} else if (!s.calls.empty() || !s.jumps.empty()) {
+		mismatch[MISMATCH_TARGET] = true;
+	}
+
+	if (!!(flags & INSN_RETURN) != s.ret || !!(flags & INSN_INDIRECT) != s.indirectJump || s.tailCall)
+		mismatch[MISMATCH_KIND] = true;
+}
+
+static uint32_t Elapsed(std::chrono::steady_clock::time_point &t) {
+	auto now = std::chrono::steady_clock::now();
+	uint32_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - t).count();
+	t = now;
+	return ns;
+}
+
+// Runs all three paths on one word. Returns the decoder's flags.
+static uint32_t RunWord(uint32_t inst, LiftFidelity fidelity, LowLevelILFunction &il, std::string &text,
+	bool &textOk, bool &ilOk, Outlier &time) {
+	uint8_t data[4];
+	WriteInstruction(data, inst);
+	auto t = std::chrono::steady_clock::now();
+
+	uint32_t flags = RECORD_FLAGS(PpcDecoder::Decode(inst, SWEEP_ADDR));
+	if (flags & INSN_BRANCH)
+		PpcDecoder::BranchTarget(inst, SWEEP_ADDR);
+	time.info = Elapsed(t);
+
+	text.clear();
+	PpcTextFormatter formatter(&text);
+	textOk = formatter.Format(data, SWEEP_ADDR);
+	time.text = Elapsed(t);
+
+	il.Clear();
+	PpcLifter lift(&il, nullptr, fidelity);
+	lift.SetWindow(data, 4);
+	ilOk = lift.LiftInstruction(data, SWEEP_ADDR);
+	time.il = Elapsed(t);
+
+	time.inst = inst;
+	time.total = (uint64_t)time.info + time.text + time.il;
+	return flags;
+}
+
+static void SweepChunk(uint64_t first, uint64_t count, LiftFidelity fidelity, size_t keep, Tally &tally) {
+	LowLevelILFunction il;
+	std::string text;
+	for (uint64_t w = first; w < first + count; w++) {
+		uint32_t inst = (uint32_t)w;
+		bool textOk, ilOk;
+		Outlier time;
+		uint32_t flags = RunWord(inst, fidelity, il, text, textOk, ilOk, time);
+		bool valid = flags & INSN_VALID;
+
+		bool mismatch[MISMATCH__COUNT] = {};
+		if (textOk != valid)
+			mismatch[MISMATCH_TEXT] = true;
+		if (ilOk != valid)
+			mismatch[MISMATCH_IL] = true;
+		if (ilOk && il.instructions.empty())
+			mismatch[MISMATCH_IL_EMPTY] = true;
+		if (!ilOk && !il.instructions.empty())
+			mismatch[MISMATCH_IL_PARTIAL] = true;
+		if (valid && ilOk)
+			CheckControlFlow(inst, flags, Shape(il), mismatch);
+
+		tally.words++;
+		tally.valid += valid;
+		tally.reserved += !!(flags & INSN_RESERVED);
+		for (size_t k = 0; k < MISMATCH__COUNT; k++) {
+			if (!mismatch[k])
+				continue;
+			tally.mismatches[k]++;
+			if (tally.samples[k].size() < SWEEP_SAMPLES)
+				tally.samples[k].push_back(inst);
+		}
+
+		if (tally.slowest.size() < keep) {
+			tally.slowest.push_back(time);
+			std::push_heap(tally.slowest.begin(), tally.slowest.end());
+		} else if (keep && time.total > tally.slowest.front().total) {
+			std::pop_heap(tally.slowest.begin(), tally.slowest.end());
+			tally.slowest.back() = time;
+			std::push_heap(tally.slowest.begin(), tally.slowest.end());
+		}
+	}
+}
+
+static void Merge(Tally &dst, const Tally &src, size_t keep) {
+	dst.words += src.words;
+	dst.valid += src.valid;
+	dst.reserved += src.reserved;
+	for (size_t k = 0; k < MISMATCH__COUNT; k++) {
+		dst.mismatches[k] += src.mismatches[k];
+		dst.samples[k].insert(dst.samples[k].end(), src.samples[k].begin(), src.samples[k].end());
+		std::sort(dst.samples[k].begin(), dst.samples[k].end());
+		if (dst.samples[k].size() > SWEEP_SAMPLES)
+			dst.samples[k].resize(SWEEP_SAMPLES);
+	}
+	for (const Outlier &o : src.slowest) {
+		if (dst.slowest.size() < keep) {
+			dst.slowest.push_back(o);
+			std::push_heap(dst.slowest.begin(), dst.slowest.end());
+		} else if (o.total > dst.slowest.front().total) {
+			std::pop_heap(dst.slowest.begin(), dst.slowest.end());
+			dst.slowest.back() = o;
+			std::push_heap(dst.slowest.begin(), dst.slowest.end());
+		}
+	}
+}
+
+// Outliers from the sweep include preemption and cache misses. Each one
+// is run again and keeps its fastest time, so what remains is the cost
+// of the encoding itself.
+static void Retime(std::vector<Outlier> &slowest, LiftFidelity fidelity) {
+	LowLevelILFunction il;
+	std::string text;
+	for (Outlier &o : slowest) {
+		Outlier best = o;
+		for (size_t i = 0; i < SWEEP_RETIME; i++) {
+			bool textOk, ilOk;
+			Outlier t;
+			RunWord(o.inst, fidelity, il, text, textOk, ilOk, t);
+			if (t.total < best.total)
+				best = t;
+		}
+		o = best;
+	}
+	std::sort(slowest.begin(), slowest.end());
+}
+
+static void Usage() {
+	fprintf(stderr, "usage: ppc64-sweep [-j threads] [-s start] [-e end] [-k outliers] [-f]\n");
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	uint64_t start = 0, end = 1ull << 32;
+	size_t keep = 32;
+	LiftFidelity fidelity = LiftFidelity::Precise;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-f") {
+			fidelity = LiftFidelity::Fast;
+			continue;
+		}
+		if (i + 1 >= argc)
+			Usage();
+		uint64_t v = strtoull(argv[++i], nullptr, 0);
+		if (arg == "-j")
+			threads = std::max<uint64_t>(v, 1);
+		else if (arg == "-s")
+			start = v;
+		else if (arg == "-e")
+			end = v;
+		else if (arg == "-k")
+			keep = v;
+		else
+			Usage();
+	}
+	if (end > (1ull << 32) || start >= end)
+		Usage();
+
+	uint64_t count = (end - start + SWEEP_CHUNK_WORDS - 1) / SWEEP_CHUNK_WORDS;
+	std::mutex lock;
+	std::atomic<uint64_t> done(0);
+	Tally total;
+	auto began = std::chrono::steady_clock::now();
+	{
+		ThreadPool pool(threads, false);
+		for (uint64_t c = 0; c < count; c++) {
+			pool.Enqueue([&, c]() {
+				uint64_t first = start + c * SWEEP_CHUNK_WORDS;
+				Tally part;
+				SweepChunk(first, std::min<uint64_t>(SWEEP_CHUNK_WORDS, end - first), fidelity, keep, part);
+				std::lock_guard<std::mutex> guard(lock);
+				Merge(total, part, keep);
+				done++;
+			});
+		}
+		while (done.load() < count) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			fprintf(stderr, "\r%5.1f%%", 100.0 * done.load() / count);
+		}
+		fprintf(stderr, "\n");
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+
+	printf("words     %llu in %.1fs on %zu threads\n", (unsigned long long)total.words, seconds, threads);
+	printf("valid     %llu\n", (unsigned long long)total.valid);
+	printf("reserved  %llu\n", (unsigned long long)total.reserved);
+
+	uint64_t mismatches = 0;
+	for (size_t k = 0; k < MISMATCH__COUNT; k++) {
+		mismatches += total.mismatches[k];
+		if (!total.mismatches[k])
+			continue;
+		printf("mismatch  %-12s %llu:", mismatchNames[k], (unsigned long long)total.mismatches[k]);
+		for (uint32_t inst : total.samples[k])
+			printf(" %08x", inst);
+		printf("\n");
+	}
+
+	Retime(total.slowest, fidelity);
+	printf("slowest   (ns: info text il)\n");
+	for (const Outlier &o : total.slowest) {
+		uint8_t data[4];
+		std::string text;
+		WriteInstruction(data, o.inst);
+		PpcTextFormatter formatter(&text);
+		if (!formatter.Format(data, SWEEP_ADDR))
+			text = ".long";
+		printf("  %08x %6u %6u %6u  %s\n", o.inst, o.info, o.text, o.il, text.c_str());
+	}
+	return mismatches ? 1 : 0;
+}
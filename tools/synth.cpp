@@ -0,0 +1,406 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Synthetic instruction streams for benchmarking.
+ *
+ * "learn" reads the executable sections of big-endian PPC64 ELF files and
+ * counts, per opcode class (primary plus extended opcode), how often each
+ * value of each operand field occurs, along with primary-to-primary
+ * transitions and relative branch distances. The model holds only these
+ * counts, never instruction sequences.
+ *
+ * "gen" walks the transitions from the model with a seeded generator and
+ * composes each word from the learned field distributions. Words the
+ * decoder rejects or flags as reserved are drawn again. Branches get a
+ * learned distance, kept inside the blob. The same model, size and seed
+ * always produce the same bytes.
+ *
+ * usage: ppc64-synth learn model.txt file.elf...
+ *        ppc64-synth gen model.txt bytes seed out.bin
+ */
+
+#include "assembler.h"
+#include "decoder.h"
+#include "vector.h"
+
+#include "decode_macros.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#define SYNTH_MODEL_VERSION 1
+#define SYNTH_VECTOR_CLASS 0x10000
+#define SYNTH_DISP_BUCKETS 26	// log2 of the distance, LI reaches 2^25
+#define SYNTH_RETRIES 32
+#define SYNTH_NOP 0x60000000
+
+#define EM_PPC64 21
+#define SHF_EXECINSTR 0x4
+#define SHT_PROGBITS 1
+
+/* Model */
+
+// Operand fields: bits 21-25, 16-20, 11-15 and 0-10
+static const uint32_t fieldShift[] = {21, 16, 11, 0};
+static const uint32_t fieldBins[] = {32, 32, 32, 2048};
+#define SYNTH_FIELDS 4
+
+struct SynthClass {
+	uint64_t count = 0;
+	std::vector<uint64_t> fields[SYNTH_FIELDS];
+
+	SynthClass() {
+		for (size_t f = 0; f < SYNTH_FIELDS; f++)
+			fields[f].resize(fieldBins[f]);
+	}
+};
+
+struct SynthModel {
+	uint64_t transitions[64][64] = {};
+	// Keyed by primary << 20 | extended opcode, see ClassKey
+	std::map<uint32_t, SynthClass> classes;
+	// Relative branch distances for b (0) and bc (1): [sign][log2]
+	uint64_t disp[2][2][SYNTH_DISP_BUCKETS] = {};
+};
+
+// Vector instructions are classed by their table entry, everything else
+// by the extended opcode field its primary uses.
+static uint32_t ClassKey(uint32_t inst) {
+	uint32_t primary = inst >> 26;
+	uint32_t xo = 0;
+	const VecOpcode *vec = VecLookup(inst);
+	if (vec) {
+		xo = SYNTH_VECTOR_CLASS | VecOpcodeIndex(*vec);
+	} else {
+		switch (primary) {
+		case 19:
+		case 31:
+			xo = (inst >> 1) & 0x3ff;
+			break;
+		case 59:
+		case 63:
+			xo = AFORM_XO(inst) >= 18 ? AFORM_XO(inst) : (inst >> 1) & 0x3ff;
+			break;
+		case 30:
+			xo = MDSFORM_XO(inst);
+			break;
+		case 58:
+		case 62:
+			xo = inst & 3;
+			break;
+		default:
+			break;
+		}
+	}
+	return (primary << 20) | xo;
+}
+
+static uint32_t Log2(uint64_t v) {
+	uint32_t n = 0;
+	while (v >>= 1)
+		n++;
+	return n;
+}
+
+static void LearnWords(SynthModel &m, const uint8_t *data, size_t len, uint64_t addr) {
+	uint32_t prev = 64;
+	for (size_t off = 0; off + 4 <= len; off += 4) {
+		uint32_t inst = ReadInstruction(data + off);
+		uint64_t rec = PpcDecoder::Decode(inst, addr + off);
+		if (PpcDecoder::Rejected(rec) || (RECORD_FLAGS(rec) & INSN_RESERVED)) {
+			// Data in the code section breaks the chain
+			prev = 64;
+			continue;
+		}
+		uint32_t primary = inst >> 26;
+		if (prev < 64)
+			m.transitions[prev][primary]++;
+		prev = primary;
+
+		SynthClass &c = m.classes[ClassKey(inst)];
+		c.count++;
+		for (size_t f = 0; f < SYNTH_FIELDS; f++)
+			c.fields[f][(inst >> fieldShift[f]) & (fieldBins[f] - 1)]++;
+
+		if ((primary == 16 || primary == 18) && !(inst & 2)) {
+			int64_t d = PpcDecoder::BranchTarget(inst, addr + off) - (addr + off);
+			uint64_t mag = d < 0 ? -d : d;
+			if (mag)
+				m.disp[primary == 16][d < 0][std::min<uint32_t>(Log2(mag), SYNTH_DISP_BUCKETS - 1)]++;
+		}
+	}
+}
+
+template <typename T>
+static T Get(const uint8_t *p, size_t size) {
+	T v = 0;
+	for (size_t i = 0; i < size; i++)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+// Executable PROGBITS sections of a big-endian ELF64 PPC64 file
+static bool LearnElf(SynthModel &m, const char *path) {
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		fprintf(stderr, "%s: cannot open\n", path);
+		return false;
+	}
+	std::vector<uint8_t> file;
+	uint8_t buf[65536];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		file.insert(file.end(), buf, buf + n);
+	fclose(f);
+
+	const uint8_t *d = file.data();
+	if (file.size() < 64 || memcmp(d, "\x7f" "ELF", 4) || d[4] != 2 || d[5] != 2 || Get<uint16_t>(d + 18, 2) != EM_PPC64) {
+		fprintf(stderr, "%s: not a big-endian PPC64 ELF file\n", path);
+		return false;
+	}
+	uint64_t shoff = Get<uint64_t>(d + 40, 8);
+	uint16_t shentsize = Get<uint16_t>(d + 58, 2);
+	uint16_t shnum = Get<uint16_t>(d + 60, 2);
+	size_t sections = 0;
+	for (uint16_t i = 0; i < shnum; i++) {
+		uint64_t sh = shoff + (uint64_t)i * shentsize;
+		if (shentsize < 64 || sh + 64 > file.size())
+			break;
+		uint32_t type = Get<uint32_t>(d + sh + 4, 4);
+		uint64_t flags = Get<uint64_t>(d + sh + 8, 8);
+		uint64_t addr = Get<uint64_t>(d + sh + 16, 8);
+		uint64_t off = Get<uint64_t>(d + sh + 24, 8);
+		uint64_t size = Get<uint64_t>(d + sh + 32, 8);
+		if (type != SHT_PROGBITS || !(flags & SHF_EXECINSTR) || off > file.size() || size > file.size() - off)
+			continue;
+		LearnWords(m, d + off, size, addr);
+		sections++;
+	}
+	fprintf(stderr, "%s: %zu code sections\n", path, sections);
+	return true;
+}
+
+static bool SaveModel(const SynthModel &m, const char *path) {
+	FILE *f = fopen(path, "w");
+	if (!f)
+		return false;
+	fprintf(f, "ppc64-synth %d\n", SYNTH_MODEL_VERSION);
+	for (uint32_t a = 0; a < 64; a++)
+		for (uint32_t b = 0; b < 64; b++)
+			if (m.transitions[a][b])
+				fprintf(f, "next %u %u %llu\n", a, b, (unsigned long long)m.transitions[a][b]);
+	for (auto &it : m.classes) {
+		fprintf(f, "class %x %llu\n", it.first, (unsigned long long)it.second.count);
+		for (size_t fi = 0; fi < SYNTH_FIELDS; fi++)
+			for (size_t bin = 0; bin < fieldBins[fi]; bin++)
+				if (it.second.fields[fi][bin])
+					fprintf(f, "field %zu %zu %llu\n", fi, bin, (unsigned long long)it.second.fields[fi][bin]);
+	}
+	for (size_t k = 0; k < 2; k++)
+		for (size_t s = 0; s < 2; s++)
+			for (size_t b = 0; b < SYNTH_DISP_BUCKETS; b++)
+				if (m.disp[k][s][b])
+					fprintf(f, "disp %zu %zu %zu %llu\n", k, s, b, (unsigned long long)m.disp[k][s][b]);
+	return fclose(f) == 0;
+}
+
+static bool LoadModel(SynthModel &m, const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f)
+		return false;
+	char line[256];
+	int version = 0;
+	SynthClass *c = nullptr;
+	bool ok = fgets(line, sizeof(line), f) && sscanf(line, "ppc64-synth %d", &version) == 1 && version == SYNTH_MODEL_VERSION;
+	while (ok && fgets(line, sizeof(line), f)) {
+		unsigned a, b, k;
+		unsigned long long n;
+		if (sscanf(line, "next %u %u %llu", &a, &b, &n) == 3 && a < 64 && b < 64) {
+			m.transitions[a][b] = n;
+		} else if (sscanf(line, "class %x %llu", &a, &n) == 2) {
+			c = &m.classes[a];
+			c->count = n;
+		} else if (sscanf(line, "field %u %u %llu", &a, &b, &n) == 3 && c && a < SYNTH_FIELDS && b < fieldBins[a]) {
+			c->fields[a][b] = n;
+		} else if (sscanf(line, "disp %u %u %u %llu", &k, &a, &b, &n) == 4 && k < 2 && a < 2 && b < SYNTH_DISP_BUCKETS) {
+			m.disp[k][a][b] = n;
+		} else {
+			ok = false;
+		}
+	}
+	fclose(f);
+	return ok;
+}
+
+/* Generation */
+
+// splitmix64, so output doesn't depend on the standard library
+struct SynthRandom {
+	uint64_t state;
+
+	uint64_t Next() {
+		uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	uint64_t Below(uint64_t n) {
+		return n ? Next() % n : 0;
+	}
+};
+
+// Index drawn in proportion to counts; returns n when all are zero
+static size_t Pick(SynthRandom &rng, const uint64_t *counts, size_t n) {
+	uint64_t total = 0;
+	for (size_t i = 0; i < n; i++)
+		total += counts[i];
+	if (!total)
+		return n;
+	uint64_t r = rng.Below(total);
+	for (size_t i = 0; i < n; i++) {
+		if (r < counts[i])
+			return i;
+		r -= counts[i];
+	}
+	return n;
+}
+
+// Classes of one primary with cumulative counts, for drawing
+struct PrimaryClasses {
+	std::vector<const SynthClass *> classes;
+	std::vector<uint64_t> counts;
+};
+
+// A learned distance, pointed back into [0, len) when it would leave
+static uint32_t PlaceBranch(SynthRandom &rng, const SynthModel &m, uint32_t inst, uint64_t off, uint64_t len) {
+	bool bc = (inst >> 26) == 16;
+	uint64_t buckets[2 * SYNTH_DISP_BUCKETS];
+	memcpy(buckets, m.disp[bc][0], sizeof(m.disp[bc][0]));
+	memcpy(buckets + SYNTH_DISP_BUCKETS, m.disp[bc][1], sizeof(m.disp[bc][1]));
+	size_t b = Pick(rng, buckets, 2 * SYNTH_DISP_BUCKETS);
+	if (b == 2 * SYNTH_DISP_BUCKETS)
+		return inst;
+	bool backward = b >= SYNTH_DISP_BUCKETS;
+	uint32_t bits = b % SYNTH_DISP_BUCKETS;
+	uint64_t mag = ((1ull << bits) + rng.Below(1ull << bits)) & ~3ull;
+	if (!mag)
+		mag = 4;
+	if (backward && mag > off)
+		backward = false;
+	if (!backward && off + mag >= len)
+		backward = mag <= off;
+	if (!backward && off + mag >= len)
+		mag = (len - off - 4) & ~3ull;
+	int64_t d = backward ? -(int64_t)mag : (int64_t)mag;
+	if (bc) {
+		if (d < -0x8000 || d > 0x7ffc)
+			d = (d % 0x8000) & ~3ll;
+		return (inst & ~0xfffcu) | ((uint32_t)d & 0xfffc);
+	}
+	return (inst & ~0x3fffffcu) | ((uint32_t)d & 0x3fffffc);
+}
+
+static bool Generate(const SynthModel &m, uint64_t len, uint64_t seed, std::vector<uint8_t> &out) {
+	PrimaryClasses byPrimary[64];
+	uint64_t primaryCounts[64] = {};
+	for (auto &it : m.classes) {
+		uint32_t p = it.first >> 20;
+		byPrimary[p].classes.push_back(&it.second);
+		byPrimary[p].counts.push_back(it.second.count);
+		primaryCounts[p] += it.second.count;
+	}
+
+	SynthRandom rng = {seed};
+	len &= ~3ull;
+	out.assign(len, 0);
+	size_t primary = Pick(rng, primaryCounts, 64);
+	if (primary == 64)
+		return false;
+	for (uint64_t off = 0; off < len; off += 4) {
+		uint32_t inst = SYNTH_NOP;
+		const PrimaryClasses &pc = byPrimary[primary];
+		size_t ci = Pick(rng, pc.counts.data(), pc.counts.size());
+		for (size_t attempt = 0; ci < pc.counts.size() && attempt < SYNTH_RETRIES; attempt++) {
+			const SynthClass &c = *pc.classes[ci];
+			uint32_t word = primary << 26;
+			for (size_t f = 0; f < SYNTH_FIELDS; f++)
+				word |= Pick(rng, c.fields[f].data(), fieldBins[f]) << fieldShift[f];
+			if ((primary == 16 || primary == 18) && !(word & 2))
+				word = PlaceBranch(rng, m, word, off, len);
+			uint64_t rec = PpcDecoder::Decode(word, off);
+			if (!PpcDecoder::Rejected(rec) && !(RECORD_FLAGS(rec) & INSN_RESERVED)) {
+				inst = word;
+				break;
+			}
+		}
+		WriteInstruction(out.data() + off, inst);
+
+		size_t next = Pick(rng, m.transitions[primary], 64);
+		primary = next < 64 ? next : Pick(rng, primaryCounts, 64);
+	}
+	return true;
+}
+
+static void Usage() {
+	fprintf(stderr, "usage: ppc64-synth learn model.txt file.elf...\n");
+	fprintf(stderr, "       ppc64-synth gen model.txt bytes seed out.bin\n");
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	if (argc < 4)
+		Usage();
+	std::string cmd = argv[1];
+	SynthModel *m = new SynthModel;
+
+	if (cmd == "learn") {
+		for (int i = 3; i < argc; i++) {
+			if (!LearnElf(*m, argv[i]))
+				return 1;
+		}
+		if (!SaveModel(*m, argv[2])) {
+			fprintf(stderr, "%s: cannot write\n", argv[2]);
+			return 1;
+		}
+		fprintf(stderr, "%zu opcode classes\n", m->classes.size());
+		return 0;
+	}
+
+	if (cmd != "gen" || argc != 6)
+		Usage();
+	if (!LoadModel(*m, argv[2])) {
+		fprintf(stderr, "%s: not a ppc64-synth model\n", argv[2]);
+		return 1;
+	}
+	std::vector<uint8_t> out;
+	if (!Generate(*m, strtoull(argv[3], nullptr, 0), strtoull(argv[4], nullptr, 0), out)) {
+		fprintf(stderr, "%s: model is empty\n", argv[2]);
+		return 1;
+	}
+	FILE *f = fopen(argv[5], "wb");
+	if (!f || fwrite(out.data(), 1, out.size(), f) != out.size() || fclose(f) != 0) {
+		fprintf(stderr, "%s: cannot write\n", argv[5]);
+		return 1;
+	}
+	return 0;
+}
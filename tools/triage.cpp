@@ -0,0 +1,615 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Headless corpus triage.
+ *
+ * Walks the given files and directories and, for every ELF or raw image,
+ * writes one JSON line with per-primary opcode counts, branch, call and
+ * return counts, the share of words the decoder rejects and an estimate
+ * of the number of functions. Only the standalone decoder is used.
+ *
+ * usage: ppc64-triage [-j threads] [-c chunk] [-b base] path... > out.jsonl
+ *
+ * Big-endian ELF32/ELF64 PowerPC files are scanned over their executable
+ * sections (or executable segments when there are no section headers).
+ * Anything else is scanned whole as raw code at -b (default 0).
+ *
+ * Each worker owns a deque of tasks. Files are dealt out round-robin. A
+ * worker that opens an image pushes the image's chunks (-c bytes, default
+ * 1 MiB) onto its own deque and works through them newest first, while
+ * idle workers steal from the oldest end: unopened files first, then
+ * chunks of images that are still in flight. Images are mapped, not read,
+ * so a worker holds one chunk's tally plus a bitmap of function starts
+ * per open image, one bit per code word.
+ */
+
+#include "decoder.h"
+#include "json.h"
+
+#include "decode_macros.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TRIAGE_CHUNK (1 << 20)
+#define TRIAGE_IDLE_US 100
+
+#define EM_PPC 20
+#define EM_PPC64 21
+#define SHF_EXECINSTR 0x4
+#define SHT_PROGBITS 1
+#define PT_LOAD 1
+#define PF_X 0x1
+
+#define MFLR_R0 0x7c0802a6
+#define NOP 0x60000000
+
+/* Images */
+
+// addis r2,r12,n
+static bool IsGlobalEntry(uint32_t inst) {
+	return (inst & 0xffff0000) == 0x3c4c0000;
+}
+
+struct CodeRange {
+	uint64_t addr;
+	uint64_t offset;	// in the file
+	uint64_t size;
+	size_t firstWord;	// index of the range's first word in the start bitmap
+};
+
+struct ImageTally {
+	uint64_t words = 0;
+	uint64_t invalid = 0;
+	uint64_t reserved = 0;
+	uint64_t branches = 0;		// direct jumps, conditional or not
+	uint64_t conditional = 0;	// conditional branches, returns and calls
+	uint64_t calls = 0;		// bl, bcl
+	uint64_t indirectCalls = 0;	// bctrl, blrl
+	uint64_t returns = 0;
+	uint64_t indirect = 0;		// bctr
+	uint64_t traps = 0;
+	uint64_t opcodes[64] = {};
+
+	void Add(const ImageTally &o) {
+		words += o.words;
+		invalid += o.invalid;
+		reserved += o.reserved;
+		branches += o.branches;
+		conditional += o.conditional;
+		calls += o.calls;
+		indirectCalls += o.indirectCalls;
+		returns += o.returns;
+		indirect += o.indirect;
+		traps += o.traps;
+		for (size_t i = 0; i < 64; i++)
+			opcodes[i] += o.opcodes[i];
+	}
+};
+
+struct Image {
+	std::string path;
+	const char *format = "raw";
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+	std::vector<CodeRange> ranges;
+	std::chrono::steady_clock::time_point opened;
+
+	// Estimated function starts, one bit per code word
+	std::unique_ptr<std::atomic<uint64_t>[]> starts;
+	size_t startWords = 0;
+
+	std::mutex lock;
+	ImageTally tally;
+	std::atomic<size_t> chunksLeft{0};
+
+	~Image() {
+		if (data)
+			munmap(const_cast<uint8_t *>(data), size);
+	}
+
+	const CodeRange *Locate(uint64_t addr) const {
+		if (addr & 3)
+			return nullptr;
+		for (const CodeRange &r : ranges) {
+			if (addr >= r.addr && addr - r.addr < r.size)
+				return &r;
+		}
+		return nullptr;
+	}
+
+	void MarkStart(uint64_t addr) {
+		const CodeRange *r = Locate(addr);
+		if (!r)
+			return;
+		size_t bit = r->firstWord + (addr - r->addr) / 4;
+		starts[bit / 64].fetch_or(1ull << (bit % 64), std::memory_order_relaxed);
+	}
+
+	// Calls reach ELFv2 functions at their local entry, two words past
+	// the global entry the prologue scan finds.
+	void MarkCallTarget(uint64_t addr) {
+		const CodeRange *r = Locate(addr - 8);
+		if (r && addr - r->addr < r->size && IsGlobalEntry(ReadInstruction(data + r->offset + addr - 8 - r->addr)))
+			addr -= 8;
+		MarkStart(addr);
+	}
+
+	uint64_t CountStarts() const {
+		uint64_t n = 0;
+		for (size_t i = 0; i < (startWords + 63) / 64; i++)
+			n += __builtin_popcountll(starts[i].load(std::memory_order_relaxed));
+		return n;
+	}
+};
+
+template <typename T>
+static T Get(const uint8_t *p, size_t n) {
+	T v = 0;
+	for (size_t i = 0; i < n; i++)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+static void AddRange(Image &img, uint64_t addr, uint64_t off, uint64_t size) {
+	if (off > img.size || size > img.size - off)
+		return;
+	size &= ~3ull;
+	if (size)
+		img.ranges.push_back({addr, off, size, 0});
+}
+
+// Executable sections, or PF_X segments when there are none. Returns
+// false for ELF files of other machines or byte orders.
+static bool ParseElf(Image &img, std::string &error) {
+	const uint8_t *d = img.data;
+	bool wide = d[4] == 2;
+	uint16_t machine = Get<uint16_t>(d + 18, 2);
+	if (d[5] != 2 || (d[4] != 1 && d[4] != 2) || (machine != EM_PPC && machine != EM_PPC64)) {
+		error = "not a big-endian PowerPC ELF file";
+		return false;
+	}
+	img.format = wide ? "elf64" : "elf32";
+	if (img.size < (wide ? 64u : 52u)) {
+		error = "truncated ELF header";
+		return false;
+	}
+
+	uint64_t shoff = wide ? Get<uint64_t>(d + 40, 8) : Get<uint32_t>(d + 32, 4);
+	uint16_t shentsize = Get<uint16_t>(d + (wide ? 58 : 46), 2);
+	uint16_t shnum = Get<uint16_t>(d + (wide ? 60 : 48), 2);
+	size_t need = wide ? 64 : 40;
+	for (uint16_t i = 0; i < shnum && shentsize >= need; i++) {
+		uint64_t sh = shoff + (uint64_t)i * shentsize;
+		if (sh > img.size || img.size - sh < need)
+			break;
+		const uint8_t *s = d + sh;
+		uint32_t type = Get<uint32_t>(s + 4, 4);
+		uint64_t flags = wide ? Get<uint64_t>(s + 8, 8) : Get<uint32_t>(s + 8, 4);
+		if (type != SHT_PROGBITS || !(flags & SHF_EXECINSTR))
+			continue;
+		if (wide)
+			AddRange(img, Get<uint64_t>(s + 16, 8), Get<uint64_t>(s + 24, 8), Get<uint64_t>(s + 32, 8));
+		else
+			AddRange(img, Get<uint32_t>(s + 12, 4), Get<uint32_t>(s + 16, 4), Get<uint32_t>(s + 20, 4));
+	}
+	if (!img.ranges.empty())
+		return true;
+
+	uint64_t phoff = wide ? Get<uint64_t>(d + 32, 8) : Get<uint32_t>(d + 28, 4);
+	uint16_t phentsize = Get<uint16_t>(d + (wide ? 54 : 42), 2);
+	uint16_t phnum = Get<uint16_t>(d + (wide ? 56 : 44), 2);
+	need = wide ? 56 : 32;
+	for (uint16_t i = 0; i < phnum && phentsize >= need; i++) {
+		uint64_t ph = phoff + (uint64_t)i * phentsize;
+		if (ph > img.size || img.size - ph < need)
+			break;
+		const uint8_t *p = d + ph;
+		if (Get<uint32_t>(p, 4) != PT_LOAD)
+			continue;
+		if (wide) {
+			if (Get<uint32_t>(p + 4, 4) & PF_X)
+				AddRange(img, Get<uint64_t>(p + 16, 8), Get<uint64_t>(p + 8, 8), Get<uint64_t>(p + 32, 8));
+		} else {
+			if (Get<uint32_t>(p + 24, 4) & PF_X)
+				AddRange(img, Get<uint32_t>(p + 8, 4), Get<uint32_t>(p + 4, 4), Get<uint32_t>(p + 16, 4));
+		}
+	}
+	return true;
+}
+
+static bool OpenImage(Image &img, uint64_t base, std::string &error) {
+	int fd = open(img.path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		error = "cannot open";
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < 4) {
+		close(fd);
+		error = "too small";
+		return false;
+	}
+	void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		error = "cannot map";
+		return false;
+	}
+	img.data = static_cast<const uint8_t *>(map);
+	img.size = st.st_size;
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	if (img.size >= 20 && memcmp(img.data, "\x7f" "ELF", 4) == 0) {
+		if (!ParseElf(img, error))
+			return false;
+	} else {
+		AddRange(img, base, 0, img.size);
+	}
+
+	size_t words = 0;
+	for (CodeRange &r : img.ranges) {
+		r.firstWord = words;
+		words += r.size / 4;
+	}
+	img.startWords = words;
+	img.starts.reset(new std::atomic<uint64_t>[(words + 63) / 64]);
+	for (size_t i = 0; i < (words + 63) / 64; i++)
+		img.starts[i].store(0, std::memory_order_relaxed);
+	return true;
+}
+
+/* Scanning */
+
+// Words that end a block with no fall-through, or pad between functions
+static bool EndsFunction(uint32_t inst, uint32_t flags) {
+	if (inst == 0 || inst == NOP)
+		return true;
+	if (!(flags & INSN_VALID) || (flags & (INSN_CONDITIONAL | INSN_CALL)))
+		return false;
+	return flags & (INSN_BRANCH | INSN_RETURN | INSN_INDIRECT | INSN_TRAP);
+}
+
+// mflr r0, stdu/stwu r1,-n(r1) or an ELFv2 global entry (addis r2,r12,n)
+static bool LooksLikePrologue(uint32_t inst) {
+	if (inst == MFLR_R0)
+		return true;
+	if ((inst & 0xffff8003) == 0xf8218001)
+		return true;
+	if ((inst & 0xffff8000) == 0x94218000)
+		return true;
+	return IsGlobalEntry(inst);
+}
+
+static void ScanChunk(Image &img, const CodeRange &r, uint64_t off, uint64_t len, ImageTally &t) {
+	const uint8_t *base = img.data + r.offset;
+	// The word before the chunk, or a block end at the start of the range
+	uint32_t prev = NOP, prevFlags = INSN_VALID;
+	if (off >= 4) {
+		prev = ReadInstruction(base + off - 4);
+		prevFlags = RECORD_FLAGS(PpcDecoder::Decode(prev, r.addr + off - 4));
+	}
+
+	for (uint64_t o = off; o < off + len; o += 4) {
+		uint32_t inst = ReadInstruction(base + o);
+		uint64_t pc = r.addr + o;
+		uint32_t primary = inst >> 26;
+		uint32_t flags = RECORD_FLAGS(PpcDecoder::Decode(inst, pc));
+		t.words++;
+		t.opcodes[primary]++;
+
+		if (!(flags & INSN_VALID)) {
+			t.invalid++;
+		} else {
+			if (flags & INSN_RESERVED)
+				t.reserved++;
+			if (flags & INSN_CONDITIONAL)
+				t.conditional++;
+			if (flags & INSN_BRANCH) {
+				if (flags & INSN_CALL) {
+					t.calls++;
+					img.MarkCallTarget(PpcDecoder::BranchTarget(inst, pc));
+				} else {
+					t.branches++;
+				}
+			} else if (flags & INSN_RETURN) {
+				t.returns++;
+			} else if (flags & INSN_INDIRECT) {
+				t.indirect++;
+			} else if (flags & INSN_TRAP) {
+				t.traps++;
+			} else if (primary == 19 && (inst & 1)) {
+				// bclrl/bcctrl carry no record flags; they are calls
+				uint32_t xo = (inst >> 1) & 0x3ff;
+				if (xo == 16 || xo == 528)
+					t.indirectCalls++;
+			}
+			if (LooksLikePrologue(inst) && EndsFunction(prev, prevFlags))
+				img.MarkStart(pc);
+		}
+		prev = inst;
+		prevFlags = flags;
+	}
+}
+
+/* Scheduling */
+
+struct Task {
+	std::string path;		// set for a file not opened yet
+	std::shared_ptr<Image> image;	// set for a chunk
+	size_t range = 0;
+	uint64_t offset = 0;
+	uint64_t length = 0;
+};
+
+class StealPool {
+private:
+	struct Worker {
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+	std::vector<std::unique_ptr<Worker>> workers;
+	// Queued plus running tasks; workers exit when it reaches zero
+	std::atomic<size_t> pending{0};
+
+public:
+	StealPool(size_t threads) {
+		for (size_t i = 0; i < threads; i++)
+			workers.emplace_back(new Worker());
+	}
+
+	size_t Size() const { return workers.size(); }
+
+	void Push(size_t worker, Task task) {
+		pending++;
+		Worker &w = *workers[worker];
+		std::lock_guard<std::mutex> guard(w.lock);
+		w.tasks.push_back(std::move(task));
+	}
+
+	// Own work newest first, then the oldest task of the other workers
+	bool Take(size_t worker, Task &task) {
+		{
+			Worker &w = *workers[worker];
+			std::lock_guard<std::mutex> guard(w.lock);
+			if (!w.tasks.empty()) {
+				task = std::move(w.tasks.back());
+				w.tasks.pop_back();
+				return true;
+			}
+		}
+		for (size_t i = 1; i < workers.size(); i++) {
+			Worker &v = *workers[(worker + i) % workers.size()];
+			std::lock_guard<std::mutex> guard(v.lock);
+			if (!v.tasks.empty()) {
+				task = std::move(v.tasks.front());
+				v.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Done() {
+		pending--;
+	}
+
+	bool Idle() const {
+		return pending.load() == 0;
+	}
+};
+
+/* Output */
+
+static std::mutex outputLock;
+
+static void WriteError(const std::string &path, const std::string &error) {
+	std::lock_guard<std::mutex> guard(outputLock);
+	printf("{\"path\":%s,\"error\":%s}\n", PpcJsonString(path).c_str(), PpcJsonString(error).c_str());
+}
+
+static void WriteImage(Image &img) {
+	const ImageTally &t = img.tally;
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - img.opened).count();
+	uint64_t codeBytes = 0;
+	for (const CodeRange &r : img.ranges)
+		codeBytes += r.size;
+
+	std::string opcodes;
+	for (size_t i = 0; i < 64; i++) {
+		opcodes += i ? "," : "";
+		opcodes += std::to_string(t.opcodes[i]);
+	}
+	std::lock_guard<std::mutex> guard(outputLock);
+	printf("{\"path\":%s,\"format\":\"%s\",\"bytes\":%zu,\"codeBytes\":%llu,\"ranges\":%zu,"
+		"\"words\":%llu,\"invalid\":%llu,\"invalidRatio\":%.6f,\"reserved\":%llu,"
+		"\"branches\":%llu,\"conditional\":%llu,\"calls\":%llu,\"indirectCalls\":%llu,"
+		"\"returns\":%llu,\"indirect\":%llu,\"traps\":%llu,\"functionStarts\":%llu,"
+		"\"opcodes\":[%s],\"seconds\":%.3f}\n",
+		PpcJsonString(img.path).c_str(), img.format, img.size, (unsigned long long)codeBytes, img.ranges.size(),
+		(unsigned long long)t.words, (unsigned long long)t.invalid, t.words ? (double)t.invalid / t.words : 0.0,
+		(unsigned long long)t.reserved, (unsigned long long)t.branches, (unsigned long long)t.conditional,
+		(unsigned long long)t.calls, (unsigned long long)t.indirectCalls, (unsigned long long)t.returns,
+		(unsigned long long)t.indirect, (unsigned long long)t.traps, (unsigned long long)img.CountStarts(),
+		opcodes.c_str(), seconds);
+}
+
+/* Driver */
+
+static std::atomic<uint64_t> imagesDone(0);
+static std::atomic<uint64_t> bytesDone(0);
+
+static void RunTask(StealPool &pool, size_t worker, Task &task, uint64_t chunk, uint64_t base) {
+	if (!task.image) {
+		auto img = std::make_shared<Image>();
+		img->path = task.path;
+		img->opened = std::chrono::steady_clock::now();
+		std::string error;
+		if (!OpenImage(*img, base, error)) {
+			WriteError(img->path, error);
+			imagesDone++;
+			return;
+		}
+		size_t count = 0;
+		for (const CodeRange &r : img->ranges)
+			count += (r.size + chunk - 1) / chunk;
+		if (count == 0) {
+			WriteImage(*img);
+			imagesDone++;
+			return;
+		}
+		img->chunksLeft.store(count);
+		// Pushed last to first so this worker takes them in address order
+		for (size_t i = img->ranges.size(); i-- > 0;) {
+			const CodeRange &r = img->ranges[i];
+			for (uint64_t off = (r.size - 1) / chunk * chunk;; off -= chunk) {
+				Task t;
+				t.image = img;
+				t.range = i;
+				t.offset = off;
+				t.length = std::min<uint64_t>(chunk, r.size - off);
+				pool.Push(worker, std::move(t));
+				if (off == 0)
+					break;
+			}
+		}
+		return;
+	}
+
+	Image &img = *task.image;
+	ImageTally part;
+	ScanChunk(img, img.ranges[task.range], task.offset, task.length, part);
+	bytesDone += task.length;
+	{
+		std::lock_guard<std::mutex> guard(img.lock);
+		img.tally.Add(part);
+	}
+	if (img.chunksLeft.fetch_sub(1) == 1) {
+		WriteImage(img);
+		imagesDone++;
+	}
+}
+
+static void Collect(const std::string &path, std::vector<std::string> &files) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0) {
+		WriteError(path, "cannot stat");
+		return;
+	}
+	if (S_ISREG(st.st_mode)) {
+		files.push_back(path);
+		return;
+	}
+	if (!S_ISDIR(st.st_mode))
+		return;
+	DIR *dir = opendir(path.c_str());
+	if (!dir) {
+		WriteError(path, "cannot open directory");
+		return;
+	}
+	std::vector<std::string> names;
+	while (struct dirent *e = readdir(dir)) {
+		if (strcmp(e->d_name, ".") && strcmp(e->d_name, ".."))
+			names.push_back(e->d_name);
+	}
+	closedir(dir);
+	std::sort(names.begin(), names.end());
+	for (const std::string &name : names)
+		Collect(path + "/" + name, files);
+}
+
+static void Usage() {
+	fprintf(stderr, "usage: ppc64-triage [-j threads] [-c chunk] [-b base] path...\n");
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	uint64_t chunk = TRIAGE_CHUNK;
+	uint64_t base = 0;
+	std::vector<std::string> files;
+
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+			Usage();
+		uint64_t v = strtoull(argv[++i], nullptr, 0);
+		if (arg == "-j")
+			threads = std::max<uint64_t>(v, 1);
+		else if (arg == "-c")
+			chunk = std::max<uint64_t>(v & ~3ull, 4);
+		else if (arg == "-b")
+			base = v;
+		else
+			Usage();
+	}
+	if (i >= argc)
+		Usage();
+	for (; i < argc; i++)
+		Collect(argv[i], files);
+
+	auto began = std::chrono::steady_clock::now();
+	StealPool pool(threads);
+	for (size_t f = 0; f < files.size(); f++) {
+		Task t;
+		t.path = files[f];
+		pool.Push(f % threads, std::move(t));
+	}
+
+	std::vector<std::thread> workers;
+	for (size_t w = 0; w < threads; w++) {
+		workers.emplace_back([&, w]() {
+			Task task;
+			for (;;) {
+				if (pool.Take(w, task)) {
+					RunTask(pool, w, task, chunk, base);
+					task = Task();
+					pool.Done();
+				} else if (pool.Idle()) {
+					return;
+				} else {
+					// Another worker may still be opening an image
+					std::this_thread::sleep_for(std::chrono::microseconds(TRIAGE_IDLE_US));
+				}
+			}
+		});
+	}
+	for (auto &t : workers)
+		t.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+	fprintf(stderr, "%llu images, %.1f MiB of code in %.1fs on %zu threads\n",
+		(unsigned long long)imagesDone.load(), bytesDone.load() / 1048576.0, seconds, threads);
+	return 0;
+}
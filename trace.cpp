@@ -0,0 +1,170 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+#include "memprof.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define TRACE_RING_SIZE (1 << 16)
+
+std::atomic<bool> PpcTrace::enabled(false);
+
+/*
+ * Single-producer ring: only the owning thread writes events and head,
+ * the exporter only reads. head counts every event ever recorded. Each
+ * slot carries a sequence number, 2 * index + 2 once event index is
+ * complete and odd while it is being written, so the exporter can copy
+ * slots while the owner keeps recording and drop any it overwrote.
+ */
+struct TraceSlot {
+	std::atomic<uint64_t> seq;
+	// start, end, addr, inst | callback << 32
+	std::atomic<uint64_t> words[4];
+};
+
+struct TraceRing {
+	std::atomic<uint64_t> head;
+	uint32_t tid;
+	TraceSlot slots[TRACE_RING_SIZE];
+};
+
+static std::mutex ringsLock;
+static std::vector<std::shared_ptr<TraceRing>> rings;
+static std::string exitPath;
+
+static TraceRing *ThreadRing() {
+	thread_local std::shared_ptr<TraceRing> ring;
+	if (!ring) {
+		// Registration happens once per thread; recording itself is lock-free.
+		ring = std::make_shared<TraceRing>();
+		ring->head.store(0, std::memory_order_relaxed);
+		for (auto &slot : ring->slots)
+			slot.seq.store(0, std::memory_order_relaxed);
+		std::lock_guard<std::mutex> guard(ringsLock);
+		ring->tid = rings.size();
+		rings.push_back(ring);
+		PpcMemProfile::Hold(MemCache::TraceRings, sizeof(TraceRing));
+	}
+	return ring.get();
+}
+
+static const char *CallbackName(TraceCallback cb) {
+	switch (cb) {
+		case TraceCallback::InstructionInfo: return "GetInstructionInfo";
+		case TraceCallback::InstructionText: return "GetInstructionText";
+		case TraceCallback::InstructionLowLevelIL: return "GetInstructionLowLevelIL";
+		default: return "unknown";
+	}
+}
+
+static void ExportAtExit() {
+	PpcTrace::enabled.store(false);
+	PpcTrace::ExportChromeTrace(exitPath);
+}
+
+void PpcTrace::Init() {
+	const char *path = getenv("BN_PPC64_TRACE");
+	if (path && *path) {
+		exitPath = path;
+		atexit(ExportAtExit);
+		enabled.store(true);
+	}
+}
+
+uint64_t PpcTrace::Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+}
+
+void PpcTrace::Record(const TraceEvent &ev) {
+	TraceRing *ring = ThreadRing();
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+	TraceSlot &slot = ring->slots[head % TRACE_RING_SIZE];
+	slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.words[0].store(ev.start, std::memory_order_relaxed);
+	slot.words[1].store(ev.end, std::memory_order_relaxed);
+	slot.words[2].store(ev.addr, std::memory_order_relaxed);
+	slot.words[3].store(ev.inst | (uint64_t)ev.callback << 32, std::memory_order_relaxed);
+	slot.seq.store(2 * head + 2, std::memory_order_release);
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Copies the events still in ring, oldest first, skipping any slot the
+// owner rewrote while it was being read.
+static void SnapshotRing(const TraceRing &ring, std::vector<TraceEvent> &out) {
+	uint64_t head = ring.head.load(std::memory_order_acquire);
+	uint64_t tail = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+	out.reserve(head - tail);
+	for (uint64_t i = tail; i < head; i++) {
+		const TraceSlot &slot = ring.slots[i % TRACE_RING_SIZE];
+		uint64_t seq = slot.seq.load(std::memory_order_acquire);
+		if (seq != 2 * i + 2)
+			continue;
+		uint64_t words[4];
+		for (size_t k = 0; k < 4; k++)
+			words[k] = slot.words[k].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.seq.load(std::memory_order_relaxed) != seq)
+			continue;
+		TraceEvent ev;
+		ev.start = words[0];
+		ev.end = words[1];
+		ev.addr = words[2];
+		ev.inst = (uint32_t)words[3];
+		ev.callback = (TraceCallback)(words[3] >> 32);
+		out.push_back(ev);
+	}
+}
+
+bool PpcTrace::ExportChromeTrace(const std::string &path) {
+	FILE *f = fopen(path.c_str(), "w");
+	if (!f)
+		return false;
+
+	std::vector<std::shared_ptr<TraceRing>> snapshot;
+	{
+		std::lock_guard<std::mutex> guard(ringsLock);
+		snapshot = rings;
+	}
+
+	fputs("{\"traceEvents\":[\n", f);
+	bool first = true;
+	for (auto &ring : snapshot) {
+		// Copy first, so formatting does not give the owner time to lap us
+		std::vector<TraceEvent> events;
+		SnapshotRing(*ring, events);
+		for (const TraceEvent &ev : events) {
+			fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"ppc64\",\"ph\":\"X\","
+				"\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,"
+				"\"args\":{\"addr\":\"0x%llx\",\"opcode\":%u,\"inst\":\"0x%08x\"}}",
+				first ? "" : ",\n",
+				CallbackName(ev.callback),
+				ev.start / 1000.0, (ev.end - ev.start) / 1000.0, ring->tid,
+				(unsigned long long)ev.addr, ev.inst >> 26, ev.inst);
+			first = false;
+		}
+	}
+	fputs("\n]}\n", f);
+	return fclose(f) == 0;
+}
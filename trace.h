@@ -0,0 +1,86 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/*
+ * Optional latency tracing of the architecture callbacks.
+ *
+ * Each traced callback records one span (start, end, address, instruction
+ * word) into a ring buffer owned by the calling thread. Recording never
+ * takes a lock; the only shared state touched on the hot path is the
+ * enabled flag, so a disabled tracer costs one predictable branch.
+ *
+ * Tracing is enabled by the BN_PPC64_TRACE environment variable (its value
+ * is the path the trace gets written to at exit) or by the
+ * "ppc64.trace.enabled" setting. The result is Chrome trace JSON, loadable
+ * in chrome://tracing or Perfetto.
+ */
+
+enum class TraceCallback : uint8_t {
+	InstructionInfo,
+	InstructionText,
+	InstructionLowLevelIL,
+	ENUM_LAST
+};
+
+struct TraceEvent {
+	uint64_t start;
+	uint64_t end;
+	uint64_t addr;
+	uint32_t inst;
+	TraceCallback callback;
+};
+
+class PpcTrace {
+public:
+	static std::atomic<bool> enabled;
+
+	static void Init();
+	static void Record(const TraceEvent &ev);
+	static uint64_t Now();
+
+	// Writes all buffered spans as Chrome trace JSON. Returns false if the
+	// file could not be written.
+	static bool ExportChromeTrace(const std::string &path);
+};
+
+class TraceSpan {
+private:
+	TraceEvent ev;
+	bool active;
+public:
+	TraceSpan(TraceCallback callback, const uint8_t *data, uint64_t addr, size_t len) {
+		active = PpcTrace::enabled.load(std::memory_order_relaxed);
+		if (!active)
+			return;
+		ev.callback = callback;
+		ev.addr = addr;
+		ev.inst = len >= 4 ? (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3] : 0;
+		ev.start = PpcTrace::Now();
+	}
+
+	~TraceSpan() {
+		if (!active)
+			return;
+		ev.end = PpcTrace::Now();
+		PpcTrace::Record(ev);
+	}
+};
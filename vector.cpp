@@ -0,0 +1,644 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vector.h"
+
+static const VecOpcode vecOpcodes[] = {
+	/* VMX, VX-form */
+	{"vaddubm", 4, 0, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vadduhm", 4, 64, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vadduwm", 4, 128, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vaddudm", 4, 192, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vaddcuw", 4, 384, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vaddubs", 4, 512, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vadduhs", 4, 576, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vadduws", 4, 640, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vaddsbs", 4, 768, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vaddshs", 4, 832, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vaddsws", 4, 896, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsububm", 4, 1024, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubuhm", 4, 1088, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubuwm", 4, 1152, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubudm", 4, 1216, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubcuw", 4, 1408, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsububs", 4, 1536, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubuhs", 4, 1600, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubuws", 4, 1664, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubsbs", 4, 1792, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubshs", 4, 1856, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubsws", 4, 1920, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxub", 4, 2, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxuh", 4, 66, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxuw", 4, 130, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxud", 4, 194, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxsb", 4, 258, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxsh", 4, 322, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxsw", 4, 386, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxsd", 4, 450, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminub", 4, 514, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminuh", 4, 578, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminuw", 4, 642, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminud", 4, 706, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminsb", 4, 770, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminsh", 4, 834, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminsw", 4, 898, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminsd", 4, 962, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vavgub", 4, 1026, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vavguh", 4, 1090, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vavguw", 4, 1154, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vavgsb", 4, 1282, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vavgsh", 4, 1346, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vavgsw", 4, 1410, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrlb", 4, 4, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrlh", 4, 68, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrlw", 4, 132, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrld", 4, 196, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vslb", 4, 260, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vslh", 4, 324, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vslw", 4, 388, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsl", 4, 452, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsrb", 4, 516, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsrh", 4, 580, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsrw", 4, 644, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsr", 4, 708, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsrab", 4, 772, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsrah", 4, 836, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsraw", 4, 900, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsrad", 4, 964, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsld", 4, 1476, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsrd", 4, 1732, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vslo", 4, 1036, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsro", 4, 1100, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmuloub", 4, 8, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmulouh", 4, 72, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmulouw", 4, 136, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmuluwm", 4, 137, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmulosb", 4, 264, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmulosh", 4, 328, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmulosw", 4, 392, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmuleub", 4, 520, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmuleuh", 4, 584, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmuleuw", 4, 648, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmulesb", 4, 776, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmulesh", 4, 840, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmulesw", 4, 904, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsum4ubs", 4, 1544, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsum4sbs", 4, 1800, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsum4shs", 4, 1608, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsum2sws", 4, 1672, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsumsws", 4, 1928, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmrghb", 4, 12, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmrghh", 4, 76, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmrghw", 4, 140, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmrglb", 4, 268, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmrglh", 4, 332, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmrglw", 4, 396, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkuhum", 4, 14, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkuwum", 4, 78, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkuhus", 4, 142, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkuwus", 4, 206, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkshus", 4, 270, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkswus", 4, 334, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkshss", 4, 398, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkswss", 4, 462, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkpx", 4, 782, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkudum", 4, 1102, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpkudus", 4, 1230, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpksdus", 4, 1358, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpksdss", 4, 1486, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vaddfp", 4, 10, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsubfp", 4, 74, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaxfp", 4, 1034, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vminfp", 4, 1098, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vcipher", 4, 1288, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vcipherlast", 4, 1289, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vncipher", 4, 1352, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vncipherlast", 4, 1353, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpmsumb", 4, 1032, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpmsumh", 4, 1096, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpmsumw", 4, 1160, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpmsumd", 4, 1224, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vbpermq", 4, 1356, VEC_VX_VT_VA_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vand", 4, 1028, VEC_VX_VT_VA_VB, VEC_LIFT_AND, 0},
+	{"vandc", 4, 1092, VEC_VX_VT_VA_VB, VEC_LIFT_ANDC, 0},
+	{"vor", 4, 1156, VEC_VX_VT_VA_VB, VEC_LIFT_OR, 0},
+	{"vxor", 4, 1220, VEC_VX_VT_VA_VB, VEC_LIFT_XOR, 0},
+	{"vnor", 4, 1284, VEC_VX_VT_VA_VB, VEC_LIFT_NOR, 0},
+	{"vorc", 4, 1348, VEC_VX_VT_VA_VB, VEC_LIFT_ORC, 0},
+	{"vnand", 4, 1412, VEC_VX_VT_VA_VB, VEC_LIFT_NAND, 0},
+	{"veqv", 4, 1668, VEC_VX_VT_VA_VB, VEC_LIFT_EQV, 0},
+
+	/* VMX, VX-form unary and immediate */
+	{"vrefp", 4, 266, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrsqrtefp", 4, 330, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vexptefp", 4, 394, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vlogefp", 4, 458, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrfin", 4, 522, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrfiz", 4, 586, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrfip", 4, 650, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vrfim", 4, 714, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vupkhsb", 4, 526, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vupkhsh", 4, 590, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vupklsb", 4, 654, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vupklsh", 4, 718, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vupkhpx", 4, 846, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vupklpx", 4, 974, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vupkhsw", 4, 1614, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vupklsw", 4, 1742, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vclzb", 4, 1794, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vclzh", 4, 1858, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vclzw", 4, 1922, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vclzd", 4, 1986, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpopcntb", 4, 1795, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpopcnth", 4, 1859, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpopcntw", 4, 1923, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vpopcntd", 4, 1987, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vgbbd", 4, 1292, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vsbox", 4, 1480, VEC_VX_VT_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vspltb", 4, 524, VEC_VX_VT_VB_UIM, VEC_LIFT_INTRINSIC, 0},
+	{"vsplth", 4, 588, VEC_VX_VT_VB_UIM, VEC_LIFT_INTRINSIC, 0},
+	{"vspltw", 4, 652, VEC_VX_VT_VB_UIM, VEC_LIFT_INTRINSIC, 0},
+	{"vcfux", 4, 778, VEC_VX_VT_VB_UIM, VEC_LIFT_INTRINSIC, 0},
+	{"vcfsx", 4, 842, VEC_VX_VT_VB_UIM, VEC_LIFT_INTRINSIC, 0},
+	{"vctuxs", 4, 906, VEC_VX_VT_VB_UIM, VEC_LIFT_INTRINSIC, 0},
+	{"vctsxs", 4, 970, VEC_VX_VT_VB_UIM, VEC_LIFT_INTRINSIC, 0},
+	{"vspltisb", 4, 780, VEC_VX_VT_SIM, VEC_LIFT_INTRINSIC, 0},
+	{"vspltish", 4, 844, VEC_VX_VT_SIM, VEC_LIFT_INTRINSIC, 0},
+	{"vspltisw", 4, 908, VEC_VX_VT_SIM, VEC_LIFT_INTRINSIC, 0},
+	{"mfvscr", 4, 1540, VEC_VX_VT, VEC_LIFT_MFVSCR, 0},
+	{"mtvscr", 4, 1604, VEC_VX_VB, VEC_LIFT_MTVSCR, 0},
+
+	/* VMX, VC-form */
+	{"vcmpequb", 4, 6, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpequh", 4, 70, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpequw", 4, 134, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpequd", 4, 199, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpeqfp", 4, 198, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgefp", 4, 454, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtub", 4, 518, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtuh", 4, 582, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtuw", 4, 646, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtud", 4, 711, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtfp", 4, 710, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtsb", 4, 774, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtsh", 4, 838, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtsw", 4, 902, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtsd", 4, 967, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpbfp", 4, 966, VEC_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpequb.", 4, 1030, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpequh.", 4, 1094, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpequw.", 4, 1158, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpequd.", 4, 1223, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpeqfp.", 4, 1222, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgefp.", 4, 1478, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtub.", 4, 1542, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtuh.", 4, 1606, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtuw.", 4, 1670, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtud.", 4, 1735, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtfp.", 4, 1734, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtsb.", 4, 1798, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtsh.", 4, 1862, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtsw.", 4, 1926, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpgtsd.", 4, 1991, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+	{"vcmpbfp.", 4, 1990, VEC_VC_RC, VEC_LIFT_INTRINSIC, 0},
+
+	/* VMX, VA-form */
+	{"vmhaddshs", 4, 32, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vmhraddshs", 4, 33, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vmladduhm", 4, 34, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vmsumubm", 4, 36, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vmsummbm", 4, 37, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vmsumuhm", 4, 38, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vmsumuhs", 4, 39, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vmsumshm", 4, 40, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vmsumshs", 4, 41, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vperm", 4, 43, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vpermxor", 4, 45, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vaddeuqm", 4, 60, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vaddecuq", 4, 61, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vsubeuqm", 4, 62, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vsubecuq", 4, 63, VEC_VA_VT_VA_VB_VC, VEC_LIFT_INTRINSIC, 0},
+	{"vsel", 4, 42, VEC_VA_VT_VA_VB_VC, VEC_LIFT_SEL, 0},
+	{"vsldoi", 4, 44, VEC_VA_VT_VA_VB_SHB, VEC_LIFT_INTRINSIC, 0},
+	{"vmaddfp", 4, 46, VEC_VA_VT_VA_VC_VB, VEC_LIFT_INTRINSIC, 0},
+	{"vnmsubfp", 4, 47, VEC_VA_VT_VA_VC_VB, VEC_LIFT_INTRINSIC, 0},
+
+	/* VSX, XX3-form */
+	{"xsadddp", 60, 32, VEC_XX3, VEC_LIFT_FADD, 0},
+	{"xssubdp", 60, 40, VEC_XX3, VEC_LIFT_FSUB, 0},
+	{"xsmuldp", 60, 48, VEC_XX3, VEC_LIFT_FMUL, 0},
+	{"xsdivdp", 60, 56, VEC_XX3, VEC_LIFT_FDIV, 0},
+	{"xsmaddadp", 60, 33, VEC_XX3, VEC_LIFT_INTRINSIC, VEC_TARGET_IN},
+	{"xsmaddmdp", 60, 41, VEC_XX3, VEC_LIFT_INTRINSIC, VEC_TARGET_IN},
+	{"xsmsubadp", 60, 49, VEC_XX3, VEC_LIFT_INTRINSIC, VEC_TARGET_IN},
+	{"xsmsubmdp", 60, 57, VEC_XX3, VEC_LIFT_INTRINSIC, VEC_TARGET_IN},
+	{"xvmaddadp", 60, 97, VEC_XX3, VEC_LIFT_INTRINSIC, VEC_TARGET_IN},
+	{"xvmaddasp", 60, 65, VEC_XX3, VEC_LIFT_INTRINSIC, VEC_TARGET_IN},
+	{"xsmaxdp", 60, 160, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xsmindp", 60, 168, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xscpsgndp", 60, 176, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvadddp", 60, 96, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvsubdp", 60, 104, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvmuldp", 60, 112, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvdivdp", 60, 120, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvaddsp", 60, 64, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvsubsp", 60, 72, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvmulsp", 60, 80, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvdivsp", 60, 88, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvmaxdp", 60, 224, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvmindp", 60, 232, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvmaxsp", 60, 192, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvminsp", 60, 200, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xxmrghw", 60, 18, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xxmrglw", 60, 50, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xxland", 60, 130, VEC_XX3, VEC_LIFT_AND, 0},
+	{"xxlandc", 60, 138, VEC_XX3, VEC_LIFT_ANDC, 0},
+	{"xxlor", 60, 146, VEC_XX3, VEC_LIFT_OR, 0},
+	{"xxlxor", 60, 154, VEC_XX3, VEC_LIFT_XOR, 0},
+	{"xxlnor", 60, 162, VEC_XX3, VEC_LIFT_NOR, 0},
+	{"xxlorc", 60, 170, VEC_XX3, VEC_LIFT_ORC, 0},
+	{"xxlnand", 60, 178, VEC_XX3, VEC_LIFT_NAND, 0},
+	{"xxleqv", 60, 186, VEC_XX3, VEC_LIFT_EQV, 0},
+	{"xvcmpeqdp", 60, 99, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpgedp", 60, 115, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpgtdp", 60, 107, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpeqsp", 60, 67, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpgesp", 60, 83, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpgtsp", 60, 75, VEC_XX3, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpeqdp.", 60, 227, VEC_XX3_RC, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpgedp.", 60, 243, VEC_XX3_RC, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpgtdp.", 60, 235, VEC_XX3_RC, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpeqsp.", 60, 195, VEC_XX3_RC, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpgesp.", 60, 211, VEC_XX3_RC, VEC_LIFT_INTRINSIC, 0},
+	{"xvcmpgtsp.", 60, 203, VEC_XX3_RC, VEC_LIFT_INTRINSIC, 0},
+	{"xscmpudp", 60, 35, VEC_XX3_BF, VEC_LIFT_INTRINSIC, 0},
+	{"xscmpodp", 60, 43, VEC_XX3_BF, VEC_LIFT_INTRINSIC, 0},
+	{"xxpermdi", 60, 10, VEC_XX3_DM, VEC_LIFT_INTRINSIC, 0},
+	{"xxpermdi", 60, 42, VEC_XX3_DM, VEC_LIFT_INTRINSIC, 0},
+	{"xxpermdi", 60, 74, VEC_XX3_DM, VEC_LIFT_INTRINSIC, 0},
+	{"xxpermdi", 60, 106, VEC_XX3_DM, VEC_LIFT_INTRINSIC, 0},
+	{"xxsldwi", 60, 2, VEC_XX3_DM, VEC_LIFT_INTRINSIC, 0},
+	{"xxsldwi", 60, 34, VEC_XX3_DM, VEC_LIFT_INTRINSIC, 0},
+	{"xxsldwi", 60, 66, VEC_XX3_DM, VEC_LIFT_INTRINSIC, 0},
+	{"xxsldwi", 60, 98, VEC_XX3_DM, VEC_LIFT_INTRINSIC, 0},
+
+	/* VSX, XX2-form */
+	{"xsabsdp", 60, 345, VEC_XX2, VEC_LIFT_FABS, 0},
+	{"xsnabsdp", 60, 361, VEC_XX2, VEC_LIFT_FNABS, 0},
+	{"xsnegdp", 60, 377, VEC_XX2, VEC_LIFT_FNEG, 0},
+	{"xssqrtdp", 60, 75, VEC_XX2, VEC_LIFT_FSQRT, 0},
+	{"xscvdpsp", 60, 265, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xscvspdp", 60, 329, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xscvdpsxds", 60, 344, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xscvdpuxds", 60, 328, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xscvsxddp", 60, 376, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xscvuxddp", 60, 360, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xscvdpsxws", 60, 88, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xscvdpuxws", 60, 72, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xsrdpi", 60, 73, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xsrdpiz", 60, 89, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xsrdpip", 60, 105, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xsrdpim", 60, 121, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvabsdp", 60, 473, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvnegdp", 60, 505, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvsqrtdp", 60, 203, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvabssp", 60, 409, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvnegsp", 60, 441, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvsqrtsp", 60, 139, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvcvdpsp", 60, 393, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvcvspdp", 60, 457, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvcvsxwsp", 60, 184, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvcvuxwsp", 60, 168, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvcvspsxws", 60, 152, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xvcvspuxws", 60, 136, VEC_XX2, VEC_LIFT_INTRINSIC, 0},
+	{"xxspltw", 60, 164, VEC_XX2_UIM, VEC_LIFT_INTRINSIC, 0},
+
+	/* VSX, XX4-form */
+	{"xxsel", 60, 3, VEC_XX4, VEC_LIFT_SEL, 0},
+
+	/* Group 31 vector loads, stores and moves */
+	{"lvsl", 31, 6, VEC_X_VT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lvsr", 31, 38, VEC_X_VT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lvebx", 31, 7, VEC_X_VT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lvehx", 31, 39, VEC_X_VT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lvewx", 31, 71, VEC_X_VT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lvx", 31, 103, VEC_X_VT_MEM, VEC_LIFT_LOAD_ALIGNED, 0},
+	{"lvxl", 31, 359, VEC_X_VT_MEM, VEC_LIFT_LOAD_ALIGNED, 0},
+	{"stvebx", 31, 135, VEC_X_VS_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"stvehx", 31, 167, VEC_X_VS_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"stvewx", 31, 199, VEC_X_VS_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"stvx", 31, 231, VEC_X_VS_MEM, VEC_LIFT_STORE_ALIGNED, 0},
+	{"stvxl", 31, 487, VEC_X_VS_MEM, VEC_LIFT_STORE_ALIGNED, 0},
+	{"lxsdx", 31, 588, VEC_XX1_XT_MEM, VEC_LIFT_LOAD_SCALAR, 0},
+	{"lxsiwzx", 31, 12, VEC_XX1_XT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lxsiwax", 31, 76, VEC_XX1_XT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lxsspx", 31, 524, VEC_XX1_XT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lxvdsx", 31, 332, VEC_XX1_XT_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"lxvd2x", 31, 844, VEC_XX1_XT_MEM, VEC_LIFT_LOAD, 0},
+	{"lxvw4x", 31, 780, VEC_XX1_XT_MEM, VEC_LIFT_LOAD, 0},
+	{"stxsdx", 31, 716, VEC_XX1_XS_MEM, VEC_LIFT_STORE_SCALAR, 0},
+	{"stxsiwx", 31, 140, VEC_XX1_XS_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"stxsspx", 31, 652, VEC_XX1_XS_MEM, VEC_LIFT_INTRINSIC, 0},
+	{"stxvd2x", 31, 972, VEC_XX1_XS_MEM, VEC_LIFT_STORE, 0},
+	{"stxvw4x", 31, 908, VEC_XX1_XS_MEM, VEC_LIFT_STORE, 0},
+	{"mfvsrd", 31, 51, VEC_XX1_RA_XS, VEC_LIFT_MFVSRD, 0},
+	{"mfvsrwz", 31, 115, VEC_XX1_RA_XS, VEC_LIFT_INTRINSIC, 0},
+	{"mtvsrd", 31, 179, VEC_XX1_XT_RA, VEC_LIFT_MTVSRD, 0},
+	{"mtvsrwa", 31, 211, VEC_XX1_XT_RA, VEC_LIFT_INTRINSIC, 0},
+	{"mtvsrwz", 31, 243, VEC_XX1_XT_RA, VEC_LIFT_INTRINSIC, 0},
+
+	/* DS- and DQ-form loads and stores (ISA 3.0) */
+	{"lxsd", 57, 2, VEC_DS_VRT, VEC_LIFT_INTRINSIC, 0},
+	{"lxssp", 57, 3, VEC_DS_VRT, VEC_LIFT_INTRINSIC, 0},
+	{"stxsd", 61, 2, VEC_DS_VRS, VEC_LIFT_INTRINSIC, 0},
+	{"stxssp", 61, 3, VEC_DS_VRS, VEC_LIFT_INTRINSIC, 0},
+	{"lxv", 61, 1, VEC_DQ_XT, VEC_LIFT_LOAD, 0},
+	{"stxv", 61, 5, VEC_DQ_XS, VEC_LIFT_STORE, 0},
+};
+
+#define VEC_COUNT (sizeof(vecOpcodes) / sizeof(vecOpcodes[0]))
+
+/*
+ * Direct-indexed lookup tables, one per encoding space. Slots hold the
+ * opcode index plus one so zero means "not an instruction".
+ */
+struct VecTables {
+	uint16_t vx[2048];	// op 4, bits 0-10 (VX and VC with Rc)
+	uint16_t va[64];	// op 4, bits 0-5 when >= 32
+	uint16_t xx3[256];	// op 60, bits 3-10
+	uint16_t xx2[512];	// op 60, bits 2-10
+	uint16_t x31[1024];	// op 31, bits 1-10
+	uint16_t ds57[4];
+	uint16_t ds61[8];	// op 61, bits 0-2 (DS uses bits 0-1)
+	uint16_t xx4;
+
+	VecTables() : vx(), va(), xx3(), xx2(), x31(), ds57(), ds61(), xx4(0) {
+		for (size_t i = 0; i < VEC_COUNT; i++) {
+			const VecOpcode &op = vecOpcodes[i];
+			uint16_t slot = i + 1;
+			switch (op.form) {
+			case VEC_VA_VT_VA_VB_VC:
+			case VEC_VA_VT_VA_VC_VB:
+			case VEC_VA_VT_VA_VB_SHB:
+				va[op.xo] = slot;
+				break;
+			case VEC_XX3:
+			case VEC_XX3_RC:
+			case VEC_XX3_BF:
+			case VEC_XX3_DM:
+				xx3[op.xo] = slot;
+				break;
+			case VEC_XX2:
+			case VEC_XX2_UIM:
+				xx2[op.xo] = slot;
+				break;
+			case VEC_XX4:
+				xx4 = slot;
+				break;
+			case VEC_DS_VRT:
+			case VEC_DS_VRS:
+			case VEC_DQ_XT:
+			case VEC_DQ_XS:
+				if (op.primary == 57) {
+					ds57[op.xo] = slot;
+				} else if (op.form == VEC_DS_VRS) {
+					// DS form only decodes bits 0-1
+					ds61[op.xo] = slot;
+					ds61[op.xo | 4] = slot;
+				} else {
+					ds61[op.xo] = slot;
+				}
+				break;
+			default:
+				if (op.primary == 31)
+					x31[op.xo] = slot;
+				else
+					vx[op.xo] = slot;
+				break;
+			}
+		}
+	}
+};
+
+static const VecTables &Tables() {
+	static VecTables tables;
+	return tables;
+}
+
+static const VecOpcode *Slot(uint16_t slot) {
+	return slot ? &vecOpcodes[slot - 1] : nullptr;
+}
+
+const VecOpcode *VecLookup(uint32_t inst) {
+	const VecTables &t = Tables();
+	switch (inst >> 26) {
+	case 4:
+		if ((inst & 0x3f) >= 32)
+			return Slot(t.va[inst & 0x3f]);
+		return Slot(t.vx[inst & 0x7ff]);
+	case 31:
+		return Slot(t.x31[(inst >> 1) & 0x3ff]);
+	case 57:
+		return Slot(t.ds57[inst & 3]);
+	case 60:
+		if (((inst >> 4) & 3) == 3)
+			return Slot(t.xx4);
+		if (const VecOpcode *op = Slot(t.xx3[(inst >> 3) & 0xff]))
+			return op;
+		return Slot(t.xx2[(inst >> 2) & 0x1ff]);
+	case 61:
+		return Slot(t.ds61[inst & 7]);
+	default:
+		return nullptr;
+	}
+}
+
+#define VEC_T(i) ((i >> 21) & 0x1f)
+#define VEC_A(i) ((i >> 16) & 0x1f)
+#define VEC_B(i) ((i >> 11) & 0x1f)
+#define VEC_C(i) ((i >> 6) & 0x1f)
+#define VSX_T(i) (VEC_T(i) | ((i & 1) << 5))
+#define VSX_A(i) (VEC_A(i) | ((i & 4) << 3))
+#define VSX_B(i) (VEC_B(i) | ((i & 2) << 4))
+#define VSX_C(i) (VEC_C(i) | ((i & 8) << 2))
+#define DQ_T(i) (VEC_T(i) | ((i & 8) << 2))
+
+static VecOperand Reg(VecOperandKind kind, uint32_t value, bool dest = false) {
+	return {kind, dest, value, 0, 0};
+}
+
+static VecOperand Imm(uint32_t value) {
+	return {VecOperandKind::Imm, false, value, 0, 0};
+}
+
+static VecOperand MemX(uint32_t inst) {
+	return {VecOperandKind::MemX, false, VEC_A(inst), VEC_B(inst), 0};
+}
+
+static VecOperand Mem(uint32_t inst, uint32_t mask) {
+	int64_t d = (int16_t)(inst & mask);
+	return {VecOperandKind::Mem, false, VEC_A(inst), 0, d};
+}
+
+size_t VecDecodeOperands(const VecOpcode &op, uint32_t inst, VecOperand *ops) {
+	const VecOperandKind VR = VecOperandKind::VR, VSR = VecOperandKind::VSR, GPR = VecOperandKind::GPR;
+	size_t n = 0;
+	switch (op.form) {
+	case VEC_VX_VT_VA_VB:
+	case VEC_VC:
+	case VEC_VC_RC:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = Reg(VR, VEC_A(inst));
+		ops[n++] = Reg(VR, VEC_B(inst));
+		break;
+	case VEC_VX_VT_VB:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = Reg(VR, VEC_B(inst));
+		break;
+	case VEC_VX_VT_VB_UIM:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = Reg(VR, VEC_B(inst));
+		ops[n++] = Imm(VEC_A(inst));
+		break;
+	case VEC_VX_VT_SIM:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = Imm((VEC_A(inst) & 0x10) ? VEC_A(inst) | 0xffffffe0 : VEC_A(inst));
+		break;
+	case VEC_VX_VT:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		break;
+	case VEC_VX_VB:
+		ops[n++] = Reg(VR, VEC_B(inst));
+		break;
+	case VEC_VA_VT_VA_VB_VC:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = Reg(VR, VEC_A(inst));
+		ops[n++] = Reg(VR, VEC_B(inst));
+		ops[n++] = Reg(VR, VEC_C(inst));
+		break;
+	case VEC_VA_VT_VA_VC_VB:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = Reg(VR, VEC_A(inst));
+		ops[n++] = Reg(VR, VEC_C(inst));
+		ops[n++] = Reg(VR, VEC_B(inst));
+		break;
+	case VEC_VA_VT_VA_VB_SHB:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = Reg(VR, VEC_A(inst));
+		ops[n++] = Reg(VR, VEC_B(inst));
+		ops[n++] = Imm((inst >> 6) & 0xf);
+		break;
+	case VEC_XX3:
+	case VEC_XX3_RC:
+		ops[n++] = Reg(VSR, VSX_T(inst), true);
+		ops[n++] = Reg(VSR, VSX_A(inst));
+		ops[n++] = Reg(VSR, VSX_B(inst));
+		break;
+	case VEC_XX3_BF:
+		ops[n++] = {VecOperandKind::CRF, true, (inst >> 23) & 7, 0, 0};
+		ops[n++] = Reg(VSR, VSX_A(inst));
+		ops[n++] = Reg(VSR, VSX_B(inst));
+		break;
+	case VEC_XX3_DM:
+		ops[n++] = Reg(VSR, VSX_T(inst), true);
+		ops[n++] = Reg(VSR, VSX_A(inst));
+		ops[n++] = Reg(VSR, VSX_B(inst));
+		ops[n++] = Imm((inst >> 8) & 3);
+		break;
+	case VEC_XX2:
+		ops[n++] = Reg(VSR, VSX_T(inst), true);
+		ops[n++] = Reg(VSR, VSX_B(inst));
+		break;
+	case VEC_XX2_UIM:
+		ops[n++] = Reg(VSR, VSX_T(inst), true);
+		ops[n++] = Reg(VSR, VSX_B(inst));
+		ops[n++] = Imm((inst >> 16) & 3);
+		break;
+	case VEC_XX4:
+		ops[n++] = Reg(VSR, VSX_T(inst), true);
+		ops[n++] = Reg(VSR, VSX_A(inst));
+		ops[n++] = Reg(VSR, VSX_B(inst));
+		ops[n++] = Reg(VSR, VSX_C(inst));
+		break;
+	case VEC_X_VT_MEM:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = MemX(inst);
+		break;
+	case VEC_X_VS_MEM:
+		ops[n++] = Reg(VR, VEC_T(inst));
+		ops[n++] = MemX(inst);
+		break;
+	case VEC_XX1_XT_MEM:
+		ops[n++] = Reg(VSR, VSX_T(inst), true);
+		ops[n++] = MemX(inst);
+		break;
+	case VEC_XX1_XS_MEM:
+		ops[n++] = Reg(VSR, VSX_T(inst));
+		ops[n++] = MemX(inst);
+		break;
+	case VEC_XX1_RA_XS:
+		ops[n++] = Reg(GPR, VEC_A(inst), true);
+		ops[n++] = Reg(VSR, VSX_T(inst));
+		break;
+	case VEC_XX1_XT_RA:
+		ops[n++] = Reg(VSR, VSX_T(inst), true);
+		ops[n++] = Reg(GPR, VEC_A(inst));
+		break;
+	case VEC_DS_VRT:
+		ops[n++] = Reg(VR, VEC_T(inst), true);
+		ops[n++] = Mem(inst, 0xfffc);
+		break;
+	case VEC_DS_VRS:
+		ops[n++] = Reg(VR, VEC_T(inst));
+		ops[n++] = Mem(inst, 0xfffc);
+		break;
+	case VEC_DQ_XT:
+		ops[n++] = Reg(VSR, DQ_T(inst), true);
+		ops[n++] = Mem(inst, 0xfff0);
+		break;
+	case VEC_DQ_XS:
+		ops[n++] = Reg(VSR, DQ_T(inst));
+		ops[n++] = Mem(inst, 0xfff0);
+		break;
+	}
+	return n;
+}
+
+size_t VecOperandSize(VecOperandKind kind) {
+	switch (kind) {
+	case VecOperandKind::VR:
+	case VecOperandKind::VSR:
+		return 16;
+	case VecOperandKind::CRF:
+		return 1;
+	case VecOperandKind::Imm:
+		return 4;
+	default:
+		return 8;
+	}
+}
+
+size_t VecOpcodeCount() {
+	return VEC_COUNT;
+}
+
+const VecOpcode &VecOpcodeAt(size_t index) {
+	return vecOpcodes[index];
+}
+
+size_t VecOpcodeIndex(const VecOpcode &op) {
+	return &op - vecOpcodes;
+}
@@ -0,0 +1,143 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * VMX (AltiVec) and VSX instruction tables.
+ *
+ * Unlike the scalar decoder, vector instructions are looked up in
+ * direct-indexed tables built from one spec list. Each entry names an
+ * operand form, which the disassembler prints generically, and a lift
+ * kind. Anything without an LLIL equivalent lifts as an intrinsic named
+ * after the instruction.
+ */
+
+enum VecForm : uint8_t {
+	VEC_VX_VT_VA_VB,	// vaddubm vt, va, vb
+	VEC_VX_VT_VB,		// vrefp vt, vb
+	VEC_VX_VT_VB_UIM,	// vspltw vt, vb, uim
+	VEC_VX_VT_SIM,		// vspltisw vt, sim
+	VEC_VX_VT,		// mfvscr vt
+	VEC_VX_VB,		// mtvscr vb
+	VEC_VC,			// vcmpequw vt, va, vb
+	VEC_VC_RC,		// vcmpequw. vt, va, vb (sets cr6)
+	VEC_VA_VT_VA_VB_VC,	// vperm vt, va, vb, vc
+	VEC_VA_VT_VA_VC_VB,	// vmaddfp vt, va, vc, vb
+	VEC_VA_VT_VA_VB_SHB,	// vsldoi vt, va, vb, shb
+	VEC_XX3,		// xvadddp xt, xa, xb
+	VEC_XX3_RC,		// xvcmpeqdp. xt, xa, xb (sets cr6)
+	VEC_XX3_BF,		// xscmpudp bf, xa, xb
+	VEC_XX3_DM,		// xxpermdi xt, xa, xb, dm
+	VEC_XX2,		// xvabsdp xt, xb
+	VEC_XX2_UIM,		// xxspltw xt, xb, uim
+	VEC_XX4,		// xxsel xt, xa, xb, xc
+	VEC_X_VT_MEM,		// lvx vt, ra, rb
+	VEC_X_VS_MEM,		// stvx vs, ra, rb
+	VEC_XX1_XT_MEM,		// lxvd2x xt, ra, rb
+	VEC_XX1_XS_MEM,		// stxvd2x xs, ra, rb
+	VEC_XX1_RA_XS,		// mfvsrd ra, xs
+	VEC_XX1_XT_RA,		// mtvsrd xt, ra
+	VEC_DS_VRT,		// lxsd vrt, ds(ra)
+	VEC_DS_VRS,		// stxsd vrs, ds(ra)
+	VEC_DQ_XT,		// lxv xt, dq(ra)
+	VEC_DQ_XS,		// stxv xs, dq(ra)
+};
+
+enum VecLift : uint8_t {
+	VEC_LIFT_INTRINSIC,
+	VEC_LIFT_AND,
+	VEC_LIFT_ANDC,
+	VEC_LIFT_OR,
+	VEC_LIFT_ORC,
+	VEC_LIFT_XOR,
+	VEC_LIFT_NOR,
+	VEC_LIFT_NAND,
+	VEC_LIFT_EQV,
+	VEC_LIFT_SEL,		// (b & c) | (a & ~c)
+	VEC_LIFT_LOAD,		// 16-byte load
+	VEC_LIFT_LOAD_ALIGNED,	// 16-byte load, EA & ~0xf
+	VEC_LIFT_STORE,
+	VEC_LIFT_STORE_ALIGNED,
+	VEC_LIFT_MFVSCR,
+	VEC_LIFT_MTVSCR,
+	/* Scalar double ops on VSR 0-31 go through the FPR view */
+	VEC_LIFT_FADD,
+	VEC_LIFT_FSUB,
+	VEC_LIFT_FMUL,
+	VEC_LIFT_FDIV,
+	VEC_LIFT_FSQRT,
+	VEC_LIFT_FABS,
+	VEC_LIFT_FNABS,
+	VEC_LIFT_FNEG,
+	VEC_LIFT_LOAD_SCALAR,	// 8-byte load into doubleword 0
+	VEC_LIFT_STORE_SCALAR,
+	VEC_LIFT_MFVSRD,
+	VEC_LIFT_MTVSRD,
+};
+
+// Dest is also read (fused multiply-add "a" forms)
+#define VEC_TARGET_IN 1
+
+struct VecOpcode {
+	const char *name;
+	uint8_t primary;
+	uint16_t xo;
+	VecForm form;
+	VecLift lift;
+	uint8_t flags;
+};
+
+enum class VecOperandKind : uint8_t {
+	VR,
+	VSR,
+	GPR,
+	CRF,
+	Imm,
+	Mem,	// disp(ra)
+	MemX,	// ra, rb
+};
+
+struct VecOperand {
+	VecOperandKind kind;
+	bool dest;
+	uint32_t value;		// register number or immediate
+	uint32_t index;		// rb for MemX
+	int64_t disp;		// displacement for Mem
+};
+
+#define VEC_MAX_OPERANDS 4
+
+// Intrinsic IDs for vector instructions start here, clear of the
+// scalar intrinsics in intrinsics.h.
+#define VEC_INTRINSIC_BASE 0x1000
+
+// Returns nullptr for words that are not a known vector instruction.
+const VecOpcode *VecLookup(uint32_t inst);
+
+// Fills ops in assembly order; returns the operand count.
+size_t VecDecodeOperands(const VecOpcode &op, uint32_t inst, VecOperand *ops);
+
+// Width in bytes of an operand's value (registers, immediates, addresses).
+size_t VecOperandSize(VecOperandKind kind);
+
+// Every vector opcode has a stable index, used for its intrinsic ID.
+size_t VecOpcodeCount();
+const VecOpcode &VecOpcodeAt(size_t index);
+size_t VecOpcodeIndex(const VecOpcode &op);
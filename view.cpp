@@ -0,0 +1,640 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "view.h"
+#include "assembler.h"
+#include "branchgraph.h"
+#include "classify.h"
+#include "decode_cache.h"
+#include "emu.h"
+#include "funchash.h"
+#include "il.h"
+#include "json.h"
+#include "stubs.h"
+#include "toc.h"
+#include "text.h"
+#include "threadpool.h"
+#include "viewstate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#define PREDECODE_CHUNK_WORDS (64 * 1024)
+
+#define EMU_STACK_TOP 0x7fff0000ull
+#define EMU_STACK_SIZE (1024 * 1024)
+#define EMU_RETURN_ADDR 0xdead0000ull
+// Instructions between checks for Cancel
+#define EMU_SLICE (1000 * 1000)
+
+void PpcRegisterViewSettings() {
+	Ref<Settings> settings = Settings::Instance();
+	settings->RegisterSetting("ppc64.decodeIndex.enabled", R"({
+		"title" : "Persistent decode index",
+		"type" : "boolean",
+		"default" : false,
+		"description" : "Keep an on-disk index of decoded instructions per executable segment, keyed by segment content, and memory-map it when the view is reopened."
+	})");
+	settings->RegisterSetting("ppc64.predecode.enabled", R"({
+		"title" : "Pre-decode executable segments",
+		"type" : "boolean",
+		"default" : true,
+		"description" : "Decode all executable segments on low-priority background threads when a view opens, so analysis and the linear view start with a warm decode cache."
+	})");
+	settings->RegisterSetting("ppc64.lift.fidelity", R"({
+		"title" : "Lifting fidelity",
+		"type" : "string",
+		"default" : "precise",
+		"enum" : ["precise", "fast"],
+		"enumDescriptions" : [
+			"Model summary overflow, carry and cache/TLB/barrier instructions.",
+			"Drop XER.SO and cr0.so tracking, lift cache, TLB and barrier instructions to nop, and skip XER.CA writes that the next instructions overwrite unread. For triage of very large images."
+		],
+		"description" : "How much architecture state the lifter models. Takes effect when the view is opened."
+	})");
+	settings->RegisterSetting("ppc64.callStubs.enabled", R"({
+		"title" : "Recognize PLT call stubs",
+		"type" : "boolean",
+		"default" : true,
+		"description" : "Match linker PLT call stubs in executable segments when a view opens, name each one after the import in its PLT slot, and lift its bctr as a tail call through the slot."
+	})");
+	settings->RegisterSetting("ppc64.opd.enabled", R"({
+		"title" : "Read ELFv1 function descriptors",
+		"type" : "boolean",
+		"default" : true,
+		"description" : "Read every .opd descriptor when a view opens, create functions at the code entries they point to and seed r2 with each function's TOC."
+	})");
+	settings->RegisterSetting("ppc64.elfv2.foldEntries", R"({
+		"title" : "Fold ELFv2 local entry points",
+		"type" : "boolean",
+		"default" : true,
+		"description" : "Find ELFv2 global entry prologues (addis r2,r12 / addi r2,r2) when a view opens and treat calls to the local entry 8 bytes in as calls to the global entry, so each function is analyzed once."
+	})");
+	settings->RegisterSetting("ppc64.classify.enabled", R"({
+		"title" : "Mark data in code segments",
+		"type" : "boolean",
+		"default" : false,
+		"description" : "Score executable segments word by word when a view opens and define runs that do not look like code (invalid or reserved encodings, implausible register writes) as data, so analysis does not sweep into them."
+	})");
+}
+
+static ThreadPool *PredecodePool() {
+	// Never destroyed: jobs may still be queued when the process exits.
+	static ThreadPool *pool = new ThreadPool(std::thread::hardware_concurrency(), true);
+	return pool;
+}
+
+static std::string IndexDirectory() {
+	const char *dir = getenv("BN_PPC64_INDEX_DIR");
+	if (dir && *dir)
+		return dir;
+	return GetUserDirectory() + "/ppc64-index";
+}
+
+// Jobs hold the segment bytes, not the view, and stop once it closes.
+static void Predecode(std::shared_ptr<PpcViewState> state, std::shared_ptr<const DataBuffer> bytes, uint64_t start) {
+	auto region = std::make_shared<HeapRegion>(start, bytes->GetLength() / 4);
+	if (!state->AddRegion(region))
+		return;
+	std::weak_ptr<PpcViewState> owner = state;
+	for (uint64_t first = 0; first < region->count; first += PREDECODE_CHUNK_WORDS) {
+		uint64_t n = std::min<uint64_t>(PREDECODE_CHUNK_WORDS, region->count - first);
+		PredecodePool()->Enqueue([owner, bytes, region, first, n]() {
+			auto state = owner.lock();
+			if (!state || state->Closed())
+				return;
+			region->Fill(first, (const uint8_t *)bytes->GetData() + first * 4, n);
+		});
+	}
+}
+
+static void WarmDecodeCache(BinaryView *view, std::shared_ptr<PpcViewState> state, bool useIndex, bool predecode) {
+	std::string dir = IndexDirectory();
+	for (auto &seg : view->GetSegments()) {
+		if (state->Closed())
+			return;
+		if (!(seg->GetFlags() & SegmentExecutable))
+			continue;
+		auto buf = std::make_shared<const DataBuffer>(view->ReadBuffer(seg->GetStart(), seg->GetLength()));
+		if (useIndex) {
+			auto region = DecodeIndex::Open(dir, (const uint8_t *)buf->GetData(), buf->GetLength(), seg->GetStart());
+			if (region) {
+				state->AddRegion(region);
+				continue;
+			}
+			LogWarn("ppc64: could not open decode index for segment at 0x%llx", (unsigned long long)seg->GetStart());
+		}
+		if (predecode)
+			Predecode(state, buf, seg->GetStart());
+	}
+}
+
+void PpcIngestOpd(BinaryView *view, PpcViewState &state) {
+	Ref<Section> opd = view->GetSectionByName(".opd");
+	if (!opd)
+		return;
+	DataBuffer buf = view->ReadBuffer(opd->GetStart(), opd->GetLength());
+	std::vector<PpcFunctionEntry> entries;
+	PpcParseOpd((const uint8_t *)buf.GetData(), buf.GetLength(), entries);
+
+	Ref<Platform> platform = view->GetDefaultPlatform();
+	size_t created = 0;
+	for (size_t i = 0; i < entries.size(); i++) {
+		const PpcFunctionEntry &e = entries[i];
+		uint64_t desc = opd->GetStart() + i * OPD_DESCRIPTOR_SIZE;
+		if ((e.global & 3) || !view->IsOffsetExecutable(e.global))
+			continue;
+		state.toc.SetEntryToc(e.global, e.toc);
+		// Symbols name the descriptor; move the function and name to the code
+		for (auto &func : view->GetAnalysisFunctionsForAddress(desc))
+			view->RemoveAnalysisFunction(func);
+		Ref<Symbol> sym = view->GetSymbolByAddress(desc);
+		if (sym && !view->GetSymbolByAddress(e.global))
+			view->DefineAutoSymbol(new Symbol(FunctionSymbol, sym->GetShortName(), e.global));
+		view->AddFunctionForAnalysis(platform, e.global);
+		created++;
+	}
+	LogInfo("ppc64: %zu functions from .opd descriptors", created);
+}
+
+void PpcFoldLocalEntries(BinaryView *view, PpcViewState &state) {
+	size_t found = 0;
+	for (auto &seg : view->GetSegments()) {
+		if (!(seg->GetFlags() & SegmentExecutable))
+			continue;
+		DataBuffer buf = view->ReadBuffer(seg->GetStart(), seg->GetLength());
+		std::vector<PpcFunctionEntry> entries;
+		PpcFindGlobalEntries((const uint8_t *)buf.GetData(), buf.GetLength(), seg->GetStart(), entries);
+		for (auto &entry : entries)
+			state.toc.AddGlobalEntry(entry);
+		state.toc.AddFoldRange(seg->GetStart(), seg->GetEnd());
+		found += entries.size();
+	}
+	if (found)
+		LogInfo("ppc64: folding %zu ELFv2 local entry points", found);
+}
+
+// r2 as set up by the loader: .TOC. if present, else .got + 0x8000
+static bool FindToc(BinaryView *view, uint64_t &toc) {
+	Ref<Symbol> sym = view->GetSymbolByRawName(".TOC.");
+	if (sym) {
+		toc = sym->GetAddress();
+		return true;
+	}
+	Ref<Section> got = view->GetSectionByName(".got");
+	if (!got)
+		return false;
+	toc = got->GetStart() + 0x8000;
+	return true;
+}
+
+void PpcRecognizeCallStubs(BinaryView *view, PpcViewState &state) {
+	uint64_t toc;
+	if (!FindToc(view, toc))
+		return;
+	Ref<Platform> platform = view->GetDefaultPlatform();
+	size_t found = 0, named = 0;
+	for (auto &seg : view->GetSegments()) {
+		if (!(seg->GetFlags() & SegmentExecutable))
+			continue;
+		DataBuffer buf = view->ReadBuffer(seg->GetStart(), seg->GetLength());
+		std::vector<PpcCallStub> stubs;
+		PpcFindCallStubs((const uint8_t *)buf.GetData(), buf.GetLength(), seg->GetStart(), toc, stubs);
+		for (auto &stub : stubs) {
+			state.stubs.Add(stub);
+			found++;
+			Ref<Symbol> import = view->GetSymbolByAddress(stub.slot);
+			if (!import || import->GetType() != ImportAddressSymbol || view->GetSymbolByAddress(stub.start))
+				continue;
+			// Named like the stubs of other ELF targets, so callers see
+			// a call to the import
+			view->DefineAutoSymbol(new Symbol(ImportedFunctionSymbol, import->GetShortName(), stub.start));
+			view->AddFunctionForAnalysis(platform, stub.start);
+			named++;
+		}
+	}
+	LogInfo("ppc64: found %zu PLT call stubs, %zu resolved to imports", found, named);
+}
+
+// Runs fn on its own thread behind a cancellable progress task, so long
+// commands do not block the thread they were started from.
+static void RunTask(const std::string &title, std::function<void(BackgroundTask *)> fn) {
+	Ref<BackgroundTask> task = new BackgroundTask(title, true);
+	std::thread([task, fn]() {
+		fn(task);
+		task->Finish();
+	}).detach();
+}
+
+static bool HasFunctionSymbol(BinaryView *view, const PpcRegion &r) {
+	for (auto &sym : view->GetSymbols(r.start, r.end - r.start))
+		if (sym->GetType() == FunctionSymbol || sym->GetType() == ImportedFunctionSymbol)
+			return true;
+	return false;
+}
+
+// task is null when run during view load
+static void MarkDataRegions(BinaryView *view, BackgroundTask *task) {
+	Ref<Type> word = Type::IntegerType(4, false);
+	size_t regions = 0;
+	uint64_t bytes = 0;
+	for (auto &seg : view->GetSegments()) {
+		if (task && task->IsCancelled())
+			break;
+		if (!(seg->GetFlags() & SegmentExecutable))
+			continue;
+		if (task) {
+			char progress[64];
+			snprintf(progress, sizeof(progress), "ppc64: classifying 0x%llx", (unsigned long long)seg->GetStart());
+			task->SetProgressText(progress);
+		}
+		DataBuffer buf = view->ReadBuffer(seg->GetStart(), seg->GetLength());
+		std::vector<PpcRegion> found;
+		PpcClassifyRange((const uint8_t *)buf.GetData(), buf.GetLength(), seg->GetStart(), found);
+		for (auto &r : found) {
+			if (r.code)
+				continue;
+			// Leave anything a symbol or function already claims alone
+			if (!view->GetAnalysisFunctionsContainingAddress(r.start).empty() || HasFunctionSymbol(view, r))
+				continue;
+			view->DefineDataVariable(r.start, Type::ArrayType(word, (r.end - r.start) / 4));
+			regions++;
+			bytes += r.end - r.start;
+		}
+	}
+	LogInfo("ppc64: marked %zu data regions (%llu bytes) in executable segments%s", regions, (unsigned long long)bytes,
+		task && task->IsCancelled() ? " before being cancelled" : "");
+}
+
+void PpcMarkDataRegions(BinaryView *view) {
+	Ref<BinaryView> ref = view;
+	RunTask("ppc64: marking data regions", [ref](BackgroundTask *task) { MarkDataRegions(ref, task); });
+}
+
+void PpcViewInit(BinaryView *view) {
+	Ref<Architecture> arch = view->GetDefaultArchitecture();
+	if (!arch || arch->GetName() != "ppc64")
+		return;
+
+	auto state = PpcViewState::Open(view);
+	Ref<Settings> settings = Settings::Instance();
+	bool fast = settings->Get<std::string>("ppc64.lift.fidelity", view) == "fast";
+	state->fidelity.store(fast ? LiftFidelity::Fast : LiftFidelity::Precise);
+
+	// Before any call is lifted
+	if (settings->Get<bool>("ppc64.opd.enabled", view))
+		PpcIngestOpd(view, *state);
+	if (settings->Get<bool>("ppc64.elfv2.foldEntries", view))
+		PpcFoldLocalEntries(view, *state);
+	if (settings->Get<bool>("ppc64.callStubs.enabled", view))
+		PpcRecognizeCallStubs(view, *state);
+	// Before the decode cache warms, so that data regions are in place
+	// when analysis first reaches them
+	if (settings->Get<bool>("ppc64.classify.enabled", view))
+		MarkDataRegions(view, nullptr);
+
+	bool useIndex = settings->Get<bool>("ppc64.decodeIndex.enabled", view);
+	bool predecode = settings->Get<bool>("ppc64.predecode.enabled", view);
+	if (!useIndex && !predecode)
+		return;
+
+	// The view is only read while this job runs
+	Ref<BinaryView> ref = view;
+	WorkerEnqueue([ref, state, useIndex, predecode]() { WarmDecodeCache(ref, state, useIndex, predecode); }, "ppc64 decode cache");
+}
+
+static const char *EmuStatusName(EmuStatus status) {
+	switch (status) {
+		case EmuStatus::Running: return "running";
+		case EmuStatus::Stopped: return "returned";
+		case EmuStatus::InstructionLimit: return "instruction limit reached";
+		case EmuStatus::MemoryFault: return "memory fault";
+		case EmuStatus::InvalidInstruction: return "invalid instruction";
+		case EmuStatus::Unimplemented: return "unimplemented instruction";
+		case EmuStatus::SystemCall: return "system call";
+		case EmuStatus::Trap: return "trap";
+		default: return "unknown";
+	}
+}
+
+void PpcEmulateAt(BinaryView *view, uint64_t addr) {
+	int64_t limit = 100000000;
+	if (!GetIntegerInput(limit, "Instruction limit", "Emulate from here") || limit <= 0)
+		return;
+
+	Ref<BinaryView> ref = view;
+	RunTask("ppc64: emulating", [ref, addr, limit](BackgroundTask *task) {
+		PpcEmulator emu;
+		for (auto &seg : ref->GetSegments()) {
+			DataBuffer buf = ref->ReadBuffer(seg->GetStart(), seg->GetLength());
+			emu.mem.Write(seg->GetStart(), buf.GetData(), buf.GetLength());
+			// Zero-filled tail (.bss)
+			emu.mem.Map(seg->GetStart(), seg->GetLength());
+		}
+		emu.mem.Map(EMU_STACK_TOP - EMU_STACK_SIZE, EMU_STACK_SIZE);
+		emu.cpu.gpr[1] = EMU_STACK_TOP - 256;
+		// As at a call: r12 holds the entry (ELFv2 global entries derive r2
+		// from it) and r2 the TOC from the descriptor or the loader
+		emu.cpu.gpr[12] = addr;
+		uint64_t toc;
+		auto state = PpcViewState::Find(ref->GetObject());
+		if ((state && state->toc.EntryToc(addr, toc)) || FindToc(ref, toc))
+			emu.cpu.gpr[2] = toc;
+		emu.cpu.lr = EMU_RETURN_ADDR;
+		emu.cpu.pc = addr;
+
+		auto start = std::chrono::steady_clock::now();
+		EmuStatus status;
+		do {
+			uint64_t slice = std::min<uint64_t>(EMU_SLICE, limit - emu.executed);
+			status = emu.Run(EMU_RETURN_ADDR, slice);
+			task->SetProgressText("ppc64: emulating, " + std::to_string(emu.executed) + " instructions");
+		} while (status == EmuStatus::InstructionLimit && emu.executed < (uint64_t)limit && !task->IsCancelled());
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		LogInfo("ppc64 emulator: %s at 0x%llx after %llu instructions (%.1f MIPS)",
+			task->IsCancelled() ? "cancelled" : EmuStatusName(status), (unsigned long long)emu.cpu.pc,
+			(unsigned long long)emu.executed, secs > 0 ? emu.executed / secs / 1e6 : 0.0);
+		if (status == EmuStatus::MemoryFault)
+			LogInfo("ppc64 emulator: fault address 0x%llx", (unsigned long long)emu.faultAddr);
+		for (int i = 3; i <= 10; i++)
+			LogInfo("ppc64 emulator: r%d = 0x%llx", i, (unsigned long long)emu.cpu.gpr[i]);
+	});
+}
+
+bool PpcAssemblePatches(const std::string &script, std::vector<PpcPatch> &patches, std::string &errors) {
+	std::istringstream in(script);
+	std::string line;
+	unsigned lineNo = 0;
+	while (std::getline(in, line)) {
+		lineNo++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.resize(comment);
+		size_t colon = line.find(':');
+		if (colon == std::string::npos) {
+			if (line.find_first_not_of(" \t\r") != std::string::npos)
+				errors += "line " + std::to_string(lineNo) + ": expected 'address: instructions'\n";
+			continue;
+		}
+		char *end;
+		std::string addrText = line.substr(0, colon);
+		uint64_t addr = strtoull(addrText.c_str(), &end, 16);
+		if (end == addrText.c_str()) {
+			errors += "line " + std::to_string(lineNo) + ": bad address '" + addrText + "'\n";
+			continue;
+		}
+		PpcPatch patch;
+		patch.addr = addr;
+		std::istringstream insns(line.substr(colon + 1));
+		std::string text, error;
+		bool ok = true;
+		while (ok && std::getline(insns, text, ';')) {
+			if (text.find_first_not_of(" \t\r") == std::string::npos)
+				continue;
+			uint32_t inst;
+			ok = PpcAssembler::AssembleOne(text, addr + patch.bytes.size(), inst, error);
+			if (ok) {
+				patch.bytes.resize(patch.bytes.size() + 4);
+				WriteInstruction(&patch.bytes[patch.bytes.size() - 4], inst);
+			}
+		}
+		if (!ok) {
+			errors += "line " + std::to_string(lineNo) + ": " + error + "\n";
+			continue;
+		}
+		patches.push_back(std::move(patch));
+	}
+	return errors.empty();
+}
+
+void PpcApplyPatchFile(BinaryView *view) {
+	std::string path;
+	if (!GetOpenFileNameInput(path, "Patch file"))
+		return;
+	std::ifstream f(path);
+	if (!f) {
+		LogError("ppc64: cannot read %s", path.c_str());
+		return;
+	}
+	std::stringstream script;
+	script << f.rdbuf();
+
+	// Everything is assembled before anything is written, so a bad line
+	// leaves the view untouched.
+	auto start = std::chrono::steady_clock::now();
+	std::vector<PpcPatch> patches;
+	std::string errors;
+	if (!PpcAssemblePatches(script.str(), patches, errors)) {
+		LogError("ppc64: patch file not applied:\n%s", errors.c_str());
+		return;
+	}
+	size_t words = 0;
+	for (auto &p : patches) {
+		view->Write(p.addr, p.bytes.data(), p.bytes.size());
+		words += p.bytes.size() / 4;
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	LogInfo("ppc64: applied %zu patches (%zu instructions) in %.1f ms", patches.size(), words, secs * 1e3);
+}
+
+void PpcExportDisassembly(BinaryView *view) {
+	std::string path;
+	if (!GetSaveFileNameInput(path, "Disassembly output", "*.txt;*.jsonl", "disassembly.txt"))
+		return;
+	bool jsonl = path.size() >= 6 && path.compare(path.size() - 6, 6, ".jsonl") == 0;
+
+	Ref<BinaryView> ref = view;
+	RunTask("ppc64: exporting disassembly", [ref, path, jsonl](BackgroundTask *task) {
+		FILE *f = fopen(path.c_str(), "wb");
+		if (!f) {
+			LogError("ppc64: cannot write %s", path.c_str());
+			return;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		bool ok = true;
+		for (auto &seg : ref->GetSegments()) {
+			if (!(seg->GetFlags() & SegmentExecutable))
+				continue;
+			DataBuffer buf = ref->ReadBuffer(seg->GetStart(), seg->GetLength());
+			const uint8_t *data = (const uint8_t *)buf.GetData();
+			size_t len = buf.GetLength() & ~3ull;
+			// One export per segment, so the pool stays busy across it
+			ok = PpcExportText(data, len, seg->GetStart(), jsonl ? TextFormat::Jsonl : TextFormat::Objdump, f,
+				[task](uint64_t reached) {
+					char progress[64];
+					snprintf(progress, sizeof(progress), "ppc64: exporting disassembly at 0x%llx", (unsigned long long)reached);
+					task->SetProgressText(progress);
+					return !task->IsCancelled();
+				});
+			if (!ok || task->IsCancelled())
+				break;
+		}
+		long size = ftell(f);
+		ok = fclose(f) == 0 && ok;
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (!ok)
+			LogError("ppc64: error writing %s", path.c_str());
+		else if (task->IsCancelled())
+			LogWarn("ppc64: disassembly export cancelled, %s is incomplete", path.c_str());
+		else
+			LogInfo("ppc64: wrote %ld bytes of disassembly in %.2f s (%.0f MB/s)", size, secs, secs > 0 ? size / secs / 1e6 : 0.0);
+	});
+}
+
+static const char *BranchKindName(PpcBranchKind kind) {
+	switch (kind) {
+		case PpcBranchKind::Jump: return "jump";
+		case PpcBranchKind::Conditional: return "conditional";
+		case PpcBranchKind::Call: return "call";
+		case PpcBranchKind::ConditionalCall: return "conditional_call";
+		case PpcBranchKind::Return: return "return";
+		case PpcBranchKind::ConditionalReturn: return "conditional_return";
+		case PpcBranchKind::Indirect: return "indirect";
+		case PpcBranchKind::ConditionalIndirect: return "conditional_indirect";
+		case PpcBranchKind::IndirectCall: return "indirect_call";
+		default: return "unknown";
+	}
+}
+
+void PpcExportBranchGraph(BinaryView *view) {
+	std::string path;
+	if (!GetSaveFileNameInput(path, "Branch graph output", "*.jsonl", "ppc64-branches.jsonl"))
+		return;
+
+	Ref<BinaryView> ref = view;
+	RunTask("ppc64: exporting branch graph", [ref, path](BackgroundTask *task) {
+		FILE *f = fopen(path.c_str(), "wb");
+		if (!f) {
+			LogError("ppc64: cannot write %s", path.c_str());
+			return;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		size_t edges = 0, sites = 0;
+		for (auto &seg : ref->GetSegments()) {
+			if (task->IsCancelled())
+				break;
+			if (!(seg->GetFlags() & SegmentExecutable))
+				continue;
+			char progress[64];
+			snprintf(progress, sizeof(progress), "ppc64: scanning branches at 0x%llx", (unsigned long long)seg->GetStart());
+			task->SetProgressText(progress);
+			DataBuffer buf = ref->ReadBuffer(seg->GetStart(), seg->GetLength());
+			PpcBranchGraph graph;
+			PpcBuildBranchGraph((const uint8_t *)buf.GetData(), buf.GetLength(), seg->GetStart(), graph);
+			for (size_t i = 0; i < graph.source.size(); i++)
+				fprintf(f, "{\"source\":%llu,\"target\":%llu,\"kind\":\"%s\",\"fallthrough\":%s}\n",
+					(unsigned long long)graph.source[i], (unsigned long long)graph.target[i],
+					BranchKindName(graph.kind[i]), PpcFallsThrough(graph.kind[i]) ? "true" : "false");
+			for (size_t i = 0; i < graph.indirectSource.size(); i++)
+				fprintf(f, "{\"source\":%llu,\"kind\":\"%s\",\"fallthrough\":%s}\n",
+					(unsigned long long)graph.indirectSource[i], BranchKindName(graph.indirectKind[i]),
+					PpcFallsThrough(graph.indirectKind[i]) ? "true" : "false");
+			edges += graph.source.size();
+			sites += graph.indirectSource.size();
+		}
+		bool ok = fclose(f) == 0;
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (!ok)
+			LogError("ppc64: error writing %s", path.c_str());
+		else if (task->IsCancelled())
+			LogWarn("ppc64: branch graph export cancelled, %s is incomplete", path.c_str());
+		else
+			LogInfo("ppc64: wrote %zu direct branches and %zu indirect sites in %.2f s", edges, sites, secs);
+	});
+}
+
+void PpcExportFunctionHashes(BinaryView *view) {
+	std::string path;
+	if (!GetSaveFileNameInput(path, "Function hash output", "*.jsonl", "ppc64-hashes.jsonl"))
+		return;
+
+	Ref<BinaryView> ref = view;
+	RunTask("ppc64: exporting function hashes", [ref, path](BackgroundTask *task) {
+		FILE *f = fopen(path.c_str(), "wb");
+		if (!f) {
+			LogError("ppc64: cannot write %s", path.c_str());
+			return;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		// Each function's blocks in address order, so block layout changes
+		// between builds do not change the stream
+		std::vector<Ref<Function>> funcs;
+		std::vector<std::vector<uint8_t>> bodies;
+		auto list = ref->GetAnalysisFunctionList();
+		for (size_t n = 0; n < list.size() && !task->IsCancelled(); n++) {
+			if (n % 1024 == 0)
+				task->SetProgressText("ppc64: reading functions, " + std::to_string(n) + " of " + std::to_string(list.size()));
+			Ref<Function> func = list[n];
+			if (func->GetArchitecture()->GetName() != "ppc64")
+				continue;
+			auto blocks = func->GetBasicBlocks();
+			std::sort(blocks.begin(), blocks.end(), [](const Ref<BasicBlock> &x, const Ref<BasicBlock> &y) {
+				return x->GetStart() < y->GetStart();
+			});
+			std::vector<uint8_t> body;
+			for (auto &block : blocks) {
+				DataBuffer buf = ref->ReadBuffer(block->GetStart(), block->GetEnd() - block->GetStart());
+				const uint8_t *p = (const uint8_t *)buf.GetData();
+				body.insert(body.end(), p, p + buf.GetLength());
+			}
+			funcs.push_back(func);
+			bodies.push_back(std::move(body));
+		}
+		if (task->IsCancelled()) {
+			fclose(f);
+			LogWarn("ppc64: function hash export cancelled, %s is incomplete", path.c_str());
+			return;
+		}
+
+		task->SetProgressText("ppc64: hashing " + std::to_string(funcs.size()) + " functions");
+		std::vector<PpcCodeSpan> spans;
+		for (auto &body : bodies)
+			spans.push_back({body.data(), body.size()});
+		std::vector<PpcFunctionHash> hashes;
+		PpcHashFunctions(spans, hashes);
+
+		for (size_t i = 0; i < funcs.size(); i++) {
+			const PpcFunctionHash &h = hashes[i];
+			std::string minhash, bands;
+			char buf[24];
+			for (size_t k = 0; k < FUNCHASH_MINHASH; k++) {
+				snprintf(buf, sizeof(buf), "%08x", h.minhash[k]);
+				minhash += buf;
+			}
+			for (size_t k = 0; k < FUNCHASH_BANDS; k++) {
+				snprintf(buf, sizeof(buf), "%s\"%016llx\"", k ? "," : "", (unsigned long long)h.bands[k]);
+				bands += buf;
+			}
+			fprintf(f, "{\"address\":%llu,\"name\":%s,\"words\":%u,\"exact\":\"%016llx\",\"minhash\":\"%s\",\"bands\":[%s]}\n",
+				(unsigned long long)funcs[i]->GetStart(), PpcJsonString(funcs[i]->GetSymbol()->GetFullName()).c_str(),
+				h.words, (unsigned long long)h.exact, minhash.c_str(), bands.c_str());
+		}
+		bool ok = fclose(f) == 0;
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (!ok)
+			LogError("ppc64: error writing %s", path.c_str());
+		else
+			LogInfo("ppc64: hashed %zu functions in %.2f s", funcs.size(), secs);
+	});
+}
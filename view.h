@@ -0,0 +1,81 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <binaryninjaapi.h>
+
+#include <string>
+#include <vector>
+
+using namespace BinaryNinja;
+
+class PpcViewState;
+
+void PpcRegisterViewSettings();
+
+// Called when a view finishes loading; does nothing for non-ppc64 views.
+void PpcViewInit(BinaryView *view);
+
+// Creates functions at the entries of ELFv1 .opd descriptors and records
+// their TOC pointers in the view state for the lifter.
+void PpcIngestOpd(BinaryView *view, PpcViewState &state);
+
+// Registers the ELFv2 global entries of executable segments with the view
+// state, so calls to their local entries fold into them.
+void PpcFoldLocalEntries(BinaryView *view, PpcViewState &state);
+
+// Finds PLT call stubs, registers them with the view's lifter state and
+// names the ones whose slot holds an import.
+void PpcRecognizeCallStubs(BinaryView *view, PpcViewState &state);
+
+// Classifies executable segments and defines the runs that look like data
+// as arrays of words. Runs as a background task that can be cancelled.
+void PpcMarkDataRegions(BinaryView *view);
+
+// Runs the emulator from addr over a copy of the view's segments until the
+// routine returns, and logs the result registers. Runs as a background
+// task that can be cancelled.
+void PpcEmulateAt(BinaryView *view, uint64_t addr);
+
+struct PpcPatch {
+	uint64_t addr;
+	std::vector<uint8_t> bytes;
+};
+
+// Assembles a patch script of "address: instructions" lines (hex address,
+// instructions separated by ';'). Returns false with every failing line
+// listed in errors.
+bool PpcAssemblePatches(const std::string &script, std::vector<PpcPatch> &patches, std::string &errors);
+
+// Prompts for a patch script and applies it to the view if all of it
+// assembles.
+void PpcApplyPatchFile(BinaryView *view);
+
+// Writes the disassembly of every executable segment to a file chosen by
+// the user: JSONL for a .jsonl name, objdump-style text otherwise. Runs
+// as a background task that can be cancelled.
+void PpcExportDisassembly(BinaryView *view);
+
+// Writes the direct branches and indirect branch sites of every executable
+// segment as JSONL (see branchgraph.h), without waiting for analysis. Runs
+// as a background task that can be cancelled.
+void PpcExportBranchGraph(BinaryView *view);
+
+// Writes relocation-masked exact and MinHash signatures of every ppc64
+// function as JSONL, for matching against another build with
+// ppc64-funcmatch (see funchash.h).
+void PpcExportFunctionHashes(BinaryView *view);
@@ -0,0 +1,138 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "viewstate.h"
+
+#include <unordered_map>
+#include <vector>
+
+static std::mutex statesLock;
+static std::unordered_map<BNBinaryView *, std::shared_ptr<PpcViewState>> states;
+// Bumped whenever states changes, so Lookup caches can be revalidated
+static std::atomic<uint32_t> statesGeneration(1);
+
+PpcViewState::~PpcViewState() {
+	DecodeCache::RemoveRegions(this);
+}
+
+bool PpcViewState::AddRegion(std::shared_ptr<DecodeRegion> region) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (closed)
+		return false;
+	DecodeCache::AddRegion(this, std::move(region));
+	return true;
+}
+
+bool PpcViewState::Closed() {
+	std::lock_guard<std::mutex> guard(lock);
+	return closed;
+}
+
+/*
+ * Keeps cached records in sync with patches. Records are also checked
+ * against the instruction word on every lookup, so this only serves to
+ * keep the cache warm; it is not needed for correctness.
+ */
+void PpcViewState::OnBinaryDataWritten(BinaryView *view, uint64_t offset, size_t len) {
+	uint64_t start = offset & ~3ull;
+	uint64_t end = (offset + len + 3) & ~3ull;
+	DataBuffer buf = view->ReadBuffer(start, end - start);
+	DecodeCache::Update(this, start, (const uint8_t *)buf.GetData(), buf.GetLength() & ~3ull);
+}
+
+void PpcViewState::OnBinaryViewClosed(BinaryView *view) {
+	view->UnregisterNotification(this);
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		closed = true;
+		DecodeCache::RemoveRegions(this);
+	}
+	std::shared_ptr<PpcViewState> self;
+	{
+		std::lock_guard<std::mutex> guard(statesLock);
+		auto it = states.find(view->GetObject());
+		if (it != states.end() && it->second.get() == this) {
+			self = std::move(it->second);
+			states.erase(it);
+			statesGeneration.fetch_add(1, std::memory_order_release);
+		}
+	}
+	// The core is still inside this callback, so the last reference is
+	// dropped on a worker instead of here.
+	if (self)
+		WorkerEnqueue([self]() {}, "ppc64 view state");
+}
+
+std::shared_ptr<PpcViewState> PpcViewState::Open(BinaryView *view) {
+	auto state = std::make_shared<PpcViewState>();
+	{
+		std::lock_guard<std::mutex> guard(statesLock);
+		states[view->GetObject()] = state;
+		statesGeneration.fetch_add(1, std::memory_order_release);
+	}
+	view->RegisterNotification(state.get());
+	return state;
+}
+
+std::shared_ptr<PpcViewState> PpcViewState::Find(BNBinaryView *view) {
+	std::lock_guard<std::mutex> guard(statesLock);
+	auto it = states.find(view);
+	return it == states.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<PpcViewState> PpcViewState::Lookup(BNBinaryView *view) {
+	// A weak reference, so a thread that stops lifting does not keep a
+	// closed view's state alive
+	thread_local BNBinaryView *lastView = nullptr;
+	thread_local uint32_t lastGeneration = 0;
+	thread_local std::weak_ptr<PpcViewState> last;
+	uint32_t generation = statesGeneration.load(std::memory_order_acquire);
+	if (view == lastView && generation == lastGeneration)
+		return last.lock();
+
+	std::shared_ptr<PpcViewState> state = Find(view);
+	lastView = view;
+	lastGeneration = generation;
+	last = state;
+	return state;
+}
+
+uint64_t PpcViewState::FoldCall(uint64_t site, uint64_t dst) {
+	thread_local uint32_t lastGeneration = 0;
+	thread_local std::vector<std::weak_ptr<PpcViewState>> open;
+	uint32_t generation = statesGeneration.load(std::memory_order_acquire);
+	if (generation != lastGeneration) {
+		std::lock_guard<std::mutex> guard(statesLock);
+		open.clear();
+		for (auto &it : states)
+			open.push_back(it.second);
+		lastGeneration = generation;
+	}
+
+	uint64_t folded = dst;
+	bool found = false;
+	for (auto &weak : open) {
+		auto state = weak.lock();
+		if (!state || !state->toc.Covers(site))
+			continue;
+		// Two open views map the call site; neither can claim it
+		if (found)
+			return dst;
+		found = true;
+		folded = state->toc.Fold(dst);
+	}
+	return folded;
+}
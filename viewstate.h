@@ -0,0 +1,68 @@
+/* 
+ * Copyright (C) 2024 yanchan09
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License as published by the Free 
+ * Software Foundation, version 3.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <binaryninjaapi.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "decode_cache.h"
+#include "il.h"
+#include "stubs.h"
+#include "toc.h"
+
+using namespace BinaryNinja;
+
+/*
+ * Plugin state that belongs to one view. It is created when the view
+ * finishes loading and dropped when the view closes, so nothing the
+ * plugin learned about one binary outlives it or leaks into another view
+ * at the same addresses. The state is also the view's data notification.
+ */
+class PpcViewState : public BinaryDataNotification, public std::enable_shared_from_this<PpcViewState> {
+private:
+	std::mutex lock;
+	bool closed = false;
+public:
+	// From the "ppc64.lift.fidelity" setting
+	std::atomic<LiftFidelity> fidelity{LiftFidelity::Precise};
+	CallStubTable stubs;
+	TocTable toc;
+
+	virtual ~PpcViewState();
+
+	// Registers region with the decode cache on behalf of this view.
+	// Returns false once the view has closed.
+	bool AddRegion(std::shared_ptr<DecodeRegion> region);
+	bool Closed();
+
+	virtual void OnBinaryDataWritten(BinaryView *view, uint64_t offset, size_t len) override;
+	virtual void OnBinaryViewClosed(BinaryView *view) override;
+
+	// Creates the state for view and registers it for notifications.
+	static std::shared_ptr<PpcViewState> Open(BinaryView *view);
+	static std::shared_ptr<PpcViewState> Find(BNBinaryView *view);
+	// Find for architecture callbacks. Each thread remembers the last view
+	// it asked for until a view opens or closes.
+	static std::shared_ptr<PpcViewState> Lookup(BNBinaryView *view);
+	// The call destination for a call at site to dst, for the instruction
+	// info callback, which has no view: dst folded by the TOC table of the
+	// one open view whose searched segments contain site.
+	static uint64_t FoldCall(uint64_t site, uint64_t dst);
+};